@@ -0,0 +1,239 @@
+#include "SyntheticScannerTarget.h"
+
+#include "XenoScanEngine/StdListBlueprint.h"
+#include "XenoScanEngine/StdMapBlueprint.h"
+#include "XenoScanEngine/StdVectorBlueprint.h"
+#include "XenoScanEngine/StdUnorderedMapBlueprint.h"
+#include "XenoScanEngine/NativeClassInstanceBlueprint.h"
+
+#include <set>
+#include <chrono>
+#include <thread>
+#include <cstring>
+
+
+SyntheticScannerTarget::Options::Options() :
+	regionCount(64), regionSize(0x100000), littleEndian(true), directPointers(false), readMicrosecondsPerMegabyte(0), seed(1)
+{
+}
+
+SyntheticScannerTarget::SyntheticScannerTarget(const Options &options) :
+	options(options), random(options.seed)
+{
+	this->supportedBlueprints.insert(StdListBlueprint::Key);
+	this->supportedBlueprints.insert(StdMapBlueprint::Key);
+	this->supportedBlueprints.insert(StdVectorBlueprint::Key);
+	this->supportedBlueprints.insert(StdUnorderedMapBlueprint::Key);
+	this->supportedBlueprints.insert(NativeClassInstanceBlueprint::Key);
+
+	// pointers have to look like ours, since the blueprints read them as MemoryAddress
+	this->littleEndian = options.littleEndian;
+	this->pointerSize = sizeof(MemoryAddress);
+
+	// every region gets at least one empty RegionAlignment after it
+	this->regionStride = ((options.regionSize + RegionAlignment - 1) / RegionAlignment + 1) * RegionAlignment;
+	this->regions.resize(options.regionCount);
+	for (auto region = this->regions.begin(); region != this->regions.end(); region++)
+		region->resize(options.regionSize);
+
+	this->lowestAddress = (MemoryAddress)RegionBase;
+	this->highestAddress = (MemoryAddress)(RegionBase + this->regionStride * options.regionCount);
+
+	this->randomize();
+}
+
+void SyntheticScannerTarget::randomize()
+{
+	for (auto region = this->regions.begin(); region != this->regions.end(); region++)
+	{
+		auto words = region->size() / sizeof(uint64_t);
+		auto data = &(*region)[0];
+		for (size_t i = 0; i < words; i++)
+		{
+			auto value = this->random();
+			memcpy(&data[i * sizeof(uint64_t)], &value, sizeof(value));
+		}
+		for (size_t i = words * sizeof(uint64_t); i < region->size(); i++)
+			data[i] = (uint8_t)this->random();
+	}
+}
+
+MemoryAddress SyntheticScannerTarget::randomAddress(const size_t &size, const size_t &alignment)
+{
+	auto slots = (this->options.regionSize - size) / alignment + 1;
+	auto region = this->random() % this->regions.size();
+	auto slot = this->random() % slots;
+	return (MemoryAddress)(RegionBase + region * this->regionStride + slot * alignment);
+}
+
+std::vector<MemoryAddress> SyntheticScannerTarget::plant(const std::vector<uint8_t> &value, const double &density, const size_t &alignment)
+{
+	std::vector<MemoryAddress> planted;
+	if (value.empty() || value.size() > this->options.regionSize || !alignment)
+		return planted;
+
+	auto count = (size_t)(density * (double)(this->getTotalSize() / alignment));
+	planted.reserve(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		auto address = this->randomAddress(value.size(), alignment);
+		this->rawWrite(address, value.size(), &value[0]);
+		planted.push_back(address);
+	}
+	return planted;
+}
+
+size_t SyntheticScannerTarget::buildLists(const size_t &count, const size_t &length)
+{
+	// nodes and roots each get their own slot, so that they never overlap. lists
+	// stop once half of the slots are gone, since finding free ones gets slow
+	const size_t slotSize = 4 * sizeof(MemoryAddress);
+	if (slotSize > this->options.regionSize)
+		return 0;
+	auto slotsLeft = (this->options.regionSize / slotSize) * this->regions.size() / 2;
+
+	std::set<MemoryAddress> used;
+	auto allocate = [this, &used, slotSize]() -> MemoryAddress
+	{
+		while (true)
+		{
+			auto address = this->randomAddress(slotSize, slotSize);
+			if (used.insert(address).second)
+				return address;
+		}
+	};
+
+	size_t list;
+	for (list = 0; list < count && length + 2 <= slotsLeft; list++)
+	{
+		slotsLeft -= length + 2;
+
+		// the first node is the head, which doesn't count towards the size
+		std::vector<MemoryAddress> nodes;
+		for (size_t node = 0; node <= length; node++)
+			nodes.push_back(allocate());
+
+		for (size_t node = 0; node < nodes.size(); node++)
+		{
+			MemoryAddress links[3];
+			links[0] = nodes[(node + 1) % nodes.size()];
+			links[1] = nodes[(node + nodes.size() - 1) % nodes.size()];
+			links[2] = (MemoryAddress)(size_t)node;
+			this->rawWrite(nodes[node], sizeof(links), links);
+		}
+
+		MemoryAddress root[2];
+		root[0] = nodes[0];
+		root[1] = (MemoryAddress)length;
+		this->rawWrite(allocate(), sizeof(root), root);
+	}
+	return list;
+}
+
+uint64_t SyntheticScannerTarget::getTotalSize() const
+{
+	return (uint64_t)this->options.regionCount * this->options.regionSize;
+}
+
+bool SyntheticScannerTarget::attach(const ProcessIdentifier &pid)
+{
+	return true;
+}
+
+bool SyntheticScannerTarget::isAttached() const
+{
+	return true;
+}
+
+bool SyntheticScannerTarget::queryMemory(const MemoryAddress &adr, MemoryInformation& meminfo, MemoryAddress &nextAdr) const
+{
+	// the scanner passes the same address in as adr and nextAdr
+	auto address = (size_t)adr;
+	nextAdr = this->highestAddress;
+	if (address < RegionBase || address >= (size_t)this->highestAddress)
+		return false;
+
+	auto region = (address - RegionBase) / this->regionStride;
+	auto start = RegionBase + region * this->regionStride;
+	if (address >= start + this->options.regionSize)
+	{
+		// in the gap after a region, so the next one is what's left
+		nextAdr = (MemoryAddress)(start + this->regionStride);
+		return false;
+	}
+
+	memset(&meminfo, 0, sizeof(meminfo));
+	meminfo.isCommitted = true;
+	meminfo.isWriteable = true;
+	meminfo.allocationBase = (MemoryAddress)start;
+	meminfo.allocationSize = this->options.regionSize;
+	meminfo.allocationEnd = (MemoryAddress)(start + this->options.regionSize);
+	nextAdr = (MemoryAddress)(start + this->regionStride);
+	return true;
+}
+
+bool SyntheticScannerTarget::isWithinModule(MemoryAddress &start, MemoryAddress &end) const
+{
+	return false;
+}
+
+bool SyntheticScannerTarget::getMainModuleBounds(MemoryAddress &start, MemoryAddress &end) const
+{
+	return false;
+}
+
+uint64_t SyntheticScannerTarget::getFileTime64() const
+{
+	return FileTime;
+}
+
+uint32_t SyntheticScannerTarget::getTickTime32() const
+{
+	return TickTime;
+}
+
+bool SyntheticScannerTarget::getRegionGeneration(uint64_t &generation) const
+{
+	// the regions never change
+	generation = this->regionGeneration;
+	return true;
+}
+
+const uint8_t* SyntheticScannerTarget::getDirectPointer(const MemoryAddress &adr, const size_t &size) const
+{
+	if (!this->options.directPointers)
+		return nullptr;
+	return this->translate(adr, size);
+}
+
+uint8_t* SyntheticScannerTarget::translate(const MemoryAddress &adr, const size_t &size) const
+{
+	if ((size_t)adr < RegionBase || adr >= this->highestAddress)
+		return nullptr;
+
+	auto region = ((size_t)adr - RegionBase) / this->regionStride;
+	auto offset = ((size_t)adr - RegionBase) % this->regionStride;
+	if (offset + size > this->options.regionSize || offset + size < offset)
+		return nullptr;
+	return &this->regions[region][offset];
+}
+
+bool SyntheticScannerTarget::rawRead(const MemoryAddress &adr, const size_t objectSize, void* result) const
+{
+	auto source = this->translate(adr, objectSize);
+	if (!source)
+		return false;
+	if (this->options.readMicrosecondsPerMegabyte)
+		std::this_thread::sleep_for(std::chrono::microseconds((uint64_t)objectSize * this->options.readMicrosecondsPerMegabyte / 0x100000));
+	memcpy(result, source, objectSize);
+	return true;
+}
+
+bool SyntheticScannerTarget::rawWrite(const MemoryAddress &adr, const size_t objectSize, const void* const data) const
+{
+	auto destination = this->translate(adr, objectSize);
+	if (!destination)
+		return false;
+	memcpy(destination, data, objectSize);
+	return true;
+}
\ No newline at end of file
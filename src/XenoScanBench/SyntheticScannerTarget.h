@@ -0,0 +1,88 @@
+#pragma once
+#include <stdint.h>
+#include <random>
+#include <vector>
+
+#include "XenoScanEngine/ScannerTarget.h"
+
+
+// A target that's made up on the spot, out of memory in our own process, so that
+// scans can be benchmarked without another process (or another OS) around. The
+// regions sit at made-up addresses, starting at RegionBase with a gap between
+// each, and are filled with random data. Values can then be planted in them, and
+// pointer graphs (std::list layouts) built across them.
+class SyntheticScannerTarget : public ScannerTarget
+{
+public:
+	struct Options
+	{
+		size_t regionCount, regionSize;
+		bool littleEndian;
+
+		// hand the regions out with getDirectPointer(), like snapshots do,
+		// instead of making the scanner copy them out with reads
+		bool directPointers;
+
+		// makes every read take this long per megabyte, like reads from
+		// another process do, so that there's I/O for scans to overlap
+		uint32_t readMicrosecondsPerMegabyte;
+
+		uint32_t seed;
+
+		Options();
+	};
+
+	static constexpr size_t RegionBase = 0x10000000;
+	static constexpr size_t RegionAlignment = 0x10000;
+
+	SyntheticScannerTarget(const Options &options);
+
+	// fills every region with random data, replacing anything that was planted
+	void randomize();
+
+	// writes value to about density * (size / alignment) random, aligned places. places
+	// can be chosen twice, and can overlap nodes from buildLists(). returns where they went
+	std::vector<MemoryAddress> plant(const std::vector<uint8_t> &value, const double &density, const size_t &alignment);
+
+	// builds circular doubly linked lists, laid out like MSVC's std::list: each
+	// has a root of { pointer to the head node, size } and nodes of { next, prev,
+	// value }, all scattered across the regions. pointers are written in our own
+	// byte order, since that's how the blueprints read them. returns how many were
+	// built, which is fewer than count once they'd take up half of the regions
+	size_t buildLists(const size_t &count, const size_t &length);
+
+	uint64_t getTotalSize() const;
+
+	virtual bool attach(const ProcessIdentifier &pid);
+	virtual bool isAttached() const;
+
+	virtual bool queryMemory(const MemoryAddress &adr, MemoryInformation& meminfo, MemoryAddress &nextAdr) const;
+
+	virtual bool isWithinModule(MemoryAddress &start, MemoryAddress &end) const;
+	virtual bool getMainModuleBounds(MemoryAddress &start, MemoryAddress &end) const;
+
+	virtual uint64_t getFileTime64() const;
+	virtual uint32_t getTickTime32() const;
+
+	virtual bool getRegionGeneration(uint64_t &generation) const;
+	virtual const uint8_t* getDirectPointer(const MemoryAddress &adr, const size_t &size) const;
+
+protected:
+	virtual bool rawRead(const MemoryAddress &adr, const size_t objectSize, void* result) const;
+	virtual bool rawWrite(const MemoryAddress &adr, const size_t objectSize, const void* const data) const;
+
+private:
+	static constexpr uint64_t FileTime = 0x01D0000000000000;
+	static constexpr uint32_t TickTime = 0x00100000;
+
+	Options options;
+	size_t regionStride;
+	std::mt19937_64 random;
+
+	// rawWrite() is const, like it is for every other target
+	mutable std::vector<std::vector<uint8_t>> regions;
+
+	// the memory behind [adr, adr + size), if it's all inside of one region
+	uint8_t* translate(const MemoryAddress &adr, const size_t &size) const;
+	MemoryAddress randomAddress(const size_t &size, const size_t &alignment);
+};
\ No newline at end of file
@@ -0,0 +1,372 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <cstring>
+#include <chrono>
+#include <thread>
+#include <functional>
+
+#include "SyntheticScannerTarget.h"
+
+#include "XenoScanEngine/Scanner.h"
+#include "XenoScanEngine/ScanVariant.h"
+#include "XenoScanEngine/ScanMetrics.h"
+#include "XenoScanEngine/StdListBlueprint.h"
+
+/*
+	Benchmarks the scanner against a SyntheticScannerTarget. Every result is one
+	line of JSON on stdout (after a line describing the setup), so that runs can be
+	compared by scripts; the scanner's own console output is thrown away.
+
+	Each benchmark sets the target up again for every iteration, and only the scan
+	itself is timed. For every type, "scan" is a first scan for a planted value, and
+	"rescan" narrows those results after half of the planted values are wiped out.
+	"data structure scan" looks for the std::lists built by --lists.
+*/
+
+struct BenchmarkOptions
+{
+	SyntheticScannerTarget::Options target;
+	double density;
+	size_t listCount, listLength;
+	size_t iterations;
+	std::string filter;
+
+	// see Scanner::setScanPipeline() and setThreadPinning()
+	size_t readers, scanners, queueDepth;
+	bool pinned;
+
+	BenchmarkOptions() :
+		density(0.001), listCount(1000), listLength(16), iterations(3),
+		readers(0), scanners(0), queueDepth(Scanner::DefaultPipelineQueueDepth), pinned(false) {}
+};
+
+struct BenchmarkRun
+{
+	double milliseconds;
+	ScanMetrics metrics;
+};
+
+class BenchmarkReporter
+{
+public:
+	BenchmarkReporter(std::ostream &output) : output(output)
+	{
+		this->output << std::fixed << std::setprecision(3);
+	}
+
+	void reportOptions(const BenchmarkOptions &options)
+	{
+		this->output
+			<< "{\"config\":{"
+			<< "\"regions\":" << options.target.regionCount
+			<< ",\"regionSize\":" << options.target.regionSize
+			<< ",\"littleEndian\":" << (options.target.littleEndian ? "true" : "false")
+			<< ",\"directPointers\":" << (options.target.directPointers ? "true" : "false")
+			<< ",\"readMicrosecondsPerMegabyte\":" << options.target.readMicrosecondsPerMegabyte
+			<< ",\"density\":" << options.density
+			<< ",\"lists\":" << options.listCount
+			<< ",\"listLength\":" << options.listLength
+			<< ",\"seed\":" << options.target.seed
+			<< ",\"iterations\":" << options.iterations
+			<< ",\"readers\":" << options.readers
+			<< ",\"scanners\":" << options.scanners
+			<< ",\"queueDepth\":" << options.queueDepth
+			<< ",\"pinned\":" << (options.pinned ? "true" : "false")
+			<< ",\"hardwareThreads\":" << std::thread::hardware_concurrency()
+			<< "}}" << std::endl;
+	}
+
+	void report(const std::string &benchmark, const std::string &type, const std::vector<BenchmarkRun> &runs)
+	{
+		if (runs.empty())
+			return;
+
+		// the fastest run is the one with the least noise in it
+		size_t best = 0;
+		double total = 0;
+		for (size_t run = 0; run < runs.size(); run++)
+		{
+			total += runs[run].milliseconds;
+			if (runs[run].milliseconds < runs[best].milliseconds)
+				best = run;
+		}
+
+		auto &metrics = runs[best].metrics;
+		auto seconds = runs[best].milliseconds / 1000.0;
+		auto megabytes = (double)metrics.bytesScanned / (1024.0 * 1024.0);
+
+		this->output
+			<< "{\"benchmark\":\"" << benchmark << "\""
+			<< ",\"type\":\"" << type << "\""
+			<< ",\"iterations\":" << runs.size()
+			<< ",\"bestMilliseconds\":" << runs[best].milliseconds
+			<< ",\"meanMilliseconds\":" << (total / runs.size())
+			<< ",\"bytesRead\":" << metrics.bytesRead
+			<< ",\"bytesScanned\":" << metrics.bytesScanned
+			<< ",\"megabytesPerSecond\":" << ((seconds > 0) ? megabytes / seconds : 0)
+			<< ",\"matches\":" << metrics.matches
+			<< ",\"readFailures\":" << metrics.readFailures
+			<< ",\"lockWaitMilliseconds\":" << metrics.lockWaitMilliseconds
+			<< ",\"threads\":" << metrics.threads.size()
+			<< ",\"phases\":{";
+		for (auto phase = metrics.phases.cbegin(); phase != metrics.phases.cend(); phase++)
+		{
+			if (phase != metrics.phases.cbegin())
+				this->output << ",";
+			this->output << "\"" << phase->name << "\":" << phase->milliseconds;
+		}
+		this->output << "}}" << std::endl;
+	}
+
+private:
+	std::ostream &output;
+};
+
+class BenchmarkRunner
+{
+public:
+	BenchmarkRunner(const BenchmarkOptions &options, BenchmarkReporter &reporter) :
+		options(options), reporter(reporter)
+	{
+		this->target = std::make_shared<SyntheticScannerTarget>(options.target);
+		this->scanner.setMetricsEnabled(true);
+		this->scanner.setScanPipeline(options.readers, options.scanners, options.queueDepth);
+		this->scanner.setThreadPinning(options.pinned);
+	}
+
+	void runAll()
+	{
+		// every type the scanner can search for, with something that stands out to plant
+		for (ScanVariant::ScanVariantType type = ScanVariant::SCAN_VARIANT_NUMERICTYPES_BEGIN; type <= ScanVariant::SCAN_VARIANT_NUMERICTYPES_END; type++)
+		{
+			auto needle = ScanVariant::FromNumberTyped(0x5A5A5A5A5A5A5A5A, type);
+			if (type == ScanVariant::SCAN_VARIANT_DOUBLE)
+				needle = ScanVariant::FromNumber(1234.5625);
+			else if (type == ScanVariant::SCAN_VARIANT_FLOAT)
+				needle = ScanVariant::FromNumber(1234.5625f);
+			else if (needle.isDynamic())
+				needle = ScanVariant::FromNumberTyped(0, type); // whatever the target's clock says
+
+			this->runValue(needle);
+		}
+
+		this->runValue(ScanVariant::FromString(std::string("XenoScanBenchmark")));
+		this->runValue(ScanVariant::FromString(std::wstring(L"XenoScanBenchmark")));
+
+		// structures are planted as their members, back to back
+		std::vector<ScanVariant> members;
+		members.push_back(ScanVariant::FromNumber((uint32_t)0x5A5A5A5A));
+		members.push_back(ScanVariant::FromNumber((uint16_t)7));
+		members.push_back(ScanVariant::FromNumber((uint16_t)9));
+		members.push_back(ScanVariant::FromNumber(1.5f));
+
+		std::vector<uint8_t> bytes;
+		for (auto member = members.cbegin(); member != members.cend(); member++)
+		{
+			std::vector<uint8_t> memberBytes;
+			member->toBuffer(this->target->isLittleEndian(), memberBytes);
+			bytes.insert(bytes.end(), memberBytes.begin(), memberBytes.end());
+		}
+		this->runValue(ScanVariant::FromStruct(members), bytes);
+
+		this->runDataStructures(StdListBlueprint::Key);
+	}
+
+private:
+	BenchmarkOptions options;
+	BenchmarkReporter &reporter;
+	std::shared_ptr<SyntheticScannerTarget> target;
+	Scanner scanner;
+
+	bool isFiltered(const std::string &benchmark, const std::string &type) const
+	{
+		if (this->options.filter.empty())
+			return false;
+		return (benchmark + " " + type).find(this->options.filter) == std::string::npos;
+	}
+
+	static std::string getTypeName(const ScanVariant &value)
+	{
+		auto name = value.getTypeName();
+		return std::string(name.begin(), name.end());
+	}
+
+	// what the value looks like in the target, which is what gets planted
+	bool getPlantedBytes(const ScanVariant &value, std::vector<uint8_t> &bytes) const
+	{
+		auto isLittleEndian = this->target->isLittleEndian();
+		if (value.getType() == ScanVariant::SCAN_VARIANT_FILETIME64)
+			return ScanVariant::FromNumberTyped(this->target->getFileTime64(), ScanVariant::SCAN_VARIANT_UINT64).toBuffer(isLittleEndian, bytes);
+		if (value.getType() == ScanVariant::SCAN_VARIANT_TICKTIME32)
+			return ScanVariant::FromNumberTyped(this->target->getTickTime32(), ScanVariant::SCAN_VARIANT_UINT32).toBuffer(isLittleEndian, bytes);
+		return value.toBuffer(isLittleEndian, bytes);
+	}
+
+	BenchmarkRun timeScan(const std::function<void()> &scan)
+	{
+		BenchmarkRun run;
+		auto start = std::chrono::steady_clock::now();
+		scan();
+		run.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		run.metrics = this->scanner.getLastScanMetrics();
+		return run;
+	}
+
+	void runValue(const ScanVariant &needle)
+	{
+		std::vector<uint8_t> bytes;
+		if (this->getPlantedBytes(needle, bytes))
+			this->runValue(needle, bytes);
+	}
+
+	void runValue(const ScanVariant &needle, const std::vector<uint8_t> &bytes)
+	{
+		auto type = BenchmarkRunner::getTypeName(needle);
+		auto runScan = !this->isFiltered("scan", type);
+		auto runReScan = !this->isFiltered("rescan", type);
+		if ((!runScan && !runReScan) || bytes.empty())
+			return;
+
+		// values are planted on their natural alignment, like a compiler would
+		auto alignment = std::min(bytes.size(), sizeof(uint64_t));
+		while (alignment & (alignment - 1))
+			alignment &= alignment - 1;
+
+		auto compare = Scanner::SCAN_COMPARE_EQUALS;
+		auto inferType = Scanner::SCAN_INFER_TYPE_EXACT;
+		std::vector<uint8_t> wiped(bytes.size(), 0);
+		std::vector<BenchmarkRun> scans, reScans;
+		for (size_t iteration = 0; iteration < this->options.iterations; iteration++)
+		{
+			this->target->randomize();
+			auto planted = this->target->plant(bytes, this->options.density, alignment);
+
+			this->scanner.startNewScan();
+			scans.push_back(this->timeScan([this, &needle, compare, inferType]() -> void {
+				this->scanner.runScan(this->target, needle, compare, inferType);
+			}));
+
+			for (size_t i = 0; i < planted.size(); i += 2)
+				this->target->writeArray(planted[i], wiped.size(), &wiped[0]);
+
+			reScans.push_back(this->timeScan([this, &needle, compare, inferType]() -> void {
+				this->scanner.runScan(this->target, needle, compare, inferType);
+			}));
+		}
+
+		if (runScan)
+			this->reporter.report("scan", type, scans);
+		if (runReScan)
+			this->reporter.report("rescan", type, reScans);
+	}
+
+	void runDataStructures(const std::string &type)
+	{
+		if (this->isFiltered("data structure scan", type))
+			return;
+
+		std::vector<BenchmarkRun> runs;
+		for (size_t iteration = 0; iteration < this->options.iterations; iteration++)
+		{
+			this->target->randomize();
+			this->target->buildLists(this->options.listCount, this->options.listLength);
+
+			this->scanner.startNewScan();
+			runs.push_back(this->timeScan([this, &type]() -> void {
+				this->scanner.runDataStructureScan(this->target, type);
+			}));
+		}
+		this->reporter.report("data structure scan", type, runs);
+	}
+};
+
+
+bool parseOptions(int argc, char** argv, BenchmarkOptions &options)
+{
+	for (int a = 1; a < argc; a++)
+	{
+		std::string arg(argv[a]);
+		auto hasValue = (a + 1 < argc);
+		auto value = hasValue ? std::string(argv[a + 1]) : std::string();
+
+		if (arg == "--big-endian")
+		{
+			options.target.littleEndian = false;
+			continue;
+		}
+		if (arg == "--direct")
+		{
+			options.target.directPointers = true;
+			continue;
+		}
+		if (arg == "--pin")
+		{
+			options.pinned = true;
+			continue;
+		}
+
+		if (!hasValue)
+			return false;
+		else if (arg == "--regions")
+			options.target.regionCount = std::stoull(value);
+		else if (arg == "--region-size")
+			options.target.regionSize = std::stoull(value, nullptr, 0);
+		else if (arg == "--density")
+			options.density = std::stod(value);
+		else if (arg == "--lists")
+			options.listCount = std::stoull(value);
+		else if (arg == "--list-length")
+			options.listLength = std::stoull(value);
+		else if (arg == "--seed")
+			options.target.seed = (uint32_t)std::stoul(value);
+		else if (arg == "--iterations")
+			options.iterations = std::stoull(value);
+		else if (arg == "--filter")
+			options.filter = value;
+		else if (arg == "--read-delay")
+			options.target.readMicrosecondsPerMegabyte = (uint32_t)std::stoul(value);
+		else if (arg == "--readers")
+			options.readers = std::stoull(value);
+		else if (arg == "--scanners")
+			options.scanners = std::stoull(value);
+		else if (arg == "--queue-depth")
+			options.queueDepth = std::stoull(value);
+		else
+			return false;
+
+		a++; // skip the value
+	}
+
+	return options.target.regionCount && options.target.regionSize && options.iterations;
+}
+
+int main(int argc, char** argv)
+{
+	BenchmarkOptions options;
+	bool parsed;
+	try
+	{
+		parsed = parseOptions(argc, argv, options);
+	}
+	catch (const std::exception&)
+	{
+		parsed = false;
+	}
+
+	if (!parsed)
+	{
+		std::cerr << "usage: XenoScanBench [--regions N] [--region-size BYTES] [--density FRACTION]" << std::endl;
+		std::cerr << "                     [--big-endian] [--direct] [--lists N] [--list-length N]" << std::endl;
+		std::cerr << "                     [--seed N] [--iterations N] [--filter TEXT]" << std::endl;
+		std::cerr << "                     [--read-delay MICROSECONDS_PER_MB] [--readers N] [--scanners N] [--queue-depth N]" << std::endl;
+		return 1;
+	}
+
+	BenchmarkReporter reporter(std::cout);
+	reporter.reportOptions(options);
+
+	BenchmarkRunner runner(options, reporter);
+	runner.runAll();
+	return 0;
+}
\ No newline at end of file
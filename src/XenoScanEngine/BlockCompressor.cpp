@@ -0,0 +1,152 @@
+#include "BlockCompressor.h"
+
+#include <vector>
+#include <cstring>
+
+
+size_t BlockCompressor::getMaximumCompressedSize(const size_t &srcSize)
+{
+	return srcSize + (srcSize / 255) + 16;
+}
+
+size_t BlockCompressor::compress(const uint8_t* src, const size_t &srcSize, uint8_t* dst, const size_t &dstCapacity)
+{
+	if (dstCapacity < BlockCompressor::getMaximumCompressedSize(srcSize))
+		return 0;
+
+	// positions of recently seen 4 byte sequences. a stale or empty
+	// entry is harmless, since every candidate is checked before use
+	std::vector<uint32_t> table(1 << HashLog, 0);
+
+	size_t ip = 0, op = 0, anchor = 0;
+	if (srcSize > MatchFindLimit)
+	{
+		size_t searchLimit = srcSize - MatchFindLimit;
+		size_t matchLimit = srcSize - LastLiterals;
+		size_t misses = 0;
+		while (ip <= searchLimit)
+		{
+			uint32_t sequence;
+			memcpy(&sequence, &src[ip], sizeof(sequence));
+			auto h = BlockCompressor::hash(sequence);
+			size_t candidate = table[h];
+			table[h] = static_cast<uint32_t>(ip);
+
+			uint32_t candidateSequence;
+			memcpy(&candidateSequence, &src[candidate], sizeof(candidateSequence));
+			if (candidate >= ip || ip - candidate > MaximumOffset || candidateSequence != sequence)
+			{
+				// data that isn't compressing gets skipped over faster and faster
+				ip += 1 + (misses++ >> 6);
+				continue;
+			}
+			misses = 0;
+
+			// grow the match in both directions
+			while (ip > anchor && candidate > 0 && src[ip - 1] == src[candidate - 1])
+			{
+				ip--;
+				candidate--;
+			}
+			size_t length = MinimumMatch;
+			while (ip + length < matchLimit && src[ip + length] == src[candidate + length])
+				length++;
+
+			// token, literals, offset, then the rest of the match length
+			auto token = &dst[op++];
+			size_t literals = ip - anchor;
+			if (literals >= 15)
+			{
+				*token = (15 << 4);
+				BlockCompressor::writeLength(dst, op, literals - 15);
+			}
+			else
+				*token = static_cast<uint8_t>(literals << 4);
+
+			memcpy(&dst[op], &src[anchor], literals);
+			op += literals;
+
+			size_t offset = ip - candidate;
+			dst[op++] = static_cast<uint8_t>(offset & 0xFF);
+			dst[op++] = static_cast<uint8_t>(offset >> 8);
+
+			size_t matchLength = length - MinimumMatch;
+			if (matchLength >= 15)
+			{
+				*token |= 15;
+				BlockCompressor::writeLength(dst, op, matchLength - 15);
+			}
+			else
+				*token |= static_cast<uint8_t>(matchLength);
+
+			ip += length;
+			anchor = ip;
+		}
+	}
+
+	// whatever is left goes out as literals
+	size_t literals = srcSize - anchor;
+	auto token = &dst[op++];
+	if (literals >= 15)
+	{
+		*token = (15 << 4);
+		BlockCompressor::writeLength(dst, op, literals - 15);
+	}
+	else
+		*token = static_cast<uint8_t>(literals << 4);
+
+	memcpy(&dst[op], &src[anchor], literals);
+	op += literals;
+	return op;
+}
+
+bool BlockCompressor::decompress(const uint8_t* src, const size_t &srcSize, uint8_t* dst, const size_t &dstSize)
+{
+	// the input comes from a file, so nothing in it is trusted
+	size_t ip = 0, op = 0;
+	while (ip < srcSize)
+	{
+		auto token = src[ip++];
+
+		size_t literals = (token >> 4);
+		if (literals == 15 && !BlockCompressor::readLength(src, srcSize, ip, literals))
+			return false;
+		if (literals > srcSize - ip || literals > dstSize - op)
+			return false;
+
+		memcpy(&dst[op], &src[ip], literals);
+		ip += literals;
+		op += literals;
+
+		// the last sequence has no match
+		if (ip == srcSize)
+			break;
+
+		if (srcSize - ip < 2)
+			return false;
+		size_t offset = src[ip] | (src[ip + 1] << 8);
+		ip += 2;
+		if (offset == 0 || offset > op)
+			return false;
+
+		size_t length = (token & 15);
+		if (length == 15 && !BlockCompressor::readLength(src, srcSize, ip, length))
+			return false;
+		length += MinimumMatch;
+		if (length > dstSize - op)
+			return false;
+
+		// matches can overlap their own output (that's how runs are encoded)
+		auto match = &dst[op - offset];
+		if (offset >= length)
+			memcpy(&dst[op], match, length);
+		else
+		{
+			for (size_t i = 0; i < length; i++)
+				dst[op + i] = match[i];
+		}
+		op += length;
+	}
+
+	return (op == dstSize);
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+
+// A small, fast compressor which writes the LZ4 block format. It's meant
+// for memory pages, where speed matters far more than ratio, and is
+// self-contained so that snapshots don't need an external library.
+class BlockCompressor
+{
+public:
+	// dst should be at least this big, otherwise compress() won't even try
+	static size_t getMaximumCompressedSize(const size_t &srcSize);
+
+	// returns the compressed size, or 0 on failure
+	static size_t compress(const uint8_t* src, const size_t &srcSize, uint8_t* dst, const size_t &dstCapacity);
+
+	// fails unless src decompresses to exactly dstSize bytes
+	static bool decompress(const uint8_t* src, const size_t &srcSize, uint8_t* dst, const size_t &dstSize);
+
+private:
+	static const size_t MinimumMatch = 4;
+	static const size_t LastLiterals = 5;     // the format requires the last 5 bytes to be literals
+	static const size_t MatchFindLimit = 12;  // and that no match starts in the last 12 bytes
+	static const size_t MaximumOffset = 0xFFFF;
+	static const uint32_t HashLog = 12;
+
+	static inline uint32_t hash(const uint32_t &sequence)
+	{
+		return (sequence * 2654435761U) >> (32 - HashLog);
+	}
+
+	static inline void writeLength(uint8_t* dst, size_t &op, size_t length)
+	{
+		while (length >= 255)
+		{
+			dst[op++] = 255;
+			length -= 255;
+		}
+		dst[op++] = static_cast<uint8_t>(length);
+	}
+
+	static inline bool readLength(const uint8_t* src, const size_t &srcSize, size_t &ip, size_t &length)
+	{
+		uint8_t byte;
+		do
+		{
+			if (ip >= srcSize)
+				return false;
+			byte = src[ip++];
+			length += byte;
+		} while (byte == 255);
+		return true;
+	}
+};
\ No newline at end of file
@@ -0,0 +1,132 @@
+#include "BlockFilter.h"
+
+#include <cctype>
+
+
+BlockFilter::BlockFilter() :
+	writeable(FLAG_RULE_IGNORE), executable(FLAG_RULE_IGNORE),
+	mapped(FLAG_RULE_IGNORE), mappedImage(FLAG_RULE_IGNORE), module(FLAG_RULE_IGNORE),
+	minimumSize(0), maximumSize(0)
+{
+}
+
+bool BlockFilter::isEmpty() const
+{
+	return (this->writeable == FLAG_RULE_IGNORE && this->executable == FLAG_RULE_IGNORE &&
+		this->mapped == FLAG_RULE_IGNORE && this->mappedImage == FLAG_RULE_IGNORE && this->module == FLAG_RULE_IGNORE &&
+		this->minimumSize == 0 && this->maximumSize == 0 &&
+		this->includeModules.empty() && this->excludeModules.empty() &&
+		this->includeRanges.empty() && this->excludeRanges.empty());
+}
+
+BlockFilter::Compiled BlockFilter::compile(const ScannerTargetShPtr &target) const
+{
+	Compiled compiled;
+	compiled.empty = this->isEmpty();
+	compiled.hasIncludes = (!this->includeModules.empty() || !this->includeRanges.empty());
+	compiled.writeable = this->writeable;
+	compiled.executable = this->executable;
+	compiled.mapped = this->mapped;
+	compiled.mappedImage = this->mappedImage;
+	compiled.module = this->module;
+	compiled.minimumSize = this->minimumSize;
+	compiled.maximumSize = this->maximumSize;
+
+	for (auto range = this->includeRanges.cbegin(); range != this->includeRanges.cend(); range++)
+		compiled.includes.insert(range->first, range->second);
+	for (auto range = this->excludeRanges.cbegin(); range != this->excludeRanges.cend(); range++)
+		compiled.excludes.insert(range->first, range->second);
+
+	// if the target can't give us modules, module globs just won't match anything
+	ModuleInformationCollection modules;
+	if ((this->includeModules.size() || this->excludeModules.size()) && target->getModules(modules))
+	{
+		for (auto module = modules.cbegin(); module != modules.cend(); module++)
+		{
+			for (auto glob = this->includeModules.cbegin(); glob != this->includeModules.cend(); glob++)
+			{
+				if (BlockFilter::matchesGlob(*glob, module->name))
+				{
+					compiled.includes.insert(module->base, module->end);
+					break;
+				}
+			}
+			for (auto glob = this->excludeModules.cbegin(); glob != this->excludeModules.cend(); glob++)
+			{
+				if (BlockFilter::matchesGlob(*glob, module->name))
+				{
+					compiled.excludes.insert(module->base, module->end);
+					break;
+				}
+			}
+		}
+	}
+
+	return compiled;
+}
+
+bool BlockFilter::matchesGlob(const std::string &pattern, const std::string &name)
+{
+	// iterative glob matching; on a mismatch we backtrack to the last
+	// '*' and let it swallow one more character of the name
+	size_t p = 0, n = 0;
+	size_t star = std::string::npos, starMatch = 0;
+	while (n < name.size())
+	{
+		if (p < pattern.size() && pattern[p] == '*')
+		{
+			star = p++;
+			starMatch = n;
+		}
+		else if (p < pattern.size() && (pattern[p] == '?' || tolower((unsigned char)pattern[p]) == tolower((unsigned char)name[n])))
+		{
+			p++;
+			n++;
+		}
+		else if (star != std::string::npos)
+		{
+			p = star + 1;
+			n = ++starMatch;
+		}
+		else
+			return false;
+	}
+
+	while (p < pattern.size() && pattern[p] == '*')
+		p++;
+	return (p == pattern.size());
+}
+
+
+BlockFilter::Compiled::Compiled() :
+	empty(true), hasIncludes(false),
+	writeable(FLAG_RULE_IGNORE), executable(FLAG_RULE_IGNORE),
+	mapped(FLAG_RULE_IGNORE), mappedImage(FLAG_RULE_IGNORE), module(FLAG_RULE_IGNORE),
+	minimumSize(0), maximumSize(0)
+{
+}
+
+bool BlockFilter::Compiled::matches(const MemoryInformation& meminfo) const
+{
+	if (this->empty)
+		return true;
+
+	if (!this->matchesFlag(this->writeable, meminfo.isWriteable) ||
+		!this->matchesFlag(this->executable, meminfo.isExecutable) ||
+		!this->matchesFlag(this->mapped, meminfo.isMapped) ||
+		!this->matchesFlag(this->mappedImage, meminfo.isMappedImage) ||
+		!this->matchesFlag(this->module, meminfo.isModule))
+		return false;
+
+	if (meminfo.allocationSize < this->minimumSize)
+		return false;
+	if (this->maximumSize && meminfo.allocationSize > this->maximumSize)
+		return false;
+
+	if (this->hasIncludes && !this->includes.overlaps(meminfo.allocationBase, meminfo.allocationEnd))
+		return false;
+	if (this->excludes.overlaps(meminfo.allocationBase, meminfo.allocationEnd))
+		return false;
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,68 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "ScannerTypes.h"
+#include "ScannerTarget.h"
+
+
+// A declarative replacement for block checker callbacks. The rules are
+// plain data, so they can be built from a Lua table once, and then compiled
+// against a target into something that can be checked against every region
+// without calling back into anything.
+class BlockFilter
+{
+public:
+	typedef uint8_t FlagRule;
+	enum _FlagRule : FlagRule
+	{
+		FLAG_RULE_IGNORE,
+		FLAG_RULE_REQUIRED,
+		FLAG_RULE_EXCLUDED
+	};
+
+	FlagRule writeable, executable, mapped, mappedImage, module;
+
+	// a maximum size of 0 means there's no maximum
+	size_t minimumSize, maximumSize;
+
+	// module names are case insensitive globs, where '*' matches anything and '?'
+	// matches any single character. a region is included if it overlaps any
+	// included range or module, and excluded if it overlaps any excluded one
+	std::vector<std::string> includeModules, excludeModules;
+	MemoryAddressBounds includeRanges, excludeRanges;
+
+	BlockFilter();
+
+	bool isEmpty() const;
+
+	class Compiled
+	{
+	public:
+		Compiled();
+
+		bool isEmpty() const { return this->empty; }
+		bool matches(const MemoryInformation& meminfo) const;
+
+	private:
+		friend class BlockFilter;
+
+		bool empty, hasIncludes;
+		FlagRule writeable, executable, mapped, mappedImage, module;
+		size_t minimumSize, maximumSize;
+		MemoryAddressBounds includes, excludes;
+
+		inline bool matchesFlag(const FlagRule &rule, const bool &value) const
+		{
+			if (rule == FLAG_RULE_REQUIRED) return value;
+			if (rule == FLAG_RULE_EXCLUDED) return !value;
+			return true;
+		}
+	};
+
+	// module globs are resolved to address ranges here, so
+	// this should be done once per scan, not once per region
+	Compiled compile(const ScannerTargetShPtr &target) const;
+
+	static bool matchesGlob(const std::string &pattern, const std::string &name);
+};
\ No newline at end of file
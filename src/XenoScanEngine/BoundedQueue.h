@@ -0,0 +1,74 @@
+#pragma once
+#include <queue>
+#include <mutex>
+#include <condition_variable>
+
+#include "Assert.h"
+
+
+// A queue that holds at most capacity items, for handing work from one set of
+// threads to another. push() waits while it's full and pop() waits while it's
+// empty, so the producers can't get further than capacity items ahead. Once
+// close() is called, pushes fail and pops drain whatever is left, then fail.
+template <typename T>
+class BoundedQueue
+{
+public:
+	BoundedQueue(const size_t &capacity) : capacity(capacity), closed(false)
+	{
+		ASSERT(capacity > 0);
+	}
+
+	bool push(T &&item)
+	{
+		std::unique_lock<std::mutex> lock(this->mutex);
+		this->notFull.wait(lock, [this]() -> bool { return this->closed || this->items.size() < this->capacity; });
+		if (this->closed)
+			return false;
+
+		this->items.push(std::move(item));
+		this->notEmpty.notify_one();
+		return true;
+	}
+
+	bool pop(T &item)
+	{
+		std::unique_lock<std::mutex> lock(this->mutex);
+		this->notEmpty.wait(lock, [this]() -> bool { return this->closed || !this->items.empty(); });
+		if (this->items.empty())
+			return false;
+
+		item = std::move(this->items.front());
+		this->items.pop();
+		this->notFull.notify_one();
+		return true;
+	}
+
+	// like pop(), but gives up instead of waiting
+	bool tryPop(T &item)
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		if (this->items.empty())
+			return false;
+
+		item = std::move(this->items.front());
+		this->items.pop();
+		this->notFull.notify_one();
+		return true;
+	}
+
+	void close()
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->closed = true;
+		this->notFull.notify_all();
+		this->notEmpty.notify_all();
+	}
+
+private:
+	std::mutex mutex;
+	std::condition_variable notFull, notEmpty;
+	std::queue<T> items;
+	size_t capacity;
+	bool closed;
+};
\ No newline at end of file
@@ -1,68 +1,94 @@
 #pragma once
-#include <memory>
-#include <list>
+#include <vector>
+#include <utility>
 #include <algorithm>
 
 
-template <typename T, typename C>
+// A set of [begin, end) ranges, kept as a flat vector that is sorted and
+// never has overlapping ranges in it. Because the ranges don't overlap,
+// both the begins and the ends are sorted, so every lookup is a binary search.
+template <typename T>
 class BoundingList
 {
 public:
+	typedef std::pair<T, T> Range;
+	typedef typename std::vector<Range>::const_iterator const_iterator;
+
 	bool insert(const T& begin, const T& end)
 	{
-		auto target = std::tuple<T, T>(begin, end);
-
-		// we're using a function called "std::lower_bound", but it will actually
-		// return the first element NOT LOWER than the target element.
-		auto lower = std::lower_bound(
-			this->bounds.begin(), this->bounds.end(),
-			target, C::CompareBounds
+		// find the first range that ends at or after our beginning, then every
+		// range from there which starts at or before our end touches us
+		auto first = std::lower_bound(
+			this->bounds.begin(), this->bounds.end(), begin,
+			[](const Range& range, const T& value) -> bool { return range.second < value; }
 		);
+		auto last = first;
+		while (last != this->bounds.end() && !(end < last->first))
+			last++;
 
-		if (lower == this->bounds.end())
-			this->bounds.push_back(target); // doesn't overlap with anything, add to end
-		else if (!C::CompareBounds(target, *lower))
+		if (first == last)
 		{
-			// the search calls the comparator as `C(*lower, target)` and we check
-			// `!C(*lower, target)`. together, these checks mean "these are 
-			// overlapping", so we coalesce these into a single block and keep the
-			// newest data.
-			auto lowest = std::min(std::get<0>(target), std::get<0>(*lower));
-			auto highest = std::max(std::get<1>(target), std::get<1>(*lower));
-			*lower = std::make_tuple(lowest, highest);
-			return false;
-		}
-		else
-		{
-			// this can be an equal element, but when it's not, it's the element
-			// before which we should insert the target to keep our ordering correct.
-			this->bounds.insert(lower, target);
+			// doesn't touch anything, insert it before the first range above it
+			this->bounds.insert(first, Range(begin, end));
+			return true; // true means "newly inserted"
 		}
 
-		return true; // true means "newly inserted"
+		// coalesce everything we touch into a single range
+		auto lowest = std::min(begin, first->first);
+		auto highest = std::max(end, (last - 1)->second);
+		*first = Range(lowest, highest);
+		this->bounds.erase(first + 1, last);
+		return false;
 	}
 
-
+	// true if [begin, end) is entirely inside of a single range
 	bool contains(const T& begin, const T& end) const
 	{
-		auto target = std::tuple<T, T>(begin, end);
-		auto lower = std::lower_bound(
-			this->bounds.cbegin(), this->bounds.cend(),
-			target, C::CompareBounds
+		auto range = this->find(begin);
+		return (range != this->bounds.cend() && !(range->second < end));
+	}
+
+	// true if [begin, end) shares any part of any range
+	bool overlaps(const T& begin, const T& end) const
+	{
+		auto range = std::upper_bound(
+			this->bounds.cbegin(), this->bounds.cend(), begin,
+			[](const T& value, const Range& range) -> bool { return value < range.second; }
+		);
+		return (range != this->bounds.cend() && range->first < end);
+	}
+
+	bool containsAddress(const T& address) const
+	{
+		return (this->find(address) != this->bounds.cend());
+	}
+
+	// returns the range holding the address, or end() if there isn't one
+	const_iterator find(const T& address) const
+	{
+		auto range = std::upper_bound(
+			this->bounds.cbegin(), this->bounds.cend(), address,
+			[](const T& value, const Range& range) -> bool { return value < range.first; }
 		);
-		if (lower == this->bounds.cend())
-			return false; // nothing above
-		else if (!C::CompareBounds(target, *lower))
-			return true;  // !(lower < target) && !(target < lower)
-		return false;     // !(lower < target) &&  (target < lower)
+		if (range == this->bounds.cbegin())
+			return this->bounds.cend();
+
+		range--;
+		return (address < range->second) ? range : this->bounds.cend();
 	}
 
+	const_iterator begin() const { return this->bounds.cbegin(); }
+	const_iterator end() const { return this->bounds.cend(); }
+	const_iterator cbegin() const { return this->bounds.cbegin(); }
+	const_iterator cend() const { return this->bounds.cend(); }
+	size_t size() const { return this->bounds.size(); }
+	bool empty() const { return this->bounds.empty(); }
+
 	void clear()
 	{
 		this->bounds.clear();
 	}
 
 private:
-	std::list<std::tuple<T, T>> bounds;
-};
-
+	std::vector<Range> bounds;
+};
\ No newline at end of file
@@ -0,0 +1,80 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BYTESEARCH_USE_SSE2
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+
+// Finds every place a run of bytes shows up in a buffer. With SSE2, the first
+// and last bytes of the run are checked at 16 places at once, and the whole run
+// is only compared where both of them match; that makes a selective run (one
+// that isn't all the same byte, or full of zeros) about as fast to find as one
+// byte is.
+class ByteSearch
+{
+public:
+	ByteSearch(const std::vector<uint8_t> &bytes) : bytes(bytes) {}
+	ByteSearch(const uint8_t* bytes, const size_t &size) : bytes(bytes, bytes + size) {}
+
+	size_t getSize() const { return this->bytes.size(); }
+
+	// calls found(offset) for every match in [buffer, buffer + size), in order
+	template <typename CALLBACK>
+	void forEachMatch(const uint8_t* buffer, const size_t &size, CALLBACK found) const
+	{
+		auto length = this->bytes.size();
+		if (!length || size < length)
+			return;
+
+		auto first = this->bytes[0];
+		auto lastStart = size - length;
+		size_t offset = 0;
+
+#ifdef BYTESEARCH_USE_SSE2
+		// the loads at offset + length - 1 have to stay inside of the buffer
+		auto firstBytes = _mm_set1_epi8((char)first);
+		auto lastBytes = _mm_set1_epi8((char)this->bytes[length - 1]);
+		for (; offset + 16 <= lastStart + 1; offset += 16)
+		{
+			auto heads = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&buffer[offset]));
+			auto tails = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&buffer[offset + length - 1]));
+			auto mask = (uint32_t)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(heads, firstBytes), _mm_cmpeq_epi8(tails, lastBytes)));
+			while (mask)
+			{
+				auto match = offset + countTrailingZeros(mask);
+				if (length <= 2 || memcmp(&buffer[match + 1], &this->bytes[1], length - 2) == 0)
+					found(match);
+				mask &= (mask - 1);
+			}
+		}
+#endif
+
+		for (; offset <= lastStart; offset++)
+		{
+			if (buffer[offset] == first && memcmp(&buffer[offset], &this->bytes[0], length) == 0)
+				found(offset);
+		}
+	}
+
+private:
+	std::vector<uint8_t> bytes;
+
+	static inline size_t countTrailingZeros(const uint32_t &value)
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward(&index, (unsigned long)value);
+		return index;
+#else
+		return __builtin_ctz(value);
+#endif
+	}
+};
\ No newline at end of file
@@ -0,0 +1,206 @@
+#include "CpuTopology.h"
+
+#include <thread>
+#include <algorithm>
+
+
+const CpuTopology& CpuTopology::get()
+{
+	static CpuTopology topology;
+	return topology;
+}
+
+CpuTopology::CpuTopology()
+{
+	if (CpuTopology::readNodes(this->nodes))
+	{
+		// nodes can be listed without any CPUs (memory-only nodes)
+		this->nodes.erase(
+			std::remove_if(this->nodes.begin(), this->nodes.end(), [](const std::vector<uint32_t> &cpus) -> bool { return cpus.empty(); }),
+			this->nodes.end()
+		);
+	}
+
+	if (this->nodes.empty())
+	{
+		this->nodes.resize(1);
+		auto count = std::max(1u, std::thread::hardware_concurrency());
+		for (uint32_t cpu = 0; cpu < count; cpu++)
+			this->nodes[0].push_back(cpu);
+	}
+}
+
+size_t CpuTopology::getNodeOfCpu(const uint32_t &cpu) const
+{
+	for (size_t node = 0; node < this->nodes.size(); node++)
+	{
+		auto &cpus = this->nodes[node];
+		if (std::find(cpus.begin(), cpus.end(), cpu) != cpus.end())
+			return node;
+	}
+	return 0;
+}
+
+std::vector<uint32_t> CpuTopology::spreadCpus(const size_t &count, const size_t &skip) const
+{
+	size_t largest = 0;
+	for (auto node = this->nodes.begin(); node != this->nodes.end(); node++)
+		largest = std::max(largest, node->size());
+
+	std::vector<uint32_t> order;
+	for (size_t index = 0; index < largest; index++)
+	{
+		for (auto node = this->nodes.begin(); node != this->nodes.end(); node++)
+		{
+			if (index < node->size())
+				order.push_back((*node)[index]);
+		}
+	}
+
+	std::vector<uint32_t> cpus;
+	for (size_t i = 0; i < count; i++)
+		cpus.push_back(order[(skip + i) % order.size()]);
+	return cpus;
+}
+
+
+
+#ifdef WIN32
+#include <Windows.h>
+
+// CPUs are numbered across processor groups, 64 to a group
+bool CpuTopology::readNodes(std::vector<std::vector<uint32_t>> &nodes)
+{
+	DWORD size = 0;
+	GetLogicalProcessorInformationEx(RelationNumaNode, nullptr, &size);
+	if (GetLastError() != ERROR_INSUFFICIENT_BUFFER)
+		return false;
+
+	std::vector<uint8_t> buffer(size);
+	auto info = (PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX)&buffer[0];
+	if (!GetLogicalProcessorInformationEx(RelationNumaNode, info, &size))
+		return false;
+
+	for (DWORD offset = 0; offset < size; )
+	{
+		auto entry = (PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX)&buffer[offset];
+		if (entry->Relationship == RelationNumaNode)
+		{
+			auto node = entry->NumaNode.NodeNumber;
+			if (nodes.size() <= node)
+				nodes.resize(node + 1);
+
+			auto &mask = entry->NumaNode.GroupMask;
+			for (uint32_t bit = 0; bit < 64; bit++)
+			{
+				if (mask.Mask & ((KAFFINITY)1 << bit))
+					nodes[node].push_back((uint32_t)mask.Group * 64 + bit);
+			}
+		}
+		offset += entry->Size;
+	}
+	return true;
+}
+
+bool CpuTopology::pinCurrentThread(const uint32_t &cpu)
+{
+	GROUP_AFFINITY affinity = {};
+	affinity.Group = (WORD)(cpu / 64);
+	affinity.Mask = (KAFFINITY)1 << (cpu % 64);
+	return SetThreadGroupAffinity(GetCurrentThread(), &affinity, nullptr) != FALSE;
+}
+
+#elif defined(__linux__)
+#include <sched.h>
+#include <dirent.h>
+#include <fstream>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+
+// cpulists look like "0-7,16-23"
+static inline void parseCpuList(const std::string &list, std::vector<uint32_t> &cpus)
+{
+	size_t start = 0;
+	while (start < list.size())
+	{
+		auto end = list.find(',', start);
+		if (end == std::string::npos)
+			end = list.size();
+
+		auto range = list.substr(start, end - start);
+		auto dash = range.find('-');
+		if (!range.empty() && isdigit((unsigned char)range[0]))
+		{
+			auto first = (uint32_t)strtoul(range.c_str(), nullptr, 10);
+			auto last = (dash == std::string::npos) ? first : (uint32_t)strtoul(range.c_str() + dash + 1, nullptr, 10);
+			for (auto cpu = first; cpu <= last; cpu++)
+				cpus.push_back(cpu);
+		}
+		start = end + 1;
+	}
+}
+
+bool CpuTopology::readNodes(std::vector<std::vector<uint32_t>> &nodes)
+{
+	auto dir = opendir("/sys/devices/system/node");
+	if (!dir)
+		return false;
+
+	while (auto entry = readdir(dir))
+	{
+		if (strncmp(entry->d_name, "node", 4) != 0 || !isdigit((unsigned char)entry->d_name[4]))
+			continue;
+
+		auto node = (size_t)strtoul(entry->d_name + 4, nullptr, 10);
+		std::ifstream file(std::string("/sys/devices/system/node/") + entry->d_name + "/cpulist");
+		std::string list;
+		if (!std::getline(file, list))
+			continue;
+
+		if (nodes.size() <= node)
+			nodes.resize(node + 1);
+		parseCpuList(list, nodes[node]);
+	}
+	closedir(dir);
+
+	// CPUs we aren't allowed to run on (cpusets, taskset) can't be pinned to
+	cpu_set_t allowed;
+	CPU_ZERO(&allowed);
+	if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0)
+	{
+		for (auto node = nodes.begin(); node != nodes.end(); node++)
+		{
+			node->erase(
+				std::remove_if(node->begin(), node->end(), [&allowed](const uint32_t &cpu) -> bool { return cpu >= CPU_SETSIZE || !CPU_ISSET(cpu, &allowed); }),
+				node->end()
+			);
+		}
+	}
+	return true;
+}
+
+bool CpuTopology::pinCurrentThread(const uint32_t &cpu)
+{
+	if (cpu >= CPU_SETSIZE)
+		return false;
+
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	return sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+#else
+
+bool CpuTopology::readNodes(std::vector<std::vector<uint32_t>> &nodes)
+{
+	return false;
+}
+
+bool CpuTopology::pinCurrentThread(const uint32_t &cpu)
+{
+	return false;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+
+// Which CPUs belong to which NUMA node, for pinning threads so that the memory
+// they touch first (which the OS puts on their own node) is the memory they
+// keep working on. Machines, and OSes, that don't say anything about their
+// nodes look like one node with every CPU on it.
+class CpuTopology
+{
+public:
+	// the topology is only read once, the first time it's asked for
+	static const CpuTopology& get();
+
+	size_t getNodeCount() const { return this->nodes.size(); }
+	const std::vector<uint32_t>& getNodeCpus(const size_t &node) const { return this->nodes[node]; }
+	size_t getNodeOfCpu(const uint32_t &cpu) const;
+
+	// count CPUs to pin threads to, taking one from each node in turn so that even
+	// a few threads are spread over every node. the first skip of them are passed
+	// over, so that two sets of threads can be given different CPUs
+	std::vector<uint32_t> spreadCpus(const size_t &count, const size_t &skip = 0) const;
+
+	// pins the calling thread to one CPU. returns false if it can't be done here
+	static bool pinCurrentThread(const uint32_t &cpu);
+
+private:
+	std::vector<std::vector<uint32_t>> nodes;
+
+	CpuTopology();
+
+	// these helper functions will be implemented for each OS
+	static bool readNodes(std::vector<std::vector<uint32_t>> &nodes);
+};
\ No newline at end of file
@@ -2,10 +2,18 @@
 
 #include "StdListBlueprint.h"
 #include "StdMapBlueprint.h"
+#include "StdVectorBlueprint.h"
+#include "StdUnorderedMapBlueprint.h"
 #include "NativeClassInstanceBlueprint.h"
 
 #include "ThreadPool.h"
-#include "ConsoleProgressTracker.h"
+#include "ProgressTracker.h"
+#include "Trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
 
 
 /*
@@ -17,14 +25,23 @@
 		1. std::list (or any double-linked list that is circular and is pointed down to by a root node)
 		2. std::map (or any balanced tree where the first node's paren't points to a root, whose parent points to the first node)
 		3. abstract class instances (anything with a VF table)
+		4. std::vector (or any begin/end/capacity triple of pointers into a single allocation)
+		5. std::unordered_map (MSVC and libstdc++ layouts, found by their bucket arrays)
 */
 
 const std::string DataStructureBlueprint::ItemCountTag = "itemCount";
 const std::string DataStructureBlueprint::VFTableTag = "VFTable";
+const std::string DataStructureBlueprint::SizeInBytesTag = "sizeInBytes";
+const std::string DataStructureBlueprint::CapacityInBytesTag = "capacityInBytes";
+const std::string DataStructureBlueprint::StrideCandidatesTag = "strideCandidates";
+const std::string DataStructureBlueprint::BucketCountTag = "bucketCount";
+const std::string DataStructureBlueprint::LayoutTag = "layout";
 
 CREATE_FACTORY(DataStructureBlueprint);
 CREATE_PRODUCER(DataStructureBlueprint, StdListBlueprint,              "std::list");
 CREATE_PRODUCER(DataStructureBlueprint, StdMapBlueprint,               "std::map");
+CREATE_PRODUCER(DataStructureBlueprint, StdVectorBlueprint,            "std::vector");
+CREATE_PRODUCER(DataStructureBlueprint, StdUnorderedMapBlueprint,      "std::unordered_map");
 CREATE_PRODUCER(DataStructureBlueprint, NativeClassInstanceBlueprint,  "Native Class Instance");
 
 
@@ -32,7 +49,8 @@ void DataStructureBlueprint::findDataStructures(
 	const ScannerTargetShPtr &target,
 	const DataStructureBlueprint::FACTORY_TYPE::KEY_TYPE &key,
 	const PointerMap &pointerMap,
-	DataStructureResultMap& results)
+	DataStructureResultMap& results,
+	const ProgressCallback &progress)
 {
 	auto supported = target->getSupportedBlueprints();
 	if (supported.find(key) == supported.cend())
@@ -40,38 +58,95 @@ void DataStructureBlueprint::findDataStructures(
 
 	auto print = DataStructureBlueprint::Factory.createInstance(key);
 	ASSERT(print != nullptr);
+	print->progress = progress;
 	print->findMatches(target, pointerMap, results);
 }
 
 
+void DataStructureBlueprint::buildLocationIndex(const PointerMap &pointerMap, PointerLocationIndex &index)
+{
+	size_t count = 0;
+	for (auto ptrItr = pointerMap.cbegin(); ptrItr != pointerMap.cend(); ptrItr++)
+		count += ptrItr->second.size();
+
+	index.clear();
+	index.reserve(count);
+	for (auto ptrItr = pointerMap.cbegin(); ptrItr != pointerMap.cend(); ptrItr++)
+		for (auto ref = ptrItr->second.cbegin(); ref != ptrItr->second.cend(); ref++)
+			index.push_back(std::make_pair(*ref, ptrItr->first));
+
+	std::sort(index.begin(), index.end());
+}
+
+
 void DataStructureBlueprint::findMatches(
 	const ScannerTargetShPtr &target,
 	const PointerMap &pointerMap,
 	DataStructureResultMap& results)
 {
-	ThreadPool pool;
+	// Every pointer in the map is a potential node, but walking from every
+	// one of them rediscovers the same structure once per node. Instead, the
+	// frontier holds every pointer that isn't known to belong to a structure yet.
+	// It's processed in small batches (which keeps each batch's keys and flags
+	// in cache), and when a walk finds a structure, all of its nodes are claimed
+	// so that no other batch walks them again.
+	std::vector<MemoryAddress> frontier;
+	frontier.reserve(pointerMap.size());
+	for (auto ptrItr = pointerMap.cbegin(); ptrItr != pointerMap.cend(); ptrItr++)
+		frontier.push_back(ptrItr->first);
+
+	std::unique_ptr<std::atomic<bool>[]> claimed(new std::atomic<bool>[frontier.size()]);
+	for (size_t i = 0; i < frontier.size(); i++)
+		claimed[i] = false;
+
+	auto claim = [&frontier, &claimed](const MemoryAddress &node) -> void {
+		auto located = std::lower_bound(frontier.cbegin(), frontier.cend(), node);
+		if (located != frontier.cend() && *located == node)
+			claimed[located - frontier.cbegin()] = true;
+	};
+
+	const size_t batchSize = 1024;
+	auto batchCount = (frontier.size() + batchSize - 1) / batchSize;
+	auto typeName = this->getTypeName();
 	std::mutex mutex;
-	ConsoleProgressTracker tracker(
+
+	ThreadPool pool;
+	ProgressTracker tracker(
+		this->progress,
 		"Pointer Tree",
 		pool.getNumberOfWorkers(),
-		pointerMap.size(),
-		(pointerMap.size() / 100) + 1
+		batchCount,
+		(batchCount / 100) + 1
 	);
 
-	for (auto ptrItr = pointerMap.cbegin(); ptrItr != pointerMap.cend(); ptrItr++)
+	for (size_t batch = 0; batch < batchCount; batch++)
 	{
-		pool.execute([this, &pointerMap, &target, &results, &mutex, &ptrItr]() -> void {
-			DataStructureDetails details;
-			if (this->walkStructure(target, ptrItr->first, pointerMap, details))
+		auto begin = batch * batchSize;
+		auto end = std::min(begin + batchSize, frontier.size());
+		pool.execute([this, begin, end, typeName, &pointerMap, &target, &results, &mutex, &frontier, &claimed, &claim]() -> void {
+			Trace::Scope scope("blueprint", "walk");
+			for (auto i = begin; i < end; i++)
 			{
-				mutex.lock();
-				results[this->getTypeName()][details.identifier] = details;
-				mutex.unlock();
+				if (claimed[i])
+					continue;
+
+				DataStructureDetails details;
+				if (!this->walkStructure(target, frontier[i], pointerMap, details))
+					continue;
+
+				claimed[i] = true;
+				claim(details.identifier);
+				for (auto node = details.nodes.cbegin(); node != details.nodes.cend(); node++)
+					claim(*node);
+				details.nodes.clear();
+
+				std::lock_guard<std::mutex> lock(mutex);
+				results[typeName][details.identifier] = details;
 			}
 		});
 	}
 
-	pool.join([&pointerMap, &tracker](size_t remaining) -> void {
-		tracker.setNumberOfCompleteTasks(pointerMap.size() - remaining);
+	pool.join([batchCount, &tracker](size_t remaining) -> void {
+		tracker.setNumberOfCompleteTasks(batchCount - remaining);
 	});
 }
\ No newline at end of file
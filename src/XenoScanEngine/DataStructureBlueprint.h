@@ -11,6 +11,7 @@
 #include "ScannerTypes.h"
 #include "ScanVariant.h"
 #include "KeyedFactory.h"
+#include "ProgressTracker.h"
 
 struct DataStructureDetails
 {
@@ -19,9 +20,18 @@ struct DataStructureDetails
 	// as the default constructor is marked as private to prevent
 	// implicitly getting null variants.
 	std::map<std::string, ScanVariant> members;
+
+	// every node that was walked to find the structure. findMatches() uses this
+	// to skip pointers that already belong to a structure, and then drops it
+	std::vector<MemoryAddress> nodes;
 };
 
 typedef std::map<MemoryAddress, std::vector<MemoryAddress>> PointerMap;
+
+// this is the pointer map flipped around and flattened into (location, pointer)
+// pairs, sorted by location. it makes it cheap to find pointers which sit next
+// to each other in memory, without having to read them from the target
+typedef std::vector<std::pair<MemoryAddress, MemoryAddress>> PointerLocationIndex;
 typedef std::map<std::string, std::map<MemoryAddress, DataStructureDetails>> DataStructureResultMap;
 
 class DataStructureBlueprint
@@ -33,6 +43,11 @@ public:
 
 	static const std::string ItemCountTag;
 	static const std::string VFTableTag;
+	static const std::string SizeInBytesTag;
+	static const std::string CapacityInBytesTag;
+	static const std::string StrideCandidatesTag;
+	static const std::string BucketCountTag;
+	static const std::string LayoutTag;
 
 	virtual bool walkStructure(
 		const ScannerTargetShPtr &target,
@@ -46,5 +61,10 @@ public:
 		const PointerMap &pointerMap,
 		DataStructureResultMap& results);
 
-	static void findDataStructures(const ScannerTargetShPtr &target, const DataStructureBlueprint::FACTORY_TYPE::KEY_TYPE &key, const PointerMap &pointerMap, DataStructureResultMap& results);
+	static void buildLocationIndex(const PointerMap &pointerMap, PointerLocationIndex &index);
+	static void findDataStructures(const ScannerTargetShPtr &target, const DataStructureBlueprint::FACTORY_TYPE::KEY_TYPE &key, const PointerMap &pointerMap, DataStructureResultMap& results, const ProgressCallback &progress = nullptr);
+
+protected:
+	// findMatches() reports to this as it goes
+	ProgressCallback progress;
 };
\ No newline at end of file
@@ -0,0 +1,162 @@
+#include "FreezeList.h"
+
+#include <algorithm>
+
+
+FreezeList::FreezeList() : nextId(1), shutdown(false)
+{
+}
+
+FreezeList::~FreezeList()
+{
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->shutdown = true;
+	}
+	this->changed.notify_all();
+	if (this->thread.joinable())
+		this->thread.join();
+}
+
+FreezeList::FreezeId FreezeList::add(const ScannerTargetShPtr &target, const MemoryAddress &address, const ScanVariant &value, const uint32_t &intervalMs)
+{
+	ASSERT(target.get());
+
+	Entry entry;
+	if (!value.toBuffer(target->isLittleEndian(), entry.data) || entry.data.empty())
+		return 0;
+
+	entry.target = target;
+	entry.address = address;
+	entry.interval = std::chrono::milliseconds(intervalMs ? intervalMs : 1);
+	auto now = Clock::now();
+	entry.due = now + entry.interval - (now.time_since_epoch() % entry.interval);
+
+	FreezeId id;
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		id = this->nextId++;
+		this->entries[id] = entry;
+
+		// the thread only exists once something has been frozen
+		if (!this->thread.joinable())
+			this->thread = std::thread(&FreezeList::run, this);
+	}
+	this->changed.notify_all();
+	return id;
+}
+
+bool FreezeList::remove(const FreezeId &id)
+{
+	bool removed;
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		removed = (this->entries.erase(id) != 0);
+	}
+
+	// wait out a batch that might have the value in it
+	std::lock_guard<std::mutex> wait(this->writeMutex);
+	return removed;
+}
+
+void FreezeList::clear()
+{
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->entries.clear();
+	}
+	std::lock_guard<std::mutex> wait(this->writeMutex);
+}
+
+size_t FreezeList::size() const
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->entries.size();
+}
+
+void FreezeList::coalesce(const MemoryBufferCollection &writes, MemoryBufferCollection &coalesced)
+{
+	for (auto write = writes.cbegin(); write != writes.cend(); write++)
+	{
+		if (!coalesced.empty())
+		{
+			auto &last = coalesced.back();
+			auto lastStart = (size_t)last.address;
+			auto lastEnd = lastStart + last.data.size();
+			auto start = (size_t)write->address;
+			if (start <= lastEnd)
+			{
+				auto end = start + write->data.size();
+				if (end > lastEnd)
+					last.data.resize(end - lastStart);
+				std::copy(write->data.cbegin(), write->data.cend(), last.data.begin() + (start - lastStart));
+				continue;
+			}
+		}
+		coalesced.push_back(*write);
+	}
+}
+
+void FreezeList::run()
+{
+	std::unique_lock<std::mutex> lock(this->mutex);
+	while (!this->shutdown)
+	{
+		if (this->entries.empty())
+		{
+			this->changed.wait(lock);
+			continue;
+		}
+
+		auto now = Clock::now();
+		auto next = Clock::time_point::max();
+		for (auto entry = this->entries.cbegin(); entry != this->entries.cend(); entry++)
+			next = std::min(next, entry->second.due);
+		if (next > now)
+		{
+			this->changed.wait_until(lock, next);
+			continue;
+		}
+
+		// gather up everything that's due, by target. entries are in the order they
+		// were added, so when two of them overlap the newer one is written last
+		std::map<ScannerTarget*, std::pair<ScannerTargetShPtr, MemoryBufferCollection>> batches;
+		for (auto entry = this->entries.begin(); entry != this->entries.end(); entry++)
+		{
+			auto &frozen = entry->second;
+			if (frozen.due > now)
+				continue;
+
+			auto &batch = batches[frozen.target.get()];
+			batch.first = frozen.target;
+
+			MemoryBuffer write;
+			write.address = frozen.address;
+			write.data = frozen.data;
+			batch.second.push_back(write);
+
+			// writes are lined up on multiples of the interval, so values with the same
+			// interval go out together no matter when they were frozen. this also
+			// means that if we fell behind, there's no burst of writes to catch up
+			frozen.due = now + frozen.interval - (now.time_since_epoch() % frozen.interval);
+		}
+
+		// the writes can be slow, so they happen without the lock. the write lock is
+		// taken first, so anything removed from here on can wait for the batch to finish
+		std::unique_lock<std::mutex> writing(this->writeMutex);
+		lock.unlock();
+		for (auto batch = batches.begin(); batch != batches.end(); batch++)
+		{
+			auto &writes = batch->second.second;
+			std::stable_sort(writes.begin(), writes.end(),
+				[](const MemoryBuffer &a, const MemoryBuffer &b) -> bool { return (size_t)a.address < (size_t)b.address; }
+			);
+
+			MemoryBufferCollection coalesced;
+			FreezeList::coalesce(writes, coalesced);
+			batch->second.first->writeBatch(coalesced);
+		}
+		writing.unlock();
+		lock.lock();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+#pragma once
+#include <stdint.h>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+
+#include "Assert.h"
+#include "ScannerTypes.h"
+#include "ScannerTarget.h"
+#include "ScanVariant.h"
+
+
+// Values which are written back to their targets over and over, so that they
+// stay put. A timer thread (started with the first value) does the writing, and
+// everything due at the same time goes out together: sorted by address, merged
+// where the values touch, and handed to the target as one batch. Writes happen
+// on multiples of each value's interval, starting with the first one after it
+// was added.
+class FreezeList
+{
+public:
+	typedef uint32_t FreezeId;
+
+	FreezeList();
+	~FreezeList();
+
+	// returns 0 if the value can't be written (e.g. it's a structure)
+	FreezeId add(const ScannerTargetShPtr &target, const MemoryAddress &address, const ScanVariant &value, const uint32_t &intervalMs);
+
+	// once these return, the values won't be written again
+	bool remove(const FreezeId &id);
+	void clear();
+
+	size_t size() const;
+
+	// adjacent or overlapping writes become one. writes must be sorted by address,
+	// and where they overlap the later ones win
+	static void coalesce(const MemoryBufferCollection &writes, MemoryBufferCollection &coalesced);
+
+private:
+	typedef std::chrono::steady_clock Clock;
+	struct Entry
+	{
+		ScannerTargetShPtr target;
+		MemoryAddress address;
+		std::vector<uint8_t> data;
+		std::chrono::milliseconds interval;
+		Clock::time_point due;
+	};
+
+	mutable std::mutex mutex;
+	std::mutex writeMutex; // held while a batch is being written
+	std::condition_variable changed;
+	std::map<FreezeId, Entry> entries;
+	FreezeId nextId;
+
+	std::thread thread;
+	bool shutdown;
+
+	void run();
+};
\ No newline at end of file
@@ -0,0 +1,227 @@
+#include "MemoryDiff.h"
+
+#include "ThreadPool.h"
+#include "ProgressTracker.h"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MEMORYDIFF_USE_SSE2
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+
+static inline size_t countTrailingZeros(const uint64_t &value)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	if (_BitScanForward(&index, (unsigned long)(value & 0xFFFFFFFF)))
+		return index;
+	_BitScanForward(&index, (unsigned long)(value >> 32));
+	return index + 32;
+#else
+	return __builtin_ctzll(value);
+#endif
+}
+
+void MemoryDiff::diff(
+	const ScannerTargetShPtr &before, const MemoryInformationCollection &beforeBlocks,
+	const ScannerTargetShPtr &after, const MemoryInformationCollection &afterBlocks,
+	const size_t &minimumWidth,
+	MemoryChangeCollection &changes,
+	const ProgressCallback &progress)
+{
+	// find the memory both targets have
+	auto sortedBefore = beforeBlocks;
+	auto sortedAfter = afterBlocks;
+	auto byBase = [](const MemoryInformation &a, const MemoryInformation &b) -> bool { return a.allocationBase < b.allocationBase; };
+	std::sort(sortedBefore.begin(), sortedBefore.end(), byBase);
+	std::sort(sortedAfter.begin(), sortedAfter.end(), byBase);
+
+	std::vector<std::pair<MemoryAddress, size_t>> pieces;
+	auto a = sortedBefore.cbegin();
+	auto b = sortedAfter.cbegin();
+	while (a != sortedBefore.cend() && b != sortedAfter.cend())
+	{
+		auto start = std::max((size_t)a->allocationBase, (size_t)b->allocationBase);
+		auto end = std::min((size_t)a->allocationEnd, (size_t)b->allocationEnd);
+		for (auto piece = start; piece < end; piece += PieceSize)
+			pieces.push_back(std::make_pair((MemoryAddress)piece, (end - piece < PieceSize) ? end - piece : PieceSize));
+
+		if (a->allocationEnd < b->allocationEnd)
+			a++;
+		else
+			b++;
+	}
+
+	std::mutex mutex;
+	ThreadPool pool;
+	ProgressTracker tracker(
+		progress,
+		"Diff",
+		pool.getNumberOfWorkers(),
+		pieces.size(),
+		(pieces.size() / 100) + 1
+	);
+
+	for (auto piece = pieces.cbegin(); piece != pieces.cend(); piece++)
+	{
+		auto start = piece->first;
+		auto size = piece->second;
+		pool.execute([&before, &after, &minimumWidth, &mutex, &changes, start, size]() -> void {
+			MemoryChangeCollection found;
+			MemoryDiff::diffRange(before, after, start, size, minimumWidth, found);
+			if (found.empty())
+				return;
+
+			std::lock_guard<std::mutex> lock(mutex);
+			changes.insert(changes.end(), found.begin(), found.end());
+		});
+	}
+
+	pool.join([&pieces, &tracker](size_t remaining) -> void {
+		tracker.setNumberOfCompleteTasks(pieces.size() - remaining);
+	});
+
+	std::sort(changes.begin(), changes.end(),
+		[](const MemoryChange &a, const MemoryChange &b) -> bool { return a.address < b.address; }
+	);
+}
+
+void MemoryDiff::diffRange(
+	const ScannerTargetShPtr &before, const ScannerTargetShPtr &after,
+	const MemoryAddress &start, const size_t &size,
+	const size_t &minimumWidth,
+	MemoryChangeCollection &changes)
+{
+	// use the memory in place if we can, otherwise read it
+	std::unique_ptr<uint8_t[]> beforeBuffer, afterBuffer;
+	auto beforeData = before->getDirectPointer(start, size);
+	if (!beforeData)
+	{
+		beforeBuffer.reset(new uint8_t[size]);
+		auto bufferPointer = beforeBuffer.get();
+		if (!before->readArray<uint8_t>(start, size, bufferPointer))
+			return;
+		beforeData = bufferPointer;
+	}
+	auto afterData = after->getDirectPointer(start, size);
+	if (!afterData)
+	{
+		afterBuffer.reset(new uint8_t[size]);
+		auto bufferPointer = afterBuffer.get();
+		if (!after->readArray<uint8_t>(start, size, bufferPointer))
+			return;
+		afterData = bufferPointer;
+	}
+
+	// changed bytes are grouped into runs, and each run is widened to a window which
+	// is reported as one change. windows never reach back into the last one reported
+	auto base = (size_t)start;
+	auto end = base + size;
+	size_t floor = base;
+	size_t runStart = 0, runEnd = 0, windowStart = 0, windowSize = 0, width = 0;
+	bool open = false;
+
+	auto widen = [&]() -> void
+	{
+		windowStart = runStart;
+		windowSize = runEnd - runStart;
+		width = 0;
+		for (size_t check = 1; check <= 8; check <<= 1)
+		{
+			if (check < minimumWidth)
+				continue;
+
+			auto checkStart = runStart & ~(check - 1);
+			if (checkStart + check >= runEnd && checkStart >= floor && checkStart + check <= end)
+			{
+				windowStart = checkStart;
+				windowSize = check;
+				width = check;
+				break;
+			}
+		}
+	};
+	auto close = [&]() -> void
+	{
+		MemoryChange change;
+		change.address = (MemoryAddress)windowStart;
+		change.width = width;
+		change.before.assign(&beforeData[windowStart - base], &beforeData[windowStart - base + windowSize]);
+		change.after.assign(&afterData[windowStart - base], &afterData[windowStart - base + windowSize]);
+		changes.push_back(change);
+
+		floor = windowStart + windowSize;
+		open = false;
+	};
+	auto addChangedByte = [&](const size_t &address) -> void
+	{
+		if (open && (address == runEnd || address < windowStart + windowSize))
+		{
+			runEnd = address + 1;
+			widen();
+			return;
+		}
+
+		if (open)
+			close();
+		open = true;
+		runStart = address;
+		runEnd = address + 1;
+		widen();
+	};
+
+	// most blocks don't change at all, so those are ruled out 64 bytes at a time
+	size_t offset = 0;
+	for (; offset + CompareBlockSize <= size; offset += CompareBlockSize)
+	{
+		auto mask = MemoryDiff::compareBlock(&beforeData[offset], &afterData[offset]);
+		while (mask)
+		{
+			addChangedByte(base + offset + countTrailingZeros(mask));
+			mask &= (mask - 1);
+		}
+	}
+	for (; offset < size; offset++)
+	{
+		if (beforeData[offset] != afterData[offset])
+			addChangedByte(base + offset);
+	}
+
+	if (open)
+		close();
+}
+
+uint64_t MemoryDiff::compareBlock(const uint8_t* a, const uint8_t* b)
+{
+#ifdef MEMORYDIFF_USE_SSE2
+	uint64_t mask = 0;
+	for (size_t i = 0; i < 4; i++)
+	{
+		auto left = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&a[i * 16]));
+		auto right = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&b[i * 16]));
+		auto same = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(left, right));
+		mask |= (uint64_t)(~same & 0xFFFF) << (i * 16);
+	}
+	return mask;
+#else
+	uint64_t mask = 0;
+	if (memcmp(a, b, CompareBlockSize) == 0)
+		return mask;
+
+	for (size_t i = 0; i < CompareBlockSize; i++)
+	{
+		if (a[i] != b[i])
+			mask |= (1ULL << i);
+	}
+	return mask;
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+#include <vector>
+
+#include "ScannerTypes.h"
+#include "ScannerTarget.h"
+#include "ProgressTracker.h"
+
+
+// A single changed range. Runs of changed bytes are widened to the smallest
+// naturally aligned 1, 2, 4 or 8 byte window that holds them, which is a decent
+// guess at the type of the value that changed. Anything longer is just bytes
+struct MemoryChange
+{
+	MemoryAddress address;
+	size_t width; // 1, 2, 4 or 8, or 0 for a run of bytes
+	std::vector<uint8_t> before, after;
+};
+typedef std::vector<MemoryChange> MemoryChangeCollection;
+
+
+// Compares the memory of two targets (typically two snapshots of the same
+// process) and finds everything that changed. Only memory that is in blocks
+// of both targets is compared; memory which came or went isn't reported.
+class MemoryDiff
+{
+public:
+	// minimumWidth stops tiny changes from being reported as single bytes, so
+	// a counter going from 5 to 6 can show up as the int32 it probably is
+	static void diff(
+		const ScannerTargetShPtr &before, const MemoryInformationCollection &beforeBlocks,
+		const ScannerTargetShPtr &after, const MemoryInformationCollection &afterBlocks,
+		const size_t &minimumWidth,
+		MemoryChangeCollection &changes,
+		const ProgressCallback &progress = nullptr);
+
+private:
+	// big ranges are split up so that more than one thread can work on them
+	static const size_t PieceSize = 0x1000000;
+	static const size_t CompareBlockSize = 64;
+
+	static void diffRange(
+		const ScannerTargetShPtr &before, const ScannerTargetShPtr &after,
+		const MemoryAddress &start, const size_t &size,
+		const size_t &minimumWidth,
+		MemoryChangeCollection &changes);
+
+	// returns a mask with a bit set for each of the 64 bytes which differ
+	static uint64_t compareBlock(const uint8_t* a, const uint8_t* b);
+};
\ No newline at end of file
@@ -1,11 +1,17 @@
 #pragma once
 
+#include <mutex>
+#include <algorithm>
+
 #include "Assert.h"
 #include "ScannerTarget.h"
 #include "ScannerTypes.h"
 #include "ScanVariant.h"
 #include "DataStructureBlueprint.h"
 
+#include "ThreadPool.h"
+#include "ProgressTracker.h"
+
 class NativeClassInstanceBlueprint : public DataStructureBlueprint
 {
 public:
@@ -30,34 +36,79 @@ public:
 		if (!target->getMainModuleBounds(moduleStart, moduleEnd))
 			return;
 
-		std::vector<MemoryInformation> executableBlocks, readOnlyBlocks;
+		MemoryAddressBounds executableBlocks, readOnlyBlocks;
 		this->getBlocks(target, moduleStart, moduleEnd, executableBlocks, readOnlyBlocks);
 
-		for (auto ptrItr = pointerMap.cbegin(); ptrItr != pointerMap.cend(); ptrItr++)
+		// The pointer map is ordered, so instead of testing every pointer against
+		// the read-only blocks we can jump straight to the slice of the map which
+		// lands inside of each block. Those slices are then cut into partitions
+		// so the thread pool can chew through them in parallel.
+		std::vector<PointerMapRange> partitions;
+		auto partitionSize = (this->countCandidates(pointerMap, readOnlyBlocks) / (ThreadPool::getMaxThreadCount() * 4)) + 1;
+		for (auto block = readOnlyBlocks.cbegin(); block != readOnlyBlocks.cend(); block++)
 		{
-			// There's a pointer to read only memory, maybe a VF table
-			if (this->isInBlock(readOnlyBlocks, ptrItr->first))
+			auto start = pointerMap.lower_bound(block->first);
+			auto end = pointerMap.lower_bound(block->second);
+			while (start != end)
 			{
-				auto pointed = target->read<MemoryAddress>(ptrItr->first);
+				auto partitionEnd = start;
+				for (size_t i = 0; i < partitionSize && partitionEnd != end; i++)
+					partitionEnd++;
+				partitions.push_back(std::make_pair(start, partitionEnd));
+				start = partitionEnd;
+			}
+		}
 
-				// The thing in read-only memory points to executable memory, definitely a VF table
-				if (this->isInBlock(executableBlocks, pointed))
+		std::mutex mutex;
+		auto typeName = this->getTypeName();
+
+		ThreadPool pool;
+		ProgressTracker tracker(
+			this->progress,
+			"VF Table",
+			pool.getNumberOfWorkers(),
+			partitions.size(),
+			(partitions.size() / 100) + 1
+		);
+
+		for (auto partition = partitions.cbegin(); partition != partitions.cend(); partition++)
+		{
+			auto range = *partition;
+			pool.execute([this, range, moduleStart, moduleEnd, &target, &executableBlocks, &typeName, &results, &mutex]() -> void {
+				std::map<MemoryAddress, DataStructureDetails> found;
+				for (auto ptrItr = range.first; ptrItr != range.second; ptrItr++)
 				{
+					// There's a pointer to read only memory, maybe a VF table
+					auto pointed = target->read<MemoryAddress>(ptrItr->first);
+
+					// The thing in read-only memory points to executable memory, definitely a VF table
+					if (!executableBlocks.containsAddress(pointed))
+						continue;
+
 					for (auto instance = ptrItr->second.begin(); instance != ptrItr->second.end(); instance++)
 					{
 						auto instanceAddress = *instance;
-						if (instanceAddress < moduleStart ||  instanceAddress > moduleEnd)
+						if (instanceAddress < moduleStart || instanceAddress > moduleEnd)
 						{
 							DataStructureDetails details;
 							details.identifier = instanceAddress;
 							details.members.insert(std::make_pair(VFTableTag, ScanVariant::FromMemoryAddress(ptrItr->first)));
-							results[this->getTypeName()][instanceAddress] = details;
+							found[instanceAddress] = details;
 						}
 					}
 				}
-			}
+
+				if (found.size())
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					results[typeName].insert(found.begin(), found.end());
+				}
+			});
 		}
 
+		pool.join([&partitions, &tracker](size_t remaining) -> void {
+			tracker.setNumberOfCompleteTasks(partitions.size() - remaining);
+		});
 	}
 
 	virtual std::string getTypeName() const
@@ -66,20 +117,22 @@ public:
 	}
 
 private:
-	inline bool isInBlock(const std::vector<MemoryInformation> &blocks, const MemoryAddress &adr)
+	typedef std::pair<PointerMap::const_iterator, PointerMap::const_iterator> PointerMapRange;
+
+	inline size_t countCandidates(const PointerMap &pointerMap, const MemoryAddressBounds &blocks) const
 	{
-		for (auto b = blocks.begin(); b != blocks.end(); b++)
-			if (adr >= b->allocationBase && adr < b->allocationEnd)
-				return true;
-		return false;
+		size_t count = 0;
+		for (auto block = blocks.cbegin(); block != blocks.cend(); block++)
+			count += std::distance(pointerMap.lower_bound(block->first), pointerMap.lower_bound(block->second));
+		return count;
 	}
 
 	inline void getBlocks(
 		const ScannerTargetShPtr &target,
 		const MemoryAddress &moduleStart,
 		const MemoryAddress &moduleEnd,
-		std::vector<MemoryInformation> &executableBlocks,
-		std::vector<MemoryInformation> &readOnlyBlocks) const
+		MemoryAddressBounds &executableBlocks,
+		MemoryAddressBounds &readOnlyBlocks) const
 	{
 		// identify all the different blocks in the main module of the target
 		//     E.G. on windows this will be the regions in PE header with
@@ -91,9 +144,9 @@ private:
 			if (target->queryMemory(nextAddress, meminfo, nextAddress) && meminfo.isCommitted)
 			{
 				if (meminfo.isExecutable)
-					executableBlocks.push_back(meminfo);
+					executableBlocks.insert(meminfo.allocationBase, meminfo.allocationEnd);
 				else if (!meminfo.isWriteable)
-					readOnlyBlocks.push_back(meminfo);
+					readOnlyBlocks.insert(meminfo.allocationBase, meminfo.allocationEnd);
 			}
 		}
 	}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <chrono>
+#include <functional>
+
+// how far along one stage of a scan (or diff, or structure scan) is
+struct ScanProgress
+{
+	std::string taskDescription;
+	size_t numberOfThreads, numberOfTasks, numberOfCompleteTasks;
+	double milliseconds;
+	bool done;
+};
+typedef std::function<void(const ScanProgress&)> ProgressCallback;
+
+// Counts the tasks of one stage as they're finished, and hands the count to a
+// callback every so often (and always at the start and end). Without a
+// callback, nothing is reported, so nobody pays for progress they don't want.
+class ProgressTracker
+{
+public:
+	ProgressTracker(const ProgressCallback& _callback, const std::string& _taskDescription, size_t _numberOfThreads, size_t _numberOfTasks, size_t _updatePrecision)
+		: callback(_callback), updatePrecision(_updatePrecision), lastUpdateNumberCompleteTasks(0)
+	{
+		this->progress.taskDescription = _taskDescription;
+		this->progress.numberOfThreads = _numberOfThreads;
+		this->progress.numberOfTasks = _numberOfTasks;
+		this->progress.numberOfCompleteTasks = 0;
+		this->progress.milliseconds = 0;
+		this->progress.done = false;
+
+		this->startTime = std::chrono::high_resolution_clock::now();
+		this->report();
+	}
+
+	~ProgressTracker()
+	{
+		// treat everything as done once we're destroyed so we
+		// report the final result
+		this->setNumberOfCompleteTasks(this->progress.numberOfTasks);
+	}
+
+	void setNumberOfCompleteTasks(size_t amount)
+	{
+		this->progress.numberOfCompleteTasks = amount;
+		auto delta = amount - this->lastUpdateNumberCompleteTasks;
+		if (delta > this->updatePrecision || amount == this->progress.numberOfTasks)
+			this->report();
+	}
+
+private:
+	ProgressCallback callback;
+	ScanProgress progress;
+	size_t updatePrecision, lastUpdateNumberCompleteTasks;
+	std::chrono::time_point<std::chrono::high_resolution_clock> startTime;
+
+	void report()
+	{
+		if (this->progress.done || !this->callback) return;
+
+		this->lastUpdateNumberCompleteTasks = this->progress.numberOfCompleteTasks;
+		this->progress.done = (this->progress.numberOfCompleteTasks == this->progress.numberOfTasks);
+
+		auto diff = std::chrono::high_resolution_clock::now() - this->startTime;
+		this->progress.milliseconds = std::chrono::duration<double, std::milli>(diff).count();
+		this->callback(this->progress);
+	}
+};
+
+// A ProgressCallback that prints progress to the console, overwriting the
+// count in place as it goes. It keeps track of what it printed, so each
+// scanner needs its own.
+class ConsoleProgressPrinter
+{
+public:
+	ConsoleProgressPrinter() : printing(false), numberOfCharsToBacktrack(0) {}
+
+	void operator()(const ScanProgress& progress)
+	{
+		if (!this->printing)
+		{
+			std::cout << progress.numberOfThreads << " Threads Scanning - " << progress.taskDescription << " ";
+			this->printing = true;
+			this->numberOfCharsToBacktrack = 0;
+		}
+
+		// prepend our output with however many chars we need to erase old info
+		std::stringstream message;
+		for (size_t i = 0; i < this->numberOfCharsToBacktrack; i++)
+			message << '\b';
+
+		// then add the new info
+		message << progress.numberOfCompleteTasks << " of " << progress.numberOfTasks;
+
+		auto output = message.str();
+		std::cout << output;
+		this->numberOfCharsToBacktrack = output.length() - this->numberOfCharsToBacktrack;
+
+		if (progress.done)
+		{
+			std::cout << " (Time " << progress.milliseconds << "ms)" << std::endl;
+			this->printing = false;
+		}
+	}
+
+private:
+	bool printing;
+	size_t numberOfCharsToBacktrack;
+};
\ No newline at end of file
@@ -0,0 +1,112 @@
+#include "RegionList.h"
+
+#include <algorithm>
+
+RegionList::RegionList(const Lister &lister) :
+	lister(lister), mainModuleStart(nullptr), mainModuleEnd(nullptr)
+{
+}
+
+void RegionList::refresh()
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	this->refreshLocked();
+}
+
+bool RegionList::empty() const
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->regions.empty();
+}
+
+bool RegionList::query(const MemoryAddress &adr, const MemoryAddress &lowest, const MemoryAddress &highest, MemoryInformation& meminfo, MemoryAddress &nextAdr)
+{
+	// adr and nextAdr can be the same variable
+	auto address = adr;
+
+	std::lock_guard<std::mutex> lock(this->mutex);
+	if (address <= lowest)
+		this->refreshLocked();
+	return RegionList::find(this->regions, address, highest, meminfo, nextAdr);
+}
+
+bool RegionList::isWithinModule(MemoryAddress &start, MemoryAddress &end) const
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->moduleBounds.contains(start, end);
+}
+
+bool RegionList::getMainModuleBounds(MemoryAddress &start, MemoryAddress &end) const
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	start = this->mainModuleStart;
+	end = this->mainModuleEnd;
+	return (start != end);
+}
+
+void RegionList::getModules(ModuleInformationCollection &modules) const
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	modules = this->modules;
+}
+
+bool RegionList::find(const MemoryInformationCollection &regions, const MemoryAddress &adr, const MemoryAddress &highest, MemoryInformation& meminfo, MemoryAddress &nextAdr)
+{
+	// adr and nextAdr can be the same variable
+	auto address = adr;
+
+	// the first region that ends above us either holds us, or has free space before it
+	auto region = std::upper_bound(
+		regions.cbegin(), regions.cend(), address,
+		[](const MemoryAddress &address, const MemoryInformation &region) -> bool
+		{
+			return (address < region.allocationEnd);
+		}
+	);
+
+	if (region == regions.cend())
+	{
+		nextAdr = highest;
+		return false;
+	}
+
+	if (address >= region->allocationBase)
+	{
+		meminfo = *region;
+		nextAdr = meminfo.allocationEnd;
+		return true;
+	}
+
+	// free space, which gets reported like VirtualQuery reports it
+	meminfo.isModule = meminfo.isCommitted = meminfo.isMirror = false;
+	meminfo.isWriteable = meminfo.isExecutable = false;
+	meminfo.isMappedImage = meminfo.isMapped = false;
+	meminfo.allocationBase = address;
+	meminfo.allocationEnd = region->allocationBase;
+	meminfo.allocationSize = (size_t)meminfo.allocationEnd - (size_t)meminfo.allocationBase;
+
+	nextAdr = meminfo.allocationEnd;
+	return true;
+}
+
+void RegionList::refreshLocked()
+{
+	this->regions.clear();
+	this->modules.clear();
+	this->moduleBounds.clear();
+	this->lister(this->regions, this->modules);
+
+	for (auto module = this->modules.cbegin(); module != this->modules.cend(); module++)
+		this->moduleBounds.insert(module->base, module->end);
+
+	if (this->modules.size())
+	{
+		this->mainModuleStart = this->modules.front().base;
+		this->mainModuleEnd = this->modules.front().end;
+	}
+	else
+		this->mainModuleStart = this->mainModuleEnd = nullptr;
+
+	for (auto region = this->regions.begin(); region != this->regions.end(); region++)
+		region->isModule = this->moduleBounds.contains(region->allocationBase, region->allocationEnd);
+}
\ No newline at end of file
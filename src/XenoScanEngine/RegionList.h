@@ -0,0 +1,51 @@
+#pragma once
+
+#ifndef XENOSCANENGINE_LIB
+#error This header is for internal library use. Include "ScannerTarget.h" instead.
+#endif
+
+#include <functional>
+#include <mutex>
+
+#include "ScannerTypes.h"
+
+
+// The regions and modules of a process, for targets which can only list them
+// all at once (like from /proc/<pid>/maps). The list is taken when a walk starts
+// (a query at the lowest address) and used for the queries after it, so regions
+// that show up in the middle of a walk look like free space until the next one.
+// Everything here locks, so one list can be shared by all of a target's threads.
+class RegionList
+{
+public:
+	// fills in the regions in ascending order, without the free space between
+	// them, and the modules with the main one first
+	typedef std::function<void(MemoryInformationCollection&, ModuleInformationCollection&)> Lister;
+
+	RegionList(const Lister &lister);
+
+	// lists the regions again, and works out which of them are in modules
+	void refresh();
+	bool empty() const;
+
+	bool query(const MemoryAddress &adr, const MemoryAddress &lowest, const MemoryAddress &highest, MemoryInformation& meminfo, MemoryAddress &nextAdr);
+
+	bool isWithinModule(MemoryAddress &start, MemoryAddress &end) const;
+	bool getMainModuleBounds(MemoryAddress &start, MemoryAddress &end) const;
+	void getModules(ModuleInformationCollection &modules) const;
+
+	// looks adr up in regions (sorted, without free space), the way queryMemory()
+	// does: the space between regions is reported like VirtualQuery reports it
+	static bool find(const MemoryInformationCollection &regions, const MemoryAddress &adr, const MemoryAddress &highest, MemoryInformation& meminfo, MemoryAddress &nextAdr);
+
+private:
+	Lister lister;
+
+	mutable std::mutex mutex;
+	MemoryInformationCollection regions;
+	ModuleInformationCollection modules;
+	MemoryAddressBounds moduleBounds;
+	MemoryAddress mainModuleStart, mainModuleEnd;
+
+	void refreshLocked();
+};
\ No newline at end of file
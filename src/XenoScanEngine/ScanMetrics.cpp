@@ -0,0 +1,116 @@
+#include "ScanMetrics.h"
+
+
+static inline double toMilliseconds(const ScanMetricsRecorder::Clock::duration &time)
+{
+	return std::chrono::duration<double, std::milli>(time).count();
+}
+
+double ScanMetrics::Thread::getMegabytesPerSecond() const
+{
+	auto busy = this->readMilliseconds + this->scanMilliseconds;
+	if (busy <= 0)
+		return 0;
+	return ((double)this->bytesScanned / (1024.0 * 1024.0)) / (busy / 1000.0);
+}
+
+ScanMetrics::ScanMetrics()
+{
+	this->clear();
+}
+
+void ScanMetrics::clear()
+{
+	this->operation.clear();
+	this->phases.clear();
+	this->threads.clear();
+	this->milliseconds = 0;
+	this->blocks = this->bytesRead = this->bytesScanned = this->readFailures = this->matches = 0;
+	this->lockWaitMilliseconds = 0;
+	this->copiedBlocks = 0;
+}
+
+
+ScanMetricsRecorder::ThreadCounters::ThreadCounters() :
+	bytesRead(0), bytesScanned(0), readFailures(0),
+	read(Clock::duration::zero()), scan(Clock::duration::zero()), lockWait(Clock::duration::zero())
+{
+}
+
+ScanMetricsRecorder::PhaseTimer::PhaseTimer(ScanMetricsRecorder* recorder, const char* name) :
+	recorder(recorder), name(name)
+{
+	if (this->recorder)
+		this->start = Clock::now();
+}
+
+ScanMetricsRecorder::PhaseTimer::~PhaseTimer()
+{
+	if (this->recorder)
+		this->recorder->addPhase(this->name, Clock::now() - this->start);
+}
+
+ScanMetricsRecorder::ScanMetricsRecorder(const std::string &operation) :
+	operation(operation), blocks(0), copiedBlocks(0), start(Clock::now())
+{
+}
+
+ScanMetricsRecorder::ThreadCounters& ScanMetricsRecorder::getThreadCounters()
+{
+	// map nodes don't move, so the reference stays good as other threads are added
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->threads[std::this_thread::get_id()];
+}
+
+void ScanMetricsRecorder::addBlocks(const uint64_t &count)
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	this->blocks += count;
+}
+
+void ScanMetricsRecorder::addCopiedBlocks(const uint64_t &count)
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	this->copiedBlocks += count;
+}
+
+void ScanMetricsRecorder::addPhase(const char* name, const Clock::duration &time)
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	ScanMetrics::Phase phase;
+	phase.name = name;
+	phase.milliseconds = toMilliseconds(time);
+	this->phases.push_back(phase);
+}
+
+void ScanMetricsRecorder::finish(const uint64_t &matches, ScanMetrics &metrics)
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+
+	metrics.clear();
+	metrics.operation = this->operation;
+	metrics.phases = this->phases;
+	metrics.milliseconds = toMilliseconds(Clock::now() - this->start);
+	metrics.blocks = this->blocks;
+	metrics.copiedBlocks = this->copiedBlocks;
+	metrics.matches = matches;
+
+	for (auto thread = this->threads.cbegin(); thread != this->threads.cend(); thread++)
+	{
+		auto &counters = thread->second;
+
+		ScanMetrics::Thread result;
+		result.bytesRead = counters.bytesRead;
+		result.bytesScanned = counters.bytesScanned;
+		result.readFailures = counters.readFailures;
+		result.readMilliseconds = toMilliseconds(counters.read);
+		result.scanMilliseconds = toMilliseconds(counters.scan);
+		result.lockWaitMilliseconds = toMilliseconds(counters.lockWait);
+		metrics.threads.push_back(result);
+
+		metrics.bytesRead += result.bytesRead;
+		metrics.bytesScanned += result.bytesScanned;
+		metrics.readFailures += result.readFailures;
+		metrics.lockWaitMilliseconds += result.lockWaitMilliseconds;
+	}
+}
\ No newline at end of file
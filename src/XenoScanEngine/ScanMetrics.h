@@ -0,0 +1,97 @@
+#pragma once
+#include <stdint.h>
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+// What one scan spent its time on. Reads vs. compares (per thread) and lock waits
+// tell an I/O-bound scan from a comparator-bound one, and the phases show how
+// much of it was merging the results afterwards.
+struct ScanMetrics
+{
+	struct Phase
+	{
+		std::string name;
+		double milliseconds;
+	};
+
+	struct Thread
+	{
+		uint64_t bytesRead, bytesScanned, readFailures;
+		double readMilliseconds, scanMilliseconds, lockWaitMilliseconds;
+
+		// what the thread got through while it was busy reading and scanning
+		double getMegabytesPerSecond() const;
+	};
+
+	std::string operation; // "scan", "rescan" or "structure scan"
+	std::vector<Phase> phases;
+	std::vector<Thread> threads;
+
+	double milliseconds;
+	uint64_t blocks, bytesRead, bytesScanned, readFailures, matches;
+	double lockWaitMilliseconds;
+
+	// how many blocks a consistent scan copied while the target was suspended.
+	// zero when it couldn't suspend the target and scanned it live instead
+	uint64_t copiedBlocks;
+
+	ScanMetrics();
+	void clear();
+};
+
+
+// Collects ScanMetrics while a scan runs. Scans are handed a null recorder when
+// nobody asked for metrics, so every hook starts with a pointer check and costs
+// nothing else. Each worker thread gets its own counters, which it alone writes
+// to, and they're only added up by finish() once the workers are done.
+class ScanMetricsRecorder
+{
+public:
+	typedef std::chrono::steady_clock Clock;
+
+	struct ThreadCounters
+	{
+		uint64_t bytesRead, bytesScanned, readFailures;
+		Clock::duration read, scan, lockWait;
+
+		ThreadCounters();
+	};
+
+	// times everything between construction and destruction as one phase
+	class PhaseTimer
+	{
+	public:
+		PhaseTimer(ScanMetricsRecorder* recorder, const char* name);
+		~PhaseTimer();
+
+	private:
+		ScanMetricsRecorder* recorder;
+		const char* name;
+		Clock::time_point start;
+	};
+
+	ScanMetricsRecorder(const std::string &operation);
+
+	// the counters belonging to the calling thread. this takes a lock, so
+	// threads should look theirs up once per chunk of work, not per value
+	ThreadCounters& getThreadCounters();
+	void addBlocks(const uint64_t &count);
+	void addCopiedBlocks(const uint64_t &count);
+
+	void finish(const uint64_t &matches, ScanMetrics &metrics);
+
+private:
+	std::mutex mutex;
+	std::map<std::thread::id, ThreadCounters> threads;
+	std::vector<ScanMetrics::Phase> phases;
+	std::string operation;
+	uint64_t blocks, copiedBlocks;
+	Clock::time_point start;
+
+	void addPhase(const char* name, const Clock::duration &time);
+};
\ No newline at end of file
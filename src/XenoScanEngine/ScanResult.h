@@ -49,6 +49,11 @@ public:
 		return ScanVariant::FromMemoryAddress(this->adr);
 	}
 
+	inline const MemoryAddress& getAddress() const
+	{
+		return this->adr;
+	}
+
 private:
 	std::string asString;
 	MemoryAddress adr;
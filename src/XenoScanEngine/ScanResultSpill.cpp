@@ -0,0 +1,553 @@
+#include "ScanResultSpill.h"
+#include "Trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <queue>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+
+static inline size_t countTrailingZeros(const uint64_t &value)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	if (_BitScanForward(&index, (unsigned long)(value & 0xFFFFFFFF)))
+		return index;
+	_BitScanForward(&index, (unsigned long)(value >> 32));
+	return index + 32;
+#else
+	return __builtin_ctzll(value);
+#endif
+}
+
+static inline size_t countSetBits(const uint64_t &value)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+	return (size_t)__popcnt64(value);
+#elif defined(_MSC_VER)
+	return (size_t)(__popcnt((unsigned int)(value & 0xFFFFFFFF)) + __popcnt((unsigned int)(value >> 32)));
+#else
+	return (size_t)__builtin_popcountll(value);
+#endif
+}
+
+
+ScanResultSpillFile::ScanResultSpillFile(const std::string &path, const size_t &count, const size_t &locationCount, const ContainerDirectory &directory) :
+	path(path), count(count), locationCount(locationCount), directory(directory),
+	file(path, std::ios::binary), windowStart(0)
+{
+}
+
+ScanResultSpillFile::~ScanResultSpillFile()
+{
+	this->file.close();
+	std::remove(this->path.c_str());
+}
+
+SpilledScanResult ScanResultSpillFile::get(const size_t &index) const
+{
+	ASSERT(index < this->count);
+
+	// results are almost always read front to back, so the
+	// window (one decoded container) only moves when a read falls outside of it
+	if (index < this->windowStart || index >= this->windowStart + this->window.size())
+	{
+		auto entry = std::upper_bound(this->directory.cbegin(), this->directory.cend(), index,
+			[](const size_t &hit, const ContainerEntry &entry) -> bool { return hit < entry.firstHit; }
+		);
+		ASSERT(entry != this->directory.cbegin());
+		entry--;
+
+		SpillContainerHeader header;
+		this->file.clear();
+		this->file.seekg(static_cast<std::streamoff>(entry->fileOffset));
+		this->file.read(reinterpret_cast<char*>(&header), sizeof(header));
+		if (this->file)
+		{
+			this->containerData.resize(sizeof(header) + header.dataSize);
+			memcpy(&this->containerData[0], &header, sizeof(header));
+			this->file.read(reinterpret_cast<char*>(&this->containerData[sizeof(header)]), header.dataSize);
+		}
+
+		this->window.clear();
+		this->windowStart = (size_t)entry->firstHit;
+		if (!this->file || !ScanResultSpillFile::decodeContainer(&this->containerData[0], this->containerData.size(), this->window) ||
+			index >= this->windowStart + this->window.size())
+		{
+			// the file is ours and was complete when we got it, so this really shouldn't happen
+			ASSERT(false);
+			this->window.clear();
+			SpilledScanResult empty = { 0, 0 };
+			return empty;
+		}
+	}
+	return this->window[index - this->windowStart];
+}
+
+bool ScanResultSpillFile::encodeContainer(const std::vector<SpilledScanResult> &results, std::vector<uint8_t> &data)
+{
+	if (results.empty())
+		return false;
+
+	SpillContainerHeader header;
+	memset(&header, 0, sizeof(header));
+	header.base = results[0].address & ~(uint64_t)(ContainerSpan - 1);
+	header.hitCount = (uint32_t)results.size();
+
+	// group the needles by location, and give each distinct set of them an index
+	std::vector<uint16_t> offsets, setIndexes;
+	std::vector<std::vector<uint32_t>> sets;
+	std::map<std::vector<uint32_t>, uint16_t> setLookup;
+	std::vector<uint32_t> current;
+	auto finishLocation = [&]() -> void
+	{
+		auto found = setLookup.find(current);
+		if (found == setLookup.end())
+		{
+			found = setLookup.emplace(current, (uint16_t)sets.size()).first;
+			sets.push_back(current);
+		}
+		setIndexes.push_back(found->second);
+		current.clear();
+	};
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		ASSERT((results[i].address & ~(uint64_t)(ContainerSpan - 1)) == header.base);
+		auto offset = (uint16_t)(results[i].address - header.base);
+		if (i == 0 || offset != offsets.back())
+		{
+			if (i != 0)
+				finishLocation();
+			offsets.push_back(offset);
+		}
+		current.push_back(results[i].needle);
+	}
+	finishLocation();
+	header.locationCount = (uint32_t)offsets.size();
+	header.needleSetCount = (uint32_t)sets.size();
+
+	// the slots of a bitmap are as big as the locations are aligned, up to 8 bytes
+	uint8_t slotShift = 3;
+	for (auto offset = offsets.cbegin(); offset != offsets.cend() && slotShift; offset++)
+	{
+		while (slotShift && (*offset & ((1 << slotShift) - 1)))
+			slotShift--;
+	}
+	auto bitmapSize = (ContainerSpan >> slotShift) / 8;
+	auto listSize = offsets.size() * sizeof(uint16_t);
+
+	auto headerAt = data.size();
+	data.resize(headerAt + sizeof(header));
+	auto append = [&data](const void* bytes, const size_t &size) -> void
+	{
+		auto at = data.size();
+		data.resize(at + size);
+		memcpy(&data[at], bytes, size);
+	};
+
+	if (bitmapSize < listSize)
+	{
+		header.encoding = SPILL_CONTAINER_BITMAP;
+		header.slotShift = slotShift;
+		std::vector<uint64_t> bitmap(bitmapSize / sizeof(uint64_t), 0);
+		for (auto offset = offsets.cbegin(); offset != offsets.cend(); offset++)
+		{
+			auto slot = (size_t)(*offset >> slotShift);
+			bitmap[slot / 64] |= (1ULL << (slot % 64));
+		}
+		append(&bitmap[0], bitmapSize);
+	}
+	else
+	{
+		header.encoding = SPILL_CONTAINER_OFFSETS;
+		append(&offsets[0], listSize);
+	}
+
+	for (auto set = sets.cbegin(); set != sets.cend(); set++)
+	{
+		auto setSize = (uint32_t)set->size();
+		append(&setSize, sizeof(setSize));
+		append(&(*set)[0], set->size() * sizeof(uint32_t));
+	}
+
+	// when every location has the same needles, the indexes aren't needed,
+	// and they only need a byte each unless there are a lot of different sets
+	if (sets.size() > 256)
+		append(&setIndexes[0], setIndexes.size() * sizeof(uint16_t));
+	else if (sets.size() > 1)
+	{
+		std::vector<uint8_t> narrowIndexes(setIndexes.begin(), setIndexes.end());
+		append(&narrowIndexes[0], narrowIndexes.size());
+	}
+
+	header.dataSize = (uint32_t)(data.size() - headerAt - sizeof(header));
+	memcpy(&data[headerAt], &header, sizeof(header));
+	return true;
+}
+
+bool ScanResultSpillFile::decodeContainer(const uint8_t* data, const size_t &size, std::vector<SpilledScanResult> &results)
+{
+	SpillContainerHeader header;
+	if (size < sizeof(header))
+		return false;
+	memcpy(&header, data, sizeof(header));
+	if (size - sizeof(header) < header.dataSize || header.locationCount > ContainerSpan || header.slotShift > 3)
+		return false;
+
+	auto at = sizeof(header);
+	auto end = sizeof(header) + header.dataSize;
+
+	std::vector<uint16_t> offsets;
+	offsets.reserve(header.locationCount);
+	if (header.encoding == SPILL_CONTAINER_BITMAP)
+	{
+		auto bitmapSize = (ContainerSpan >> header.slotShift) / 8;
+		if (end - at < bitmapSize)
+			return false;
+
+		// count first, so a bad header can't make us write past the locations
+		std::vector<uint64_t> bitmap(bitmapSize / sizeof(uint64_t));
+		memcpy(&bitmap[0], &data[at], bitmapSize);
+		at += bitmapSize;
+
+		size_t setBits = 0;
+		for (auto word = bitmap.cbegin(); word != bitmap.cend(); word++)
+			setBits += countSetBits(*word);
+		if (setBits != header.locationCount)
+			return false;
+
+		for (size_t i = 0; i < bitmap.size(); i++)
+		{
+			auto word = bitmap[i];
+			while (word)
+			{
+				offsets.push_back((uint16_t)(((i * 64) + countTrailingZeros(word)) << header.slotShift));
+				word &= (word - 1);
+			}
+		}
+	}
+	else if (header.encoding == SPILL_CONTAINER_OFFSETS)
+	{
+		auto listSize = header.locationCount * sizeof(uint16_t);
+		if (end - at < listSize)
+			return false;
+		offsets.resize(header.locationCount);
+		if (listSize)
+			memcpy(&offsets[0], &data[at], listSize);
+		at += listSize;
+	}
+	else
+		return false;
+
+	std::vector<std::vector<uint32_t>> sets(header.needleSetCount);
+	for (auto set = sets.begin(); set != sets.end(); set++)
+	{
+		uint32_t setSize;
+		if (end - at < sizeof(setSize))
+			return false;
+		memcpy(&setSize, &data[at], sizeof(setSize));
+		at += sizeof(setSize);
+
+		if ((end - at) / sizeof(uint32_t) < setSize)
+			return false;
+		set->resize(setSize);
+		if (setSize)
+			memcpy(&(*set)[0], &data[at], setSize * sizeof(uint32_t));
+		at += setSize * sizeof(uint32_t);
+	}
+	if (sets.empty())
+		return false;
+
+	std::vector<uint16_t> setIndexes(offsets.size(), 0);
+	if (sets.size() > 256)
+	{
+		auto indexSize = setIndexes.size() * sizeof(uint16_t);
+		if (end - at < indexSize)
+			return false;
+		memcpy(&setIndexes[0], &data[at], indexSize);
+	}
+	else if (sets.size() > 1)
+	{
+		if (end - at < setIndexes.size())
+			return false;
+		for (size_t i = 0; i < setIndexes.size(); i++)
+			setIndexes[i] = data[at + i];
+	}
+
+	auto first = results.size();
+	results.reserve(first + header.hitCount);
+	for (size_t i = 0; i < offsets.size(); i++)
+	{
+		if (setIndexes[i] >= sets.size())
+			return false;
+
+		auto &set = sets[setIndexes[i]];
+		for (auto needle = set.cbegin(); needle != set.cend(); needle++)
+		{
+			SpilledScanResult result;
+			result.address = header.base + offsets[i];
+			result.needle = *needle;
+			results.push_back(result);
+		}
+	}
+	return (results.size() - first == header.hitCount);
+}
+
+
+ScanResultSpillWriter::ScanResultSpillWriter(const size_t &runSize) :
+	runSize(runSize), failed(false)
+{
+}
+
+ScanResultSpillWriter::~ScanResultSpillWriter()
+{
+	for (auto run = this->runs.cbegin(); run != this->runs.cend(); run++)
+		std::remove(run->c_str());
+}
+
+void ScanResultSpillWriter::add(const MemoryAddress &address, const uint32_t &needle)
+{
+	SpilledScanResult result;
+	result.address = (uint64_t)address;
+	result.needle = needle;
+	this->buffer.push_back(result);
+
+	if (this->buffer.size() >= this->runSize)
+		this->addRun(this->buffer);
+}
+
+void ScanResultSpillWriter::addRun(std::vector<SpilledScanResult> &results)
+{
+	if (results.empty())
+		return;
+	Trace::Scope scope("spill", "run");
+
+	std::sort(results.begin(), results.end());
+
+	auto path = ScanResultSpillWriter::makeTemporaryPath();
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file.write(reinterpret_cast<const char*>(&results[0]), results.size() * sizeof(SpilledScanResult));
+	file.close();
+	results.clear();
+
+	// the run gets tracked even if it failed, so that it gets cleaned up
+	std::lock_guard<std::mutex> lock(this->runsMutex);
+	this->runs.push_back(path);
+	if (!file)
+		this->failed = true;
+}
+
+ScanResultSpillFileShPtr ScanResultSpillWriter::finish()
+{
+	Trace::Scope scope("spill", "finish");
+	this->addRun(this->buffer);
+	if (this->failed)
+		return nullptr;
+
+	// a k-way merge of the runs, each read through its own slice of the merge buffer
+	struct RunReader
+	{
+		std::ifstream file;
+		std::vector<SpilledScanResult> buffer;
+		size_t position, sliceSize;
+
+		bool next(SpilledScanResult &result)
+		{
+			if (this->position >= this->buffer.size())
+			{
+				this->buffer.resize(this->sliceSize);
+				this->file.read(reinterpret_cast<char*>(&this->buffer[0]), this->sliceSize * sizeof(SpilledScanResult));
+				auto got = static_cast<size_t>(this->file.gcount()) / sizeof(SpilledScanResult);
+				this->buffer.resize(got);
+				this->position = 0;
+				if (!got)
+					return false;
+			}
+			result = this->buffer[this->position++];
+			return true;
+		}
+	};
+
+	auto sliceSize = std::max((size_t)1024, MergeBufferSize / std::max((size_t)1, this->runs.size()));
+	std::vector<std::unique_ptr<RunReader>> readers;
+	for (auto run = this->runs.cbegin(); run != this->runs.cend(); run++)
+	{
+		auto reader = std::make_unique<RunReader>();
+		reader->file.open(*run, std::ios::binary);
+		reader->position = 0;
+		reader->sliceSize = sliceSize;
+		if (!reader->file.is_open())
+			return nullptr;
+		readers.push_back(std::move(reader));
+	}
+
+	typedef std::pair<SpilledScanResult, size_t> QueueEntry;
+	auto later = [](const QueueEntry &a, const QueueEntry &b) -> bool { return b.first < a.first; };
+	std::priority_queue<QueueEntry, std::vector<QueueEntry>, decltype(later)> queue(later);
+	for (size_t i = 0; i < readers.size(); i++)
+	{
+		SpilledScanResult result;
+		if (readers[i]->next(result))
+			queue.push(std::make_pair(result, i));
+	}
+
+	// the merged results are gathered up a container at a time
+	auto path = ScanResultSpillWriter::makeTemporaryPath();
+	std::ofstream output(path, std::ios::binary | std::ios::trunc);
+	ScanResultSpillFile::ContainerDirectory directory;
+	std::vector<SpilledScanResult> container;
+	std::vector<uint8_t> encoded;
+	uint64_t fileOffset = 0;
+
+	size_t count = 0, locationCount = 0;
+	auto writeContainer = [&]() -> void
+	{
+		encoded.clear();
+		if (!ScanResultSpillFile::encodeContainer(container, encoded))
+			return;
+
+		ScanResultSpillFile::ContainerEntry entry;
+		entry.fileOffset = fileOffset;
+		entry.firstHit = count;
+		directory.push_back(entry);
+
+		output.write(reinterpret_cast<const char*>(&encoded[0]), encoded.size());
+		fileOffset += encoded.size();
+		count += container.size();
+		container.clear();
+	};
+
+	bool hasLast = false;
+	SpilledScanResult last = { 0, 0 };
+	while (!queue.empty())
+	{
+		auto entry = queue.top();
+		queue.pop();
+
+		SpilledScanResult result;
+		if (readers[entry.second]->next(result))
+			queue.push(std::make_pair(result, entry.second));
+
+		if (hasLast && entry.first == last)
+			continue;
+		if (!hasLast || entry.first.address != last.address)
+			locationCount++;
+		if (hasLast && (entry.first.address / ScanResultSpillFile::ContainerSpan) != (last.address / ScanResultSpillFile::ContainerSpan))
+			writeContainer();
+		last = entry.first;
+		hasLast = true;
+
+		container.push_back(entry.first);
+	}
+	writeContainer();
+	output.close();
+
+	// the runs aren't needed once they're merged
+	readers.clear();
+	for (auto run = this->runs.cbegin(); run != this->runs.cend(); run++)
+		std::remove(run->c_str());
+	this->runs.clear();
+
+	if (!output)
+	{
+		std::remove(path.c_str());
+		return nullptr;
+	}
+
+	return std::make_shared<ScanResultSpillFile>(path, count, locationCount, directory);
+}
+
+ScanValueStore::ScanValueStore(const bool &spill) :
+	spilling(spill), written(0), windowStart(0)
+{
+	if (!this->spilling)
+		return;
+
+	this->path = ScanResultSpillWriter::makeTemporaryPath();
+	this->file.open(this->path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+	this->spilling = this->file.is_open();
+}
+
+ScanValueStore::~ScanValueStore()
+{
+	if (this->path.empty())
+		return;
+	this->file.close();
+	std::remove(this->path.c_str());
+}
+
+void ScanValueStore::append(const uint8_t* data, const size_t &size)
+{
+	this->buffer.insert(this->buffer.end(), data, data + size);
+	if (!this->spilling || this->buffer.size() < BufferSize)
+		return;
+
+	Trace::Scope scope("spill", "values");
+	this->file.clear();
+	this->file.seekp(static_cast<std::streamoff>(this->written));
+	this->file.write(reinterpret_cast<const char*>(&this->buffer[0]), this->buffer.size());
+	this->file.flush();
+	if (!this->file)
+	{
+		// keep everything from here on in memory instead
+		this->spilling = false;
+		return;
+	}
+	this->written += this->buffer.size();
+	this->buffer.clear();
+}
+
+void ScanValueStore::read(const uint64_t &offset, uint8_t* data, const size_t &size) const
+{
+	ASSERT(offset + size <= this->size());
+
+	// values never straddle the end of the file, since it only ever ends between them
+	if (offset >= this->written)
+	{
+		memcpy(data, &this->buffer[(size_t)(offset - this->written)], size);
+		return;
+	}
+
+	if (offset < this->windowStart || offset + size > this->windowStart + this->window.size())
+	{
+		auto windowSize = (size_t)std::min((uint64_t)std::max(WindowSize, size), this->written - offset);
+		this->window.resize(windowSize);
+		this->windowStart = offset;
+
+		this->file.clear();
+		this->file.seekg(static_cast<std::streamoff>(offset));
+		this->file.read(reinterpret_cast<char*>(&this->window[0]), windowSize);
+		if (!this->file || offset + size > this->windowStart + this->window.size())
+		{
+			// the file is ours and everything before written made it there, so this really shouldn't happen
+			ASSERT(false);
+			this->window.clear();
+			memset(data, 0, size);
+			return;
+		}
+	}
+	memcpy(data, &this->window[(size_t)(offset - this->windowStart)], size);
+}
+
+std::string ScanResultSpillWriter::makeTemporaryPath()
+{
+	// a counter keeps our own names apart, and the time keeps us apart from other instances
+	static std::atomic<uint64_t> counter(0);
+	auto now = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+
+	std::error_code error;
+	auto directory = std::filesystem::temp_directory_path(error);
+	if (error)
+		directory = ".";
+
+	auto name = "xenoscan-" + std::to_string(now) + "-" + std::to_string(counter++) + ".results";
+	return (directory / name).string();
+}
\ No newline at end of file
@@ -0,0 +1,174 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <mutex>
+
+#include "Assert.h"
+#include "ScannerTypes.h"
+
+
+// A scan result that lives on disk: where it was found, and which of the
+// scan's needles found it. It's only 12 bytes, where an in-memory result costs
+// a shared location and a vector of values, so billions of them are fine.
+#pragma pack(push, 1)
+struct SpilledScanResult
+{
+	uint64_t address;
+	uint32_t needle;
+
+	inline bool operator<(const SpilledScanResult &other) const
+	{
+		return (this->address < other.address) || (this->address == other.address && this->needle < other.needle);
+	}
+	inline bool operator==(const SpilledScanResult &other) const
+	{
+		return (this->address == other.address && this->needle == other.needle);
+	}
+};
+#pragma pack(pop)
+
+
+// Spilled results are stored in containers, one for each 64KB of address space
+// that has any. A container lists the locations it has either as sorted offsets
+// or as a bitmap of aligned slots (like a roaring bitmap), whichever is smaller,
+// so dense results (scanning for 0 finds nearly every slot) cost a bit or two
+// per location. The needles found at each location come after that, as a small
+// table of distinct sets of needles (since most locations have the same ones)
+// and, if there's more than one set, an 8 or 16 bit set index per location.
+enum SpillContainerEncoding : uint8_t
+{
+	SPILL_CONTAINER_OFFSETS,
+	SPILL_CONTAINER_BITMAP
+};
+
+#pragma pack(push, 1)
+struct SpillContainerHeader
+{
+	uint64_t base;
+	uint32_t locationCount;
+	uint32_t hitCount;
+	uint8_t encoding;
+	uint8_t slotShift; // bitmap slots are (1 << slotShift) bytes
+	uint8_t reserved[2];
+	uint32_t needleSetCount;
+	uint32_t dataSize; // bytes after the header
+};
+#pragma pack(pop)
+
+
+// The spilled results of a scan, sorted by address. Reads decode one container
+// at a time, so walking it front to back only needs a little memory.
+// The file is deleted when this is destroyed.
+class ScanResultSpillFile
+{
+public:
+	struct ContainerEntry
+	{
+		uint64_t fileOffset;
+		uint64_t firstHit;
+	};
+	typedef std::vector<ContainerEntry> ContainerDirectory;
+
+	ScanResultSpillFile(const std::string &path, const size_t &count, const size_t &locationCount, const ContainerDirectory &directory);
+	~ScanResultSpillFile();
+
+	inline size_t size() const { return this->count; }
+	inline size_t getLocationCount() const { return this->locationCount; }
+	inline size_t getContainerCount() const { return this->directory.size(); }
+
+	SpilledScanResult get(const size_t &index) const;
+
+	static constexpr size_t ContainerSpan = 0x10000;
+
+	// encodes the results of one container (all sorted, unique and in the
+	// same span) onto the end of data, returning false if there are none
+	static bool encodeContainer(const std::vector<SpilledScanResult> &results, std::vector<uint8_t> &data);
+	static bool decodeContainer(const uint8_t* data, const size_t &size, std::vector<SpilledScanResult> &results);
+
+private:
+	std::string path;
+	size_t count, locationCount;
+	ContainerDirectory directory;
+
+	mutable std::ifstream file;
+	mutable std::vector<uint8_t> containerData;
+	mutable std::vector<SpilledScanResult> window;
+	mutable size_t windowStart;
+};
+typedef std::shared_ptr<ScanResultSpillFile> ScanResultSpillFileShPtr;
+
+
+// Collects results in memory until there are runSize of them, then sorts them and
+// writes them out as a run. finish() merges the runs into one ScanResultSpillFile,
+// so memory use is bounded by the run size no matter how many results there are.
+// add() and finish() aren't thread safe, but callers that gather up their own
+// runs can write them with addRun() from any thread (and outside of their locks)
+class ScanResultSpillWriter
+{
+public:
+	ScanResultSpillWriter(const size_t &runSize = DefaultRunSize);
+	~ScanResultSpillWriter();
+
+	void add(const MemoryAddress &address, const uint32_t &needle);
+	void addRun(std::vector<SpilledScanResult> &results);
+	inline size_t getRunSize() const { return this->runSize; }
+	inline bool hasFailed() const
+	{
+		std::lock_guard<std::mutex> lock(this->runsMutex);
+		return this->failed;
+	}
+
+	// returns nullptr if anything couldn't be written
+	ScanResultSpillFileShPtr finish();
+
+	static std::string makeTemporaryPath();
+
+private:
+	static constexpr size_t DefaultRunSize = 0x800000;
+	static constexpr size_t MergeBufferSize = 0x400000;
+
+	size_t runSize;
+	std::vector<SpilledScanResult> buffer;
+
+	// guards the runs, and whether any of them failed to write
+	mutable std::mutex runsMutex;
+	std::vector<std::string> runs;
+	bool failed;
+};
+
+
+// The raw values that a re-scan kept, packed back to back. When the results
+// it scanned were spilled, so are the values: they go to a temporary file a
+// buffer at a time, and are read back through a small window (re-scans and
+// result listings walk them front to back). Anything that couldn't be written
+// just stays in memory. The file is deleted when this is destroyed.
+class ScanValueStore
+{
+public:
+	ScanValueStore(const bool &spill);
+	~ScanValueStore();
+
+	void append(const uint8_t* data, const size_t &size);
+	void read(const uint64_t &offset, uint8_t* data, const size_t &size) const;
+	inline uint64_t size() const { return this->written + this->buffer.size(); }
+	inline uint64_t getSpilledSize() const { return this->written; }
+
+private:
+	static constexpr size_t BufferSize = 0x100000;
+	static constexpr size_t WindowSize = 0x10000;
+
+	std::string path;
+	mutable std::fstream file;
+	bool spilling;
+
+	// the first written bytes are in the file, and the rest are in the buffer
+	uint64_t written;
+	std::vector<uint8_t> buffer;
+
+	mutable std::vector<uint8_t> window;
+	mutable uint64_t windowStart;
+};
+typedef std::shared_ptr<ScanValueStore> ScanValueStoreShPtr;
\ No newline at end of file
@@ -4,38 +4,159 @@
 #include "ScanVariant.h"
 #include "ScanResult.h"
 #include "DataStructureBlueprint.h"
+#include "SharedBitset.h"
+#include "ScanResultSpill.h"
+
+#include <algorithm>
 
 class ScanState
 {
 public:
-	ScanState() : firstScan(true), firstResults(), lastResults(), foundStructures() {}
+	/*
+		Every hit of the first scan (a location, and a typed value found there) is
+		kept in one array, grouped by location. Each scan after that is a generation:
+		a bitset over that array saying which hits are still results, along with the
+		raw bytes those hits had when that scan read them, packed back to back. The
+		first scan's values say how to turn the bytes back into values, so the history
+		costs one bit per hit plus the size of each result's value (4 bytes for an
+		int32) per generation, and switching between generations (to undo a scan,
+		or to look at an older one) is free. If the first scan's results were spilled
+		to disk, the values of the generations after it are too.
+	*/
+	class ResultIterator
+	{
+	public:
+		ResultIterator(const ScanState* state, const size_t &hit) :
+			state(state), hit(hit), offset(0),
+			end((hit < state->hitCount()) ? state->findLocationEnd(hit) : hit)
+		{}
+
+		inline ScanResultLocationShPtr getLocation() const
+		{
+			return this->state->getHitLocation(this->hit);
+		}
+
+		// the values (as of the scan that kept them) which are still results at this
+		// location, along with their index in the first scan's hits if indexes is given
+		void getResults(ScanResultCollection &results, std::vector<size_t>* indexes = nullptr) const
+		{
+			auto &hits = this->state->getCurrentHits();
+			auto offset = this->offset;
+			for (auto hit = this->hit; hit < this->end; hit = hits.findNext(hit + 1))
+			{
+				results.push_back(this->state->getResultValue(hit, offset));
+				offset += this->state->getHitSize(hit);
+				if (indexes)
+					indexes->push_back(hit);
+			}
+		}
+
+		inline ResultIterator& operator++()
+		{
+			auto &hits = this->state->getCurrentHits();
+			for (auto hit = this->hit; hit < this->end; hit = hits.findNext(hit + 1))
+				this->offset += this->state->getHitSize(hit);
+			this->hit = hits.findNext(this->end);
+			this->end = (this->hit < this->state->hitCount()) ? this->state->findLocationEnd(this->hit) : this->hit;
+			return *this;
+		}
+		inline ResultIterator operator++(int)
+		{
+			auto old = *this;
+			++(*this);
+			return old;
+		}
+		inline bool operator==(const ResultIterator &other) const { return this->hit == other.hit; }
+		inline bool operator!=(const ResultIterator &other) const { return this->hit != other.hit; }
+
+	private:
+		const ScanState* state;
+
+		// the first hit at this location which is still a result, where its value
+		// is in the generation's values, and the end of the location's hits
+		size_t hit, offset, end;
+	};
+
+	ScanState() : firstScan(true), currentGeneration(0), foundStructures() {}
 
 	void clearScanResults()
 	{
 		this->firstScan = true;
-		this->firstResults.clear();
-		this->lastResults.clear();
+		this->locations.clear();
+		this->locationHits.clear();
+		this->hits.clear();
+		this->spilled = nullptr;
+		this->spilledNeedles.clear();
+		this->generations.clear();
+		this->currentGeneration = 0;
 	}
 
 	inline bool isFirstScan() const { return this->firstScan; }
-	void updateState(const ScanResultMap& results)
+	inline bool isSpilled() const { return this->spilled != nullptr; }
+
+	// takes the results of the first scan, emptying results
+	void updateState(ScanResultMap& results)
 	{
-		if (this->isFirstScan())
-		{
-			this->firstScan = false;
-			this->firstResults = results;
-			this->lastResults = this->firstResults;
+		ASSERT(this->isFirstScan());
+		this->firstScan = false;
 
-			printf("%zu initial matches found\n", this->lastResults.size());
-		}
-		else
+		this->locationHits.push_back(0);
+		for (auto result = results.begin(); result != results.end(); result++)
 		{
-			auto oldSize = this->lastResults.size();
-			this->lastResults = results;
-			printf("Narrowed results from %zu to %zu\n", oldSize, this->lastResults.size());
+			this->locations.push_back(result->first);
+			for (auto value = result->second.begin(); value != result->second.end(); value++)
+				this->hits.push_back(std::move(*value));
+			this->locationHits.push_back(this->hits.size());
 		}
+		results.clear();
 
-		// TODO: remove print
+		Generation generation;
+		generation.hits = SharedBitset(this->hits.size(), true);
+		generation.isLittleEndian = true;
+		generation.locationCount = this->locations.size();
+		this->generations.push_back(generation);
+		this->currentGeneration = 0;
+	}
+
+	// takes the results of a first scan which were spilled to disk. the results only
+	// know which needle found them, so needles stand in for the values that were found
+	void updateState(const ScanResultSpillFileShPtr &spilled, const ScanResultCollection &needles)
+	{
+		ASSERT(this->isFirstScan());
+		this->firstScan = false;
+
+		this->spilled = spilled;
+		this->spilledNeedles = needles;
+
+		Generation generation;
+		generation.hits = SharedBitset(this->spilled->size(), true);
+		generation.isLittleEndian = true;
+		generation.locationCount = this->spilled->getLocationCount();
+		this->generations.push_back(generation);
+		this->currentGeneration = 0;
+	}
+
+	// takes the results of a re-scan, as the hits that are still results and the raw
+	// bytes they had (getHitSize() of them each, in hit order). anything newer than the
+	// current generation (which is there if a scan was undone) is thrown away
+	void updateState(SharedBitset& survivors, const ScanValueStoreShPtr &values, const bool &isLittleEndian)
+	{
+		ASSERT(!this->isFirstScan());
+		ASSERT(survivors.size() == this->hitCount());
+
+		this->generations.resize(this->currentGeneration + 1);
+
+		Generation generation;
+		generation.hits = std::move(survivors);
+		generation.hits.shareBlocksWith(this->getCurrentHits());
+		generation.values = values;
+		generation.isLittleEndian = isLittleEndian;
+		generation.locationCount = 0;
+		for (auto hit = generation.hits.findNext(0); hit < this->hitCount(); hit = generation.hits.findNext(this->findLocationEnd(hit)))
+			generation.locationCount++;
+
+		this->generations.push_back(std::move(generation));
+		this->currentGeneration++;
 	}
 
 	void updateState(DataStructureResultMap& results)
@@ -59,14 +180,137 @@ public:
 		}*/
 	}
 
-	size_t resultSize() const { return this->lastResults.size(); }
-	ScanResultMap::const_iterator beginResult() const { return this->lastResults.cbegin(); }
-	ScanResultMap::const_iterator endResult() const { return this->lastResults.cend(); }
+	// the first scan is generation 0, and each scan after it adds one
+	inline size_t getGenerationCount() const { return this->generations.size(); }
+	inline size_t getCurrentGeneration() const { return this->currentGeneration; }
+	bool setCurrentGeneration(const size_t &generation)
+	{
+		if (generation >= this->generations.size())
+			return false;
+		this->currentGeneration = generation;
+		return true;
+	}
+	bool undo()
+	{
+		if (this->currentGeneration == 0)
+			return false;
+		this->currentGeneration--;
+		return true;
+	}
+
+	// an empty set of hits for a re-scan to fill in
+	inline SharedBitset createHitSet() const { return SharedBitset(this->hitCount(), false); }
+
+	// how many bytes of a hit's value each generation keeps
+	size_t getHitSize(const size_t &hit) const
+	{
+		if (this->spilled)
+			return this->spilledNeedles[this->spilled->get(hit).needle].getSize();
+		return this->hits[hit].getSize();
+	}
+
+	size_t resultSize() const
+	{
+		return this->generations.size() ? this->generations[this->currentGeneration].locationCount : 0;
+	}
+	ResultIterator beginResult() const
+	{
+		return ResultIterator(this, this->generations.size() ? this->getCurrentHits().findNext(0) : this->hitCount());
+	}
+	ResultIterator endResult() const { return ResultIterator(this, this->hitCount()); }
 	const DataStructureResultMap foundDataStructures() const { return foundStructures; }
+	size_t foundDataStructureCount() const
+	{
+		size_t count = 0;
+		for (auto type = this->foundStructures.cbegin(); type != this->foundStructures.cend(); type++)
+			count += type->second.size();
+		return count;
+	}
 
 private:
+	struct Generation
+	{
+		SharedBitset hits;
+
+		// the bytes of each hit that's still a result, in hit order. the
+		// first scan doesn't need these, its values are the hits themselves
+		ScanValueStoreShPtr values;
+		bool isLittleEndian;
+		size_t locationCount;
+	};
+
 	bool firstScan;
-	ScanResultMap firstResults, lastResults;
+
+	// the hits of locations[i] are hits[locationHits[i]] up to hits[locationHits[i + 1]]
+	std::vector<ScanResultLocationShPtr> locations;
+	std::vector<size_t> locationHits;
+	ScanResultCollection hits;
+
+	// when the first scan had too many results to keep in memory, they're on disk
+	// instead; each one is a hit, and the locations and hits above are empty
+	ScanResultSpillFileShPtr spilled;
+	ScanResultCollection spilledNeedles;
+
+	std::vector<Generation> generations;
+	size_t currentGeneration;
+
 	DataStructureResultMap foundStructures;
+
+	inline const SharedBitset& getCurrentHits() const
+	{
+		return this->generations[this->currentGeneration].hits;
+	}
+
+	inline size_t hitCount() const
+	{
+		return this->spilled ? this->spilled->size() : this->hits.size();
+	}
+
+	inline size_t findLocation(const size_t &hit) const
+	{
+		auto owner = std::upper_bound(this->locationHits.cbegin(), this->locationHits.cend(), hit);
+		return (owner - this->locationHits.cbegin()) - 1;
+	}
+
+	ScanResultLocationShPtr getHitLocation(const size_t &hit) const
+	{
+		if (this->spilled)
+			return std::make_shared<ScanResultAddress>((MemoryAddress)this->spilled->get(hit).address);
+		return this->locations[this->findLocation(hit)];
+	}
+
+	ScanVariant getHitValue(const size_t &hit) const
+	{
+		if (this->spilled)
+			return this->spilledNeedles[this->spilled->get(hit).needle];
+		return this->hits[hit];
+	}
+
+	// the value of hit as of the current generation, where offset is where
+	// its bytes are in the generation's values
+	ScanVariant getResultValue(const size_t &hit, const size_t &offset) const
+	{
+		if (this->currentGeneration == 0)
+			return this->getHitValue(hit);
+
+		auto &generation = this->generations[this->currentGeneration];
+		std::vector<uint8_t> bytes(this->getHitSize(hit));
+		generation.values->read(offset, &bytes[0], bytes.size());
+		return ScanVariant::FromRawBuffer(&bytes[0], bytes.size(), generation.isLittleEndian, this->getHitValue(hit));
+	}
+
+	// the end of the hits at the same location as hit
+	size_t findLocationEnd(const size_t &hit) const
+	{
+		if (!this->spilled)
+			return this->locationHits[this->findLocation(hit) + 1];
+
+		// spilled hits are sorted by address, so the location's hits are all together
+		auto address = this->spilled->get(hit).address;
+		auto end = hit + 1;
+		while (end < this->spilled->size() && this->spilled->get(end).address == address)
+			end++;
+		return end;
+	}
 };
 typedef std::shared_ptr<ScanState> ScanStateShPtr;
\ No newline at end of file
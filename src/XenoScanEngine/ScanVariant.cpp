@@ -5,6 +5,10 @@
 
 #include "ScanVariantSearchContextDefault.h"
 #include "ScanVariantSearchContextString.h"
+#include "ScanVariantSearchContextStructure.h"
+#include "ScanVariantSearchContextPattern.h"
+
+#include <cctype>
 
 ScanVariantUnderlyingTypeTraits* ScanVariant::UnderlyingTypeTraits[ScanVariant::SCAN_VARIANT_NULL + 1] =
 {
@@ -31,6 +35,7 @@ ScanVariantUnderlyingTypeTraits* ScanVariant::UnderlyingTypeTraits[ScanVariant::
 	new ScanVariantUnderlyingNumericTypeTraits<uint32_t, true, false, ScanVariant::SCAN_VARIANT_INT32,   ScanVariant::SCAN_VARIANT_UINT32>(L"ticktime32", L"%u"),
 
 	new ScanVariantUnderlyingStructureTypeTraits<ScanVariant::SCAN_VARIANT_STRUCTURE, ScanVariant::SCAN_VARIANT_STRUCTURE>(),
+	new ScanVariantUnderlyingPatternTypeTraits<ScanVariant::SCAN_VARIANT_PATTERN, ScanVariant::SCAN_VARIANT_PATTERN>(),
 
 	new ScanVariantUnderlyingNullTypeTraits<ScanVariant::SCAN_VARIANT_NULL, ScanVariant::SCAN_VARIANT_NULL>()
 };
@@ -70,6 +75,20 @@ const ScanVariant ScanVariant::FromRawBuffer(const uint8_t* buffer, const size_t
 		v.setSizeAndValue();
 		return v;
 	}
+	else if (reference.isPattern())
+	{
+		// the bytes that were actually there, with nothing masked out
+		ScanVariant v;
+		v.type = reference.getType();
+
+		auto size = reference.getSize();
+		ASSERT(size <= bufferSize);
+
+		reference.getTypeTraits()->copyFromBuffer(buffer, size, isLittleEndian, &v.valuePattern);
+		v.valuePatternMask.assign(size, 0xFF);
+		v.setSizeAndValue();
+		return v;
+	}
 	else if (reference.getType() == ScanVariant::SCAN_VARIANT_ASCII_STRING)
 	{
 		auto sizeInBytes = reference.valueAsciiString.length() * sizeof(std::string::value_type); // todo maybe use the build in value size field
@@ -192,7 +211,7 @@ const ScanVariant ScanVariant::FromStringTyped(const std::string& input, const S
 }
 const ScanVariant ScanVariant::FromStringTyped(const std::wstring& input, const ScanVariantType& type)
 {
-	ASSERT(type >= SCAN_VARIANT_ALLTYPES_BEGIN && type <= SCAN_VARIANT_ALLTYPES_END);
+	ASSERT((type >= SCAN_VARIANT_ALLTYPES_BEGIN && type <= SCAN_VARIANT_ALLTYPES_END) || type == SCAN_VARIANT_PATTERN);
 
 	// TODO maybe handle dynamic types here?
 	auto traits = UnderlyingTypeTraits[type];
@@ -201,6 +220,69 @@ const ScanVariant ScanVariant::FromStringTyped(const std::wstring& input, const
 	return ret;
 }
 
+const ScanVariant ScanVariant::FromPattern(const std::string& input)
+{
+	auto hexDigit = [](const char &digit) -> int
+	{
+		if (digit >= '0' && digit <= '9') return digit - '0';
+		if (digit >= 'a' && digit <= 'f') return digit - 'a' + 10;
+		if (digit >= 'A' && digit <= 'F') return digit - 'A' + 10;
+		return -1;
+	};
+
+	ScanVariant v;
+	v.type = SCAN_VARIANT_PATTERN;
+
+	bool hasFixedBits = false;
+	size_t position = 0;
+	while (position < input.length())
+	{
+		if (isspace((unsigned char)input[position]))
+		{
+			position++;
+			continue;
+		}
+
+		size_t end = position;
+		while (end < input.length() && !isspace((unsigned char)input[end]))
+			end++;
+		auto token = input.substr(position, end - position);
+		position = end;
+
+		if (token == "?")
+			token = "??";
+		if (token.length() != 2)
+			return ScanVariant::MakeNull();
+
+		// high nibble first; a wildcard nibble is left out of the mask
+		uint8_t value = 0, mask = 0;
+		for (auto digit = token.cbegin(); digit != token.cend(); digit++)
+		{
+			value <<= 4;
+			mask <<= 4;
+			if (*digit == '?')
+				continue;
+
+			auto nibble = hexDigit(*digit);
+			if (nibble < 0)
+				return ScanVariant::MakeNull();
+			value |= (uint8_t)nibble;
+			mask |= 0x0F;
+		}
+
+		v.valuePattern.push_back(value);
+		v.valuePatternMask.push_back(mask);
+		hasFixedBits |= (mask != 0);
+	}
+
+	// a pattern of nothing but wildcards would match every byte of the target
+	if (!hasFixedBits)
+		return ScanVariant::MakeNull();
+
+	v.setSizeAndValue();
+	return v;
+}
+
 const ScanVariant ScanVariant::FromTargetMemory(const std::shared_ptr<class ScannerTarget> &target, const MemoryAddress& address, const ScanVariantType& type)
 {
 	ASSERT(target.get());
@@ -271,6 +353,11 @@ const bool ScanVariant::isCompatibleWith(const ScanVariant& other, const bool st
 				return false;
 		return true;
 	}
+	else if (thisUnderType == SCAN_VARIANT_PATTERN)
+	{
+		// rescans read as many bytes as the result had, so the lengths have to match
+		return (otherUnderType == thisUnderType && this->getSize() == other.getSize());
+	}
 	else if (thisUnderTraits->isNumericType())
 	{
 		if (strict) // don't allow mix-match, typically because the first scan was of loose types to begin with an rescan will have duplicates at same address but slightly different types
@@ -310,6 +397,21 @@ const std::wstring ScanVariant::toString() const
 		else if (this->getType() == SCAN_VARIANT_WIDE_STRING)
 			return traits->toString((void*)this->valueWideString.c_str());
 	}
+	else if (this->isPattern())
+	{
+		const wchar_t* digits = L"0123456789ABCDEF";
+		std::wstring pattern;
+		for (size_t i = 0; i < this->valuePattern.size(); i++)
+		{
+			if (i)
+				pattern += L' ';
+			auto value = this->valuePattern[i];
+			auto mask = this->valuePatternMask[i];
+			pattern += (mask & 0xF0) ? digits[value >> 4] : L'?';
+			pattern += (mask & 0x0F) ? digits[value & 0x0F] : L'?';
+		}
+		return pattern;
+	}
 
 	return traits->toString(nullptr);
 }
@@ -443,25 +545,39 @@ const bool ScanVariant::writeToTarget(const std::shared_ptr<class ScannerTarget>
 	ASSERT(target.get());
 	ASSERT(type >= SCAN_VARIANT_ALLTYPES_BEGIN && type <= SCAN_VARIANT_ALLTYPES_END);
 
+	std::vector<uint8_t> buffer;
+	if (!this->toBuffer(target->isLittleEndian(), buffer))
+		return false;
+	return target->writeArray(address, buffer.size(), &buffer[0]);
+}
+
+const bool ScanVariant::toBuffer(const bool &isLittleEndian, std::vector<uint8_t> &buffer) const
+{
+	ASSERT(type >= SCAN_VARIANT_ALLTYPES_BEGIN && type <= SCAN_VARIANT_ALLTYPES_END);
+
 	// TODO: add support for structures
 	// TODO: figure out what to do about dynamic types here
 
 	auto traits = this->getTypeTraits();
 	if (type == ScanVariant::SCAN_VARIANT_ASCII_STRING)
-		return target->writeString(address, this->valueAsciiString);
+	{
+		auto begin = reinterpret_cast<const uint8_t*>(this->valueAsciiString.c_str());
+		buffer.assign(begin, begin + ((this->valueAsciiString.length() + 1) * sizeof(std::string::value_type)));
+		return true;
+	}
 	else if (type == ScanVariant::SCAN_VARIANT_WIDE_STRING)
-		return target->writeString(address, this->valueWideString); // doubt it but if we ever endianness swap strings we'll need to fix this and FromTargetMemory
+	{
+		// doubt it but if we ever endianness swap strings we'll need to fix this and FromTargetMemory
+		auto begin = reinterpret_cast<const uint8_t*>(this->valueWideString.c_str());
+		buffer.assign(begin, begin + ((this->valueWideString.length() + 1) * sizeof(std::wstring::value_type)));
+		return true;
+	}
 	else if (traits->isNumericType())
 	{
 		auto size = traits->getSize();
-		auto buffer = new uint8_t[size];
-		traits->copyFromBuffer(&this->numericValue, size, target->isLittleEndian(), buffer);
-
-		auto ret = target->writeArray(address, size, buffer);
-
-		delete[] buffer;
-
-		return ret;
+		buffer.resize(size);
+		traits->copyFromBuffer(&this->numericValue, size, isLittleEndian, &buffer[0]);
+		return true;
 	}
 	return false;
 }
@@ -599,6 +715,23 @@ const CompareTypeFlags ScanVariant::compareStructureToBuffer(
 	}
 	return Scanner::SCAN_COMPARE_EQUALS;
 }
+const CompareTypeFlags ScanVariant::comparePatternToBuffer(
+	const ScanVariant* const obj,
+	const ScanVariantComparator &comparator,
+	const size_t &valueSize,
+	const bool &isLittleEndian,
+	const void* const target)
+{
+	auto buf = (uint8_t*)target;
+	auto pattern = &obj->valuePattern[0];
+	auto mask = &obj->valuePatternMask[0];
+	for (size_t i = 0; i < valueSize; i++)
+	{
+		if ((buf[i] & mask[i]) != pattern[i])
+			return 0;
+	}
+	return Scanner::SCAN_COMPARE_EQUALS;
+}
 const CompareTypeFlags ScanVariant::compareAsciiStringToBuffer(
 	const ScanVariant* const obj,
 	const ScanVariantComparator &comparator,
@@ -659,6 +792,8 @@ void ScanVariant::setSizeAndValue()
 		for (auto member = this->valueStruct.begin(); member != this->valueStruct.end(); member++)
 			this->valueSize += member->getSize();
 	}
+	else if (this->isPattern())
+		this->valueSize = this->valuePattern.size();
 
 	// next, we'll set up the proper comparator
 	// we do this to avoid type-checking at compare time.
@@ -680,7 +815,13 @@ void ScanVariant::setSizeAndValue()
 			this->valueWideString
 		);
 	else if (traits->isStructureType())
-		this->searchContex = std::make_shared<ScanVariantSearchContextDefault>(&ScanVariant::compareStructureToBuffer);
+		this->searchContex = std::make_shared<ScanVariantSearchContextStructure>(&ScanVariant::compareStructureToBuffer);
+	else if (this->isPattern())
+		this->searchContex = std::make_shared<ScanVariantSearchContextPattern>(
+			&ScanVariant::comparePatternToBuffer,
+			this->valuePattern,
+			this->valuePatternMask
+		);
 	else if (this->getType() != SCAN_VARIANT_NULL)
 		ASSERT(false); // didn't find a comparator!
 }
\ No newline at end of file
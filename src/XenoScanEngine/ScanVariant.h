@@ -49,6 +49,7 @@ public:
 
 		// These come beyond the end marker because they are special snowflakes
 		SCAN_VARIANT_STRUCTURE,
+		SCAN_VARIANT_PATTERN,
 		SCAN_VARIANT_NULL, // null is the last type with traits defined
 
 		// Need to make sure we always handle these types special (check getUnderlyingType() function)
@@ -73,6 +74,11 @@ public:
 	static const ScanVariant FromStringTyped(const std::string& input,  const ScanVariantType& type);
 	static const ScanVariant FromStringTyped(const std::wstring& input, const ScanVariantType& type);
 
+	// byte patterns (array-of-bytes signatures) look like "48 8B ?? ?? 89 4?", where each
+	// byte is two hex digits and any digit can be a '?' wildcard ("?" alone is a whole
+	// byte). returns a null variant if the pattern can't be parsed, or is all wildcards
+	static const ScanVariant FromPattern(const std::string& input);
+
 	static const ScanVariant FromTargetMemory(const std::shared_ptr<class ScannerTarget> &target, const MemoryAddress& address, const ScanVariantType& type);
 
 
@@ -146,6 +152,10 @@ public:
 	{
 		return (this->type >= SCAN_VARIANT_PLACEHOLDER_BEGIN && this->type <= SCAN_VARIANT_PLACEHOLDER_END);
 	}
+	inline const bool isPattern() const
+	{
+		return (this->type == SCAN_VARIANT_PATTERN);
+	}
 
 	const bool isNull() const;
 	const bool getValue(std::string &value) const;
@@ -163,6 +173,8 @@ public:
 	const bool getValue(std::vector<ScanVariant> &value) const;
 
 	const bool writeToTarget(const std::shared_ptr<class ScannerTarget> &target, const MemoryAddress& address) const;
+	// the bytes writeToTarget() would write
+	const bool toBuffer(const bool &isLittleEndian, std::vector<uint8_t> &buffer) const;
 
 	/*
 		This is safe IF and ONLY IF the caller takes some precautions:
@@ -200,6 +212,7 @@ private:
 	std::string valueAsciiString;
 	std::wstring valueWideString;
 	std::vector<ScanVariant> valueStruct;
+	std::vector<uint8_t> valuePattern, valuePatternMask; // the pattern bytes are already masked
 	union
 	{
 		uint8_t numericValue;
@@ -243,6 +256,12 @@ private:
 		const size_t &valueSize,
 		const bool &isLittleEndian,
 		const void* const target);
+	static const CompareTypeFlags comparePatternToBuffer(
+		const ScanVariant* const obj,
+		const ScanVariantComparator &comparator,
+		const size_t &valueSize,
+		const bool &isLittleEndian,
+		const void* const target);
 	static const CompareTypeFlags compareAsciiStringToBuffer(
 		const ScanVariant* const obj,
 		const ScanVariantComparator &comparator,
@@ -0,0 +1,97 @@
+#pragma once
+#include <stdint.h>
+#include "ScannerTypes.h"
+#include "ScanVariantTypeTraits.h"
+#include "ScanVariant.h"
+#include "ScanVariantSearchContextDefault.h"
+#include "ByteSearch.h"
+
+#include <vector>
+
+/*
+	Byte patterns are found by their longest run of bytes without any wildcards.
+	The run is found with a ByteSearch, and the whole pattern (masks and all) is
+	only compared where it turns up. Patterns without a single whole fixed byte
+	(like "4? ?8") are compared at every offset instead.
+*/
+class ScanVariantSearchContextPattern : public ScanVariantSearchContextDefault
+{
+public:
+	ScanVariantSearchContextPattern(const InternalComparator comp, const std::vector<uint8_t> &pattern, const std::vector<uint8_t> &mask)
+		: ScanVariantSearchContextDefault(comp), runOffset(0), run(ScanVariantSearchContextPattern::findLongestRun(pattern, mask, runOffset))
+	{}
+
+	virtual void searchForMatchesInChunk(
+		const ScanVariant* const obj,
+		const uint8_t* chunk,
+		const size_t &chunkSize,
+		const CompareTypeFlags &compType,
+		const MemoryAddress &startAddress,
+		const bool &isLittleEndian,
+		std::vector<size_t> &locations) const
+	{
+		// patterns either match or they don't
+		if (!(compType & Scanner::SCAN_COMPARE_EQUALS))
+			return;
+
+		if (!this->run.getSize())
+		{
+			ScanVariantSearchContextDefault::searchForMatchesInChunk(
+				obj,
+				chunk,
+				chunkSize,
+				compType,
+				startAddress,
+				isLittleEndian,
+				locations
+			);
+			return;
+		}
+
+		auto size = obj->getSize();
+		if (chunkSize < size)
+			return;
+
+		// like the default search, matches don't overlap
+		size_t nextStart = 0;
+		size_t scanEndAt = chunkSize - size;
+		this->run.forEachMatch(&chunk[this->runOffset], scanEndAt + this->run.getSize(),
+			[this, obj, chunk, &compType, &isLittleEndian, &locations, &nextStart, &size](const size_t &start) -> void
+			{
+				if (start < nextStart)
+					return;
+
+				auto res = this->compareToBuffer(obj, isLittleEndian, &chunk[start]);
+				if ((res & compType) != 0)
+				{
+					locations.push_back(start);
+					nextStart = start + size;
+				}
+			}
+		);
+	}
+
+private:
+	size_t runOffset;
+	ByteSearch run;
+
+	static std::vector<uint8_t> findLongestRun(const std::vector<uint8_t> &pattern, const std::vector<uint8_t> &mask, size_t &runOffset)
+	{
+		size_t bestStart = 0, bestLength = 0, start = 0;
+		for (size_t i = 0; i <= mask.size(); i++)
+		{
+			if (i < mask.size() && mask[i] == 0xFF)
+				continue;
+
+			if (i - start > bestLength)
+			{
+				bestStart = start;
+				bestLength = i - start;
+			}
+			start = i + 1;
+		}
+
+		runOffset = bestStart;
+		return std::vector<uint8_t>(pattern.begin() + bestStart, pattern.begin() + bestStart + bestLength);
+	}
+};
\ No newline at end of file
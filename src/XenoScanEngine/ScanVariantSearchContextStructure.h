@@ -0,0 +1,118 @@
+#pragma once
+#include <stdint.h>
+#include "ScannerTypes.h"
+#include "ScanVariantTypeTraits.h"
+#include "ScanVariant.h"
+#include "ScanVariantSearchContextDefault.h"
+#include "ByteSearch.h"
+
+#include <vector>
+
+/*
+	Structures are found by one of their members (the anchor), which is the most
+	selective member that has one exact value: anything that isn't all zeros beats
+	anything that is, then the widest wins. The anchor is found with a ByteSearch,
+	and the whole structure is only compared where it turns up. Structures without
+	a member that can be an anchor (only ranges and placeholders, say) are compared
+	at every offset, like anything else.
+*/
+class ScanVariantSearchContextStructure : public ScanVariantSearchContextDefault
+{
+public:
+	ScanVariantSearchContextStructure(const InternalComparator comp)
+		: ScanVariantSearchContextDefault(comp)
+	{}
+
+	virtual void searchForMatchesInChunk(
+		const ScanVariant* const obj,
+		const uint8_t* chunk,
+		const size_t &chunkSize,
+		const CompareTypeFlags &compType,
+		const MemoryAddress &startAddress,
+		const bool &isLittleEndian,
+		std::vector<size_t> &locations) const
+	{
+		// the anchor is picked for every search, since dynamic members
+		// (like times) only get their values in prepareForSearch()
+		size_t anchorOffset;
+		std::vector<uint8_t> anchor;
+		if (!ScanVariantSearchContextStructure::findAnchor(obj, isLittleEndian, anchorOffset, anchor))
+		{
+			ScanVariantSearchContextDefault::searchForMatchesInChunk(
+				obj,
+				chunk,
+				chunkSize,
+				compType,
+				startAddress,
+				isLittleEndian,
+				locations
+			);
+			return;
+		}
+
+		// these are the same places the default search would try: the aligned offsets,
+		// which start over at the end of each match so that matches don't overlap
+		auto size = obj->getSize();
+		if (chunkSize < size)
+			return;
+
+		size_t desiredAlignment = obj->getTypeTraits()->getAlignment();
+		size_t chunkAlignment = (size_t)startAddress % desiredAlignment;
+		size_t nextStart = (chunkAlignment == 0) ? 0 : desiredAlignment - chunkAlignment;
+		size_t scanEndAt = chunkSize - size;
+
+		ByteSearch search(anchor);
+		search.forEachMatch(&chunk[anchorOffset], scanEndAt + anchor.size(),
+			[this, obj, chunk, &compType, &isLittleEndian, &locations, &nextStart, &size, &desiredAlignment](const size_t &start) -> void
+			{
+				if (start < nextStart || (start - nextStart) % desiredAlignment != 0)
+					return;
+
+				auto res = this->compareToBuffer(obj, isLittleEndian, &chunk[start]);
+				if ((res & compType) != 0)
+				{
+					locations.push_back(start);
+					nextStart = start + size;
+				}
+			}
+		);
+	}
+
+private:
+	static bool findAnchor(const ScanVariant* const obj, const bool &isLittleEndian, size_t &anchorOffset, std::vector<uint8_t> &anchor)
+	{
+		size_t bestScore = 0, offset = 0;
+		std::vector<uint8_t> bytes;
+		auto &members = obj->getCompositeValues();
+		for (auto member = members.cbegin(); member != members.cend(); member++)
+		{
+			auto score = ScanVariantSearchContextStructure::getAnchorScore(*member, isLittleEndian, bytes);
+			if (score > bestScore)
+			{
+				bestScore = score;
+				anchorOffset = offset;
+				anchor.swap(bytes);
+			}
+			offset += member->getSize();
+		}
+		return (bestScore > 0);
+	}
+
+	// 0 if the member can't be an anchor
+	static size_t getAnchorScore(const ScanVariant &member, const bool &isLittleEndian, std::vector<uint8_t> &bytes)
+	{
+		if (member.isRange() || member.isPlaceholder() || member.isNull() || member.isStructure())
+			return 0;
+		if (!member.toBuffer(isLittleEndian, bytes) || bytes.empty())
+			return 0;
+
+		bool zeros = true;
+		for (auto byte = bytes.cbegin(); byte != bytes.cend() && zeros; byte++)
+			zeros = (*byte == 0);
+
+		// 0.0 and -0.0 are equal, but their bytes aren't
+		if (zeros && member.getTypeTraits()->isFloatingPointNumericType())
+			return 0;
+		return bytes.size() + (zeros ? 0 : 0x10000);
+	}
+};
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include <vector>
 
 #include "ScanVariantComparator.h"
 
@@ -182,6 +183,40 @@ public:
 	virtual void fromString(const std::wstring& input, ScanVariant& output) const;
 };
 
+template <uint32_t BASE_TYPE, uint32_t TARGET_TYPE>
+class ScanVariantUnderlyingPatternTypeTraits : public ScanVariantUnderlyingTypeTraits
+{
+public:
+	ScanVariantUnderlyingPatternTypeTraits() {}
+	virtual ~ScanVariantUnderlyingPatternTypeTraits() {}
+
+	inline virtual const ScanVariantComparator getComparator() const { return nullptr; }
+	inline virtual const ScanVariantComparator getBigEndianComparator() const { return nullptr; }
+	inline virtual const void copyFromBuffer(const uint8_t* buffer, const size_t &size, const bool &isLittleEndian, void* output) const
+	{
+		((std::vector<uint8_t>*)output)->assign(buffer, &buffer[size]);
+	}
+	inline virtual const size_t getSize() const { return 0; }
+	inline virtual const size_t getAlignment() const { return 1; }
+	inline virtual const std::wstring getName() const { return L"pattern"; }
+	inline virtual const std::wstring getFormatString() const { return L"%02X"; }
+	inline virtual const uint32_t getBaseType() const { return BASE_TYPE; }
+	inline virtual const uint32_t getTargetType() const { return TARGET_TYPE; };
+	inline virtual const bool isStringType() const { return false; }
+	inline virtual const bool isNumericType() const { return false; }
+	inline virtual const bool isSignedNumericType() const { return false; }
+	inline virtual const bool isUnsignedNumericType() const { return false; }
+	inline virtual const bool isFloatingPointNumericType() const { return false; }
+	inline virtual const bool isDynamicType() const { return false; };
+	inline virtual const bool isStructureType() const { return false; }
+	inline virtual const std::wstring toString(void* data) const
+	{
+		// patterns need their mask to be printed, so ScanVariant::toString() does it
+		return L"(byte pattern)";
+	}
+	virtual void fromString(const std::wstring& input, ScanVariant& output) const;
+};
+
 template <uint32_t BASE_TYPE, uint32_t TARGET_TYPE>
 class ScanVariantUnderlyingNullTypeTraits : public ScanVariantUnderlyingTypeTraits
 {
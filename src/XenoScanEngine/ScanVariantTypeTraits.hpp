@@ -39,6 +39,12 @@ void ScanVariantUnderlyingStructureTypeTraits<BASE_TYPE, TARGET_TYPE>::fromStrin
 	ASSERT(false); // not possible here
 }
 
+template <uint32_t BASE_TYPE, uint32_t TARGET_TYPE>
+void ScanVariantUnderlyingPatternTypeTraits<BASE_TYPE, TARGET_TYPE>::fromString(const std::wstring& input, ScanVariant& output) const
+{
+	output = ScanVariant::FromPattern(std::string(input.begin(), input.end()));
+}
+
 template <uint32_t BASE_TYPE, uint32_t TARGET_TYPE>
 void ScanVariantUnderlyingNullTypeTraits<BASE_TYPE, TARGET_TYPE>::fromString(const std::wstring& input, ScanVariant& output) const
 {
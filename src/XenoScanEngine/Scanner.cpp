@@ -1,14 +1,23 @@
 #include "Scanner.h"
 #include "ScannerTarget.h"
+#include "ScannerTargetSnapshot.h"
+#include "ScannerTargetCopy.h"
 #include "DataStructureBlueprint.h"
 #include "Assert.h"
+#include "Trace.h"
 
 #include "ThreadPool.h"
-#include "ConsoleProgressTracker.h"
+#include "BoundedQueue.h"
+#include "CpuTopology.h"
+#include "ProgressTracker.h"
 
 #include <mutex>
+#include <algorithm>
 
-Scanner::Scanner() : scanState(nullptr), blockChecker(nullptr)
+Scanner::Scanner() : scanState(nullptr), blockChecker(nullptr), checkerGeneration(0), resultSpillThreshold(DefaultResultSpillThreshold), metricsEnabled(false),
+	consistentScan(false), consistentScanBudget(DefaultConsistentScanBudget),
+	pipelineReaders(0), pipelineScanners(0), pipelineQueueDepth(DefaultPipelineQueueDepth), threadPinning(false),
+	patternScanExecutableOnly(true)
 {
 	this->inferCrosswalkStrings = ScanVariantTypeRange(ScanVariant::SCAN_VARIANT_STRINGTYPES_BEGIN, ScanVariant::SCAN_VARIANT_STRINGTYPES_END);
 	this->inferCrosswalkNumbers = ScanVariantTypeRange(ScanVariant::SCAN_VARIANT_NUMERICTYPES_INFERABLE_BEGIN, ScanVariant::SCAN_VARIANT_NUMERICTYPES_INFERABLE_END);
@@ -28,6 +37,67 @@ Scanner::~Scanner()
 void Scanner::setBlockChecker(const ScannableBlockChecker& checker)
 {
 	this->blockChecker = checker;
+	this->checkerGeneration++;
+}
+
+void Scanner::setBlockFilter(const BlockFilter& filter)
+{
+	this->blockFilter = filter;
+	this->checkerGeneration++;
+}
+
+void Scanner::invalidateRegionCache()
+{
+	this->regionCache.target.reset();
+	this->regionCache.regions.clear();
+	this->regionCache.blocks.clear();
+	this->regionCache.scannable.clear();
+}
+
+void Scanner::setResultSpillThreshold(const size_t &threshold)
+{
+	this->resultSpillThreshold = threshold;
+}
+
+void Scanner::setProgressCallback(const ProgressCallback &callback)
+{
+	this->progressCallback = callback;
+}
+
+void Scanner::setMetricsEnabled(const bool &enabled)
+{
+	this->metricsEnabled = enabled;
+	if (!enabled)
+		this->lastScanMetrics.clear();
+}
+
+void Scanner::setConsistentScan(const bool &enabled, const uint32_t &budgetMs)
+{
+	this->consistentScan = enabled;
+	this->consistentScanBudget = budgetMs;
+}
+
+void Scanner::setScanPipeline(const size_t &readerThreads, const size_t &scannerThreads, const size_t &queueDepth)
+{
+	this->pipelineReaders = readerThreads;
+	this->pipelineScanners = scannerThreads;
+	this->pipelineQueueDepth = std::max<size_t>(1, queueDepth);
+}
+
+void Scanner::setThreadPinning(const bool &enabled)
+{
+	this->threadPinning = enabled;
+}
+
+void Scanner::setPatternScanExecutableOnly(const bool &enabled)
+{
+	this->patternScanExecutableOnly = enabled;
+}
+
+MemoryAddressBounds Scanner::getLastUnreadableRanges() const
+{
+	std::lock_guard<std::mutex> lock(this->unreadableMutex);
+	return this->lastUnreadableRanges;
 }
 
 void Scanner::startNewScan()
@@ -35,7 +105,7 @@ void Scanner::startNewScan()
 	this->scanState->clearScanResults();
 }
 
-void Scanner::runScan(const ScannerTargetShPtr &target, const ScanVariant &needle, const CompareTypeFlags &comp, const ScanInferType &type)
+bool Scanner::runScan(const ScannerTargetShPtr &target, const ScanVariant &needle, const CompareTypeFlags &comp, const ScanInferType &type)
 {
 	ASSERT(target.get() != nullptr);
 	ASSERT(this->scanState.get() != nullptr);
@@ -62,46 +132,270 @@ void Scanner::runScan(const ScannerTargetShPtr &target, const ScanVariant &needl
 		});
 	}
 
-	if (this->scanState->isFirstScan())
-		this->doScan(target, needles, comp);
+	{
+		std::lock_guard<std::mutex> lock(this->unreadableMutex);
+		this->lastUnreadableRanges.clear();
+	}
+
+	auto firstScan = this->scanState->isFirstScan();
+	std::unique_ptr<ScanMetricsRecorder> metrics;
+	if (this->metricsEnabled)
+		metrics.reset(new ScanMetricsRecorder(firstScan ? "scan" : "rescan"));
+
+	bool complete = true;
+	if (firstScan)
+	{
+		RegionCache liveCache;
+		auto copy = this->consistentScan ? this->createConsistentCopy(target, liveCache, metrics.get()) : nullptr;
+		complete = this->doScan(copy ? copy : target, needles, comp, metrics.get());
+		if (copy)
+			this->regionCache = liveCache;
+	}
 	else
-		this->doReScan(target, needles, comp);
+	{
+		auto copy = this->consistentScan ? this->createConsistentResultCopy(target, metrics.get()) : nullptr;
+		this->doReScan(copy ? copy : target, needles, comp, metrics.get());
+	}
+
+	if (metrics)
+		metrics->finish(this->scanState->resultSize(), this->lastScanMetrics);
+	return complete;
 }
 
 void Scanner::runDataStructureScan(const ScannerTargetShPtr &target, const std::string &type)
 {
 	ASSERT(target.get() != nullptr);
-	this->doDataStructureScan(target, type);
+
+	{
+		std::lock_guard<std::mutex> lock(this->unreadableMutex);
+		this->lastUnreadableRanges.clear();
+	}
+
+	std::unique_ptr<ScanMetricsRecorder> metrics;
+	if (this->metricsEnabled)
+		metrics.reset(new ScanMetricsRecorder("structure scan"));
+
+	RegionCache liveCache;
+	auto copy = this->consistentScan ? this->createConsistentCopy(target, liveCache, metrics.get()) : nullptr;
+	this->doDataStructureScan(copy ? copy : target, type, metrics.get());
+	if (copy)
+		this->regionCache = liveCache;
+
+	if (metrics)
+		metrics->finish(this->scanState->foundDataStructureCount(), this->lastScanMetrics);
 }
 
-bool Scanner::shouldScanBlock(const MemoryInformation& meminfo) const
+bool Scanner::captureSnapshot(const ScannerTargetShPtr &target, const std::string &path, const SnapshotOptions &options) const
+{
+	ASSERT(target.get() != nullptr);
+
+	// only what we'd scan goes into the snapshot, so the
+	// block filter and checker decide how big it gets
+	auto blocks = this->getScannableBlocks(target);
+	return ScannerTargetSnapshot::write(target, blocks, path, options);
+}
+
+void Scanner::runDiff(const ScannerTargetShPtr &before, const ScannerTargetShPtr &after, const size_t &minimumWidth, MemoryChangeCollection &changes) const
+{
+	ASSERT(before.get() != nullptr);
+	ASSERT(after.get() != nullptr);
+
+	auto beforeBlocks = this->getScannableBlocks(before);
+	auto afterBlocks = this->getScannableBlocks(after);
+	MemoryDiff::diff(before, beforeBlocks, after, afterBlocks, minimumWidth, changes, this->progressCallback);
+}
+
+FreezeList::FreezeId Scanner::freezeValue(const ScannerTargetShPtr &target, const MemoryAddress &address, const ScanVariant &value, const uint32_t &intervalMs)
+{
+	ASSERT(target.get() != nullptr);
+	return this->freezeList.add(target, address, value, intervalMs);
+}
+
+bool Scanner::unfreezeValue(const FreezeList::FreezeId &id)
+{
+	return this->freezeList.remove(id);
+}
+
+void Scanner::unfreezeAllValues()
+{
+	this->freezeList.clear();
+}
+
+WatchList::WatchId Scanner::watchMemory(const ScannerTargetShPtr &target, const MemoryAddress &address, const size_t &size, const uint32_t &intervalMs)
+{
+	ASSERT(target.get() != nullptr);
+	return this->watchList.add(target, address, size, intervalMs);
+}
+
+bool Scanner::unwatchMemory(const WatchList::WatchId &id)
+{
+	return this->watchList.remove(id);
+}
+
+void Scanner::unwatchAllMemory()
+{
+	this->watchList.clear();
+}
+
+bool Scanner::takeWatchChange(WatchList::Change &change)
+{
+	return this->watchList.pop(change);
+}
+
+bool Scanner::shouldScanBlock(const MemoryInformation& meminfo, const BlockFilter::Compiled& filter) const
 {
 	// TODO: should ignoring commit/mirror be target-implementation defined?
 	auto shouldScan = (meminfo.isCommitted && !meminfo.isMirror);
+
+	// the filter is native, so it goes first. the block checker
+	// still gets the last say, with the filter's answer as the default
+	if (shouldScan && !filter.matches(meminfo))
+		shouldScan = false;
 	if (this->blockChecker)
 		shouldScan = this->blockChecker(shouldScan, meminfo);
 	return shouldScan;
 }
 
+bool Scanner::isSameRegion(const MemoryInformation& a, const MemoryInformation& b) const
+{
+	return (a.allocationBase == b.allocationBase && a.allocationEnd == b.allocationEnd &&
+		a.isModule == b.isModule && a.isCommitted == b.isCommitted && a.isMirror == b.isMirror &&
+		a.isWriteable == b.isWriteable && a.isExecutable == b.isExecutable &&
+		a.isMappedImage == b.isMappedImage && a.isMapped == b.isMapped);
+}
+
 MemoryInformationCollection Scanner::getScannableBlocks(const ScannerTargetShPtr &target) const
 {
+	// Enumerating regions means a query per region, and the block checker can
+	// be a Lua callback, so we keep the last enumeration around. Targets that know
+	// their regions haven't changed let us skip straight to the cached blocks.
+	// Otherwise we have to query again, but any region that is identical to the
+	// last time keeps its old verdict instead of asking the block checker again.
+	auto &cache = this->regionCache;
+	bool sameChecker = (cache.target.lock() == target && cache.checkerGeneration == this->checkerGeneration);
+
+	uint64_t regionGeneration = 0;
+	bool hasRegionGeneration = target->getRegionGeneration(regionGeneration);
+	if (sameChecker && hasRegionGeneration && cache.hasRegionGeneration && cache.regionGeneration == regionGeneration)
+		return cache.blocks;
+
 	auto startAddress = target->getLowestAddress();
 	auto endAdress = target->getHighestAddress();
 
 	auto nextAddress = startAddress;
 
-	MemoryInformationCollection blocks;
+	auto filter = this->blockFilter.compile(target);
+
+	size_t cached = 0;
+	std::vector<bool> scannable;
+	MemoryInformationCollection regions, blocks;
 	while (nextAddress < endAdress)
 	{
 		MemoryInformation meminfo;
-		if (target->queryMemory(nextAddress, meminfo, nextAddress))
-			if (this->shouldScanBlock(meminfo))
-				blocks.push_back(meminfo);
+		if (!target->queryMemory(nextAddress, meminfo, nextAddress))
+			continue;
+
+		// both enumerations are in ascending order, so the only
+		// cached region that can match is the next one at or above us
+		while (sameChecker && cached < cache.regions.size() && cache.regions[cached].allocationBase < meminfo.allocationBase)
+			cached++;
+
+		bool shouldScan;
+		if (sameChecker && cached < cache.regions.size() && this->isSameRegion(cache.regions[cached], meminfo))
+			shouldScan = cache.scannable[cached];
+		else
+			shouldScan = this->shouldScanBlock(meminfo, filter);
+
+		regions.push_back(meminfo);
+		scannable.push_back(shouldScan);
+		if (shouldScan)
+			blocks.push_back(meminfo);
 	}
 
+	cache.target = target;
+	cache.hasRegionGeneration = hasRegionGeneration;
+	cache.regionGeneration = regionGeneration;
+	cache.checkerGeneration = this->checkerGeneration;
+	cache.regions.swap(regions);
+	cache.scannable.swap(scannable);
+	cache.blocks = blocks;
 	return blocks;
 }
 
+ScannerTargetShPtr Scanner::createConsistentCopy(const ScannerTargetShPtr &target, RegionCache &liveCache, ScanMetricsRecorder* metrics)
+{
+	ScanMetricsRecorder::PhaseTimer phase(metrics, "suspend");
+	Trace::Scope scope("scan", "suspend");
+
+	// the regions are enumerated before suspending, so that the budget is all spent copying
+	auto blocks = this->getScannableBlocks(target);
+	auto copy = this->copyWhileSuspended(target, this->regionCache.regions, blocks, metrics);
+	if (!copy)
+		return nullptr;
+	liveCache = this->regionCache;
+
+	// the copy has exactly the regions we just enumerated, so it can use the same
+	// verdicts instead of running the block checker over all of them again
+	auto &cache = this->regionCache;
+	cache.target = copy;
+	cache.hasRegionGeneration = copy->getRegionGeneration(cache.regionGeneration);
+	return copy;
+}
+
+ScannerTargetShPtr Scanner::createConsistentResultCopy(const ScannerTargetShPtr &target, ScanMetricsRecorder* metrics)
+{
+	ScanMetricsRecorder::PhaseTimer phase(metrics, "suspend");
+	Trace::Scope scope("scan", "suspend");
+
+	// the pages are found before suspending, too. results are in address order,
+	// so neighbouring pages are merged into one block as they're found
+	MemoryInformationCollection pages;
+	ScanResultCollection values;
+	for (auto resultLocation = this->scanState->beginResult(); resultLocation != this->scanState->endResult(); resultLocation++)
+	{
+		values.clear();
+		resultLocation.getResults(values);
+
+		size_t size = 0;
+		for (auto value = values.cbegin(); value != values.cend(); value++)
+			size = std::max(size, value->getSize());
+
+		auto address = (size_t)((ScanResultAddress*)resultLocation.getLocation().get())->getAddress();
+		auto start = address & ~(ConsistentRescanPageSize - 1);
+		auto end = (address + size + ConsistentRescanPageSize - 1) & ~(ConsistentRescanPageSize - 1);
+		if (!pages.empty() && (size_t)pages.back().allocationEnd >= start)
+		{
+			auto &last = pages.back();
+			last.allocationEnd = (MemoryAddress)std::max((size_t)last.allocationEnd, end);
+			last.allocationSize = (size_t)last.allocationEnd - (size_t)last.allocationBase;
+			continue;
+		}
+
+		MemoryInformation page = {};
+		page.isCommitted = true;
+		page.allocationBase = (MemoryAddress)start;
+		page.allocationEnd = (MemoryAddress)end;
+		page.allocationSize = end - start;
+		pages.push_back(page);
+	}
+	return this->copyWhileSuspended(target, pages, pages, metrics);
+}
+
+ScannerTargetShPtr Scanner::copyWhileSuspended(const ScannerTargetShPtr &target, const MemoryInformationCollection &regions, const MemoryInformationCollection &blocks, ScanMetricsRecorder* metrics)
+{
+	auto budget = std::chrono::milliseconds(this->consistentScanBudget);
+	auto deadline = std::chrono::steady_clock::now() + budget;
+	if (!target->suspend(this->consistentScanBudget))
+		return nullptr;
+
+	std::shared_ptr<ScannerTargetCopy> copy(new ScannerTargetCopy(target, regions));
+	auto copied = copy->copyBlocks(blocks, deadline);
+	target->resume();
+	if (metrics)
+		metrics->addCopiedBlocks(copied);
+	return copy;
+}
+
 void Scanner::calculateBoundsOfBlocks(const ScannerTargetShPtr &target, const MemoryInformationCollection &blocks, MemoryAddress &lower, MemoryAddress &upper) const
 {
 	// these are swapped because we're min/maxing based on blocks
@@ -117,122 +411,526 @@ void Scanner::calculateBoundsOfBlocks(const ScannerTargetShPtr &target, const Me
 	}
 }
 
-void Scanner::iterateOverBlocks(const ScannerTargetShPtr &target, const MemoryInformationCollection &blocks, blockIterationCallback callback) const
+bool Scanner::readRange(const ScannerTargetShPtr &target, RangeBuffer &range, ScanMetricsRecorder::ThreadCounters* counters) const
 {
-	ThreadPool pool;
-	ConsoleProgressTracker tracker(
-		"Block",
-		pool.getNumberOfWorkers(),
-		blocks.size(),
-		(blocks.size() / 100) + 1
-	);
+	// targets which already hold the memory locally (like snapshots)
+	// can be scanned in place, without the allocation and copy
+	range.unreadable.clear();
+	range.direct = target->getDirectPointer(range.base, range.size);
+	if (range.direct)
+		return true;
 
-	for (auto block = blocks.cbegin(); block != blocks.cend(); block++)
+	ScanMetricsRecorder::Clock::time_point start;
+	if (counters)
+		start = ScanMetricsRecorder::Clock::now();
+
+	// allocate memory to read the buffer, unless the last range left one that's big enough
+	if (range.capacity < range.size)
 	{
-		pool.execute([&target, &callback, block]() -> void {
-			// allocate memory to read the buffer
-			auto buffer = new uint8_t[block->allocationSize];
-			while (!buffer)
+		range.data.reset();
+		range.data.reset(new uint8_t[range.size]);
+		while (!range.data)
+		{
+			// we're probably hogging  too much memory, give threads some time to spin
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+			range.data.reset(new uint8_t[range.size]);
+		}
+		range.capacity = range.size;
+	}
+
+	// read the buffer. targets that can salvage part of a failed read tell
+	// us which parts failed, and everything else still gets scanned
+	bool read;
+	{
+		Trace::Scope scope("scan", "read", range.base, range.size);
+		read = target->readPartial(range.base, range.size, range.data.get(), range.unreadable);
+	}
+
+	size_t readable = range.size;
+	for (auto hole = range.unreadable.begin(); hole != range.unreadable.end(); hole++)
+	{
+		auto holeStart = std::max((size_t)hole->first, (size_t)range.base);
+		auto holeEnd = std::min((size_t)hole->second, (size_t)range.base + range.size);
+		if (holeStart < holeEnd)
+			readable -= holeEnd - holeStart;
+	}
+	if (counters)
+	{
+		counters->read += ScanMetricsRecorder::Clock::now() - start;
+		if (read)
+			counters->bytesRead += readable;
+	}
+
+	if (!range.unreadable.empty())
+	{
+		// failures will typically happen when target isn't frozen, as it's
+		// memory allocations will change between the start and end of the scan.
+		// these are treated as non-fatal and somewhat expected
+		if (counters)
+			counters->readFailures++;
+
+		std::lock_guard<std::mutex> lock(this->unreadableMutex);
+		for (auto hole = range.unreadable.begin(); hole != range.unreadable.end(); hole++)
+			this->lastUnreadableRanges.insert(hole->first, hole->second);
+	}
+	return read;
+}
+
+void Scanner::scanRange(const RangeBuffer &range, const blockIterationCallback &callback, ScanMetricsRecorder::ThreadCounters* counters) const
+{
+	ScanMetricsRecorder::Clock::time_point start;
+	if (counters)
+		start = ScanMetricsRecorder::Clock::now();
+
+	size_t scanned = 0;
+	if (range.direct)
+	{
+		callback(range.base, range.direct, range.size);
+		scanned = range.size;
+	}
+	else
+	{
+		// scan what was read, which is everything between the unreadable ranges
+		auto base = (size_t)range.base;
+		auto cursor = base;
+		auto end = base + range.size;
+		for (auto hole = range.unreadable.begin(); cursor < end; hole++)
+		{
+			auto readableEnd = (hole != range.unreadable.end()) ? std::min((size_t)hole->first, end) : end;
+			if (readableEnd > cursor)
 			{
-				// we're probably hogging  too much memory, give threads some time to spin
-				std::this_thread::sleep_for(std::chrono::milliseconds(5));
-				buffer = new uint8_t[block->allocationSize];
+				callback((MemoryAddress)cursor, &range.data[cursor - base], readableEnd - cursor);
+				scanned += readableEnd - cursor;
 			}
+			if (hole == range.unreadable.end())
+				break;
+			cursor = std::max(cursor, (size_t)hole->second);
+		}
+	}
+
+	if (counters)
+	{
+		counters->bytesScanned += scanned;
+		counters->scan += ScanMetricsRecorder::Clock::now() - start;
+	}
+}
+
+void Scanner::iterateOverBlocks(const ScannerTargetShPtr &target, const MemoryInformationCollection &blocks, blockIterationCallback callback, ScanMetricsRecorder* metrics, const bool &skipZeroPages, const size_t &zeroPageMargin) const
+{
+	if (metrics)
+		metrics->addBlocks(blocks.size());
 
-			// read the buffer
-			if (!target->readArray<uint8_t>(block->allocationBase, block->allocationSize, buffer))
+	typedef std::function<void(const MemoryAddress &base, const size_t &size)> RangeVisitor;
+	auto forEachRange = [&target, skipZeroPages, zeroPageMargin](const MemoryInformation &block, const RangeVisitor &visit) -> void
+	{
+		MemoryAddressBounds zeroPages;
+		if (!skipZeroPages || !target->getZeroPages(block.allocationBase, block.allocationEnd, zeroPages) || zeroPages.empty())
+		{
+			visit(block.allocationBase, block.allocationSize);
+			return;
+		}
+
+		// only scan what's between the zero pages. the ranges we scan reach zeroPageMargin
+		// bytes into the zeros around them, so that anything which overlaps the edge of a
+		// zero page is still seen. since zeros can't match, nothing else is missed
+		auto blockStart = (size_t)block.allocationBase;
+		auto blockEnd = (size_t)block.allocationEnd;
+		auto cursor = blockStart;
+		for (auto zeros = zeroPages.cbegin(); zeros != zeroPages.cend(); zeros++)
+		{
+			auto zerosStart = std::max((size_t)zeros->first, blockStart);
+			auto zerosEnd = std::min((size_t)zeros->second, blockEnd);
+			if (zerosStart != blockStart)
+				zerosStart += zeroPageMargin;
+			if (zerosEnd != blockEnd)
+				zerosEnd = (zerosEnd - blockStart > zeroPageMargin) ? zerosEnd - zeroPageMargin : blockStart;
+			if (zerosStart >= zerosEnd || zerosEnd <= cursor)
+				continue;
+
+			if (zerosStart > cursor)
+				visit((MemoryAddress)cursor, zerosStart - cursor);
+			cursor = zerosEnd;
+		}
+		if (cursor < blockEnd)
+			visit((MemoryAddress)cursor, blockEnd - cursor);
+	};
+
+	if (!this->pipelineReaders)
+	{
+		// pinned workers read each block and scan it on the same CPU, into a
+		// buffer that the read first touched (so it's on the same node, too)
+		auto maxThreads = (size_t)ThreadPool::getMaxThreadCount();
+		std::unique_ptr<ThreadPool> pool(this->threadPinning ? new ThreadPool(CpuTopology::get().spreadCpus(maxThreads)) : new ThreadPool());
+		ProgressTracker tracker(
+			this->progressCallback,
+			"Block",
+			pool->getNumberOfWorkers(),
+			blocks.size(),
+			(blocks.size() / 100) + 1
+		);
+
+		for (auto block = blocks.cbegin(); block != blocks.cend(); block++)
+		{
+			pool->execute([this, &target, &callback, &forEachRange, metrics, block]() -> void {
+				auto counters = metrics ? &metrics->getThreadCounters() : nullptr;
+				Trace::Scope scope("scan", "block", block->allocationBase, block->allocationSize);
+
+				RangeBuffer range;
+				forEachRange(*block, [this, &target, &callback, &range, counters](const MemoryAddress &base, const size_t &size) -> void {
+					range.base = base;
+					range.size = size;
+					if (this->readRange(target, range, counters))
+						this->scanRange(range, callback, counters);
+				});
+			});
+		}
+
+		pool->join([&blocks, &tracker](size_t remaining) -> void {
+			tracker.setNumberOfCompleteTasks(blocks.size() - remaining);
+		});
+		return;
+	}
+
+	// the readers fill buffers and queue them up for the scanners, which hand them
+	// back through spares once they're done. a buffer is only made when there are
+	// no spares, so there are never more than the threads plus the queue depth of
+	// them, and spares has room for all of them
+	typedef std::unique_ptr<RangeBuffer> RangeBufferPtr;
+	struct Lane
+	{
+		BoundedQueue<RangeBufferPtr> filled, spares;
+		size_t unclaimedScanners;
+		Lane(const size_t &depth, const size_t &buffers) : filled(depth), spares(buffers), unclaimedScanners(0) {}
+	};
+
+	auto &topology = CpuTopology::get();
+	auto maxThreads = (size_t)ThreadPool::getMaxThreadCount();
+	auto readerCount = std::min(this->pipelineReaders, maxThreads);
+	auto scannerCount = this->pipelineScanners ? std::min(this->pipelineScanners, maxThreads) : std::max<size_t>(1, maxThreads - readerCount);
+
+	// with pinning, every node that has scanners on it gets its own lane, and
+	// readers queue what they read on the lane of their own node (or share one,
+	// if there are no scanners on it). buffers never leave their lane, so they're
+	// read, scanned and reused on the node they were first touched on
+	std::vector<uint32_t> readerCpus, scannerCpus;
+	std::vector<size_t> nodeLanes(topology.getNodeCount(), 0), laneScanners(1, scannerCount);
+	if (this->threadPinning)
+	{
+		readerCpus = topology.spreadCpus(readerCount);
+		scannerCpus = topology.spreadCpus(scannerCount, readerCount);
+
+		std::vector<size_t> nodeScanners(topology.getNodeCount(), 0);
+		for (auto cpu = scannerCpus.begin(); cpu != scannerCpus.end(); cpu++)
+			nodeScanners[topology.getNodeOfCpu(*cpu)]++;
+
+		laneScanners.clear();
+		for (size_t node = 0; node < nodeScanners.size(); node++)
+		{
+			if (!nodeScanners[node])
+				continue;
+			nodeLanes[node] = laneScanners.size();
+			laneScanners.push_back(nodeScanners[node]);
+		}
+		for (size_t node = 0; node < nodeScanners.size(); node++)
+		{
+			if (!nodeScanners[node])
+				nodeLanes[node] = node % laneScanners.size();
+		}
+	}
+
+	auto laneDepth = std::max<size_t>(1, (this->pipelineQueueDepth + laneScanners.size() - 1) / laneScanners.size());
+	std::vector<std::unique_ptr<Lane>> lanes;
+	for (auto scanners = laneScanners.begin(); scanners != laneScanners.end(); scanners++)
+	{
+		lanes.push_back(std::unique_ptr<Lane>(new Lane(laneDepth, readerCount + scannerCount + this->pipelineQueueDepth)));
+		lanes.back()->unclaimedScanners = *scanners;
+	}
+
+	auto getNodeLane = [&topology, &nodeLanes]() -> size_t
+	{
+		auto cpu = ThreadPool::getCurrentWorkerCpu();
+		return (cpu < 0) ? 0 : nodeLanes[topology.getNodeOfCpu((uint32_t)cpu)];
+	};
+
+	// every lane has to end up with as many scanners as it was given, or a lane could be
+	// left with nobody to empty it. they'll only differ if some of the pinning didn't work
+	std::mutex claimMutex;
+	auto claimLane = [&lanes, &claimMutex, &getNodeLane]() -> Lane&
+	{
+		std::lock_guard<std::mutex> lock(claimMutex);
+		auto lane = getNodeLane();
+		for (size_t l = 0; !lanes[lane]->unclaimedScanners; l++)
+			lane = l;
+		lanes[lane]->unclaimedScanners--;
+		return *lanes[lane];
+	};
+
+	// the scanner pool goes away after the queues are closed, which is when its workers are done
+	std::unique_ptr<ThreadPool> scanners(this->threadPinning ? new ThreadPool(scannerCpus) : new ThreadPool(scannerCount));
+	for (size_t s = 0; s < scannerCount; s++)
+	{
+		scanners->execute([this, &callback, &claimLane, metrics]() -> void {
+			auto counters = metrics ? &metrics->getThreadCounters() : nullptr;
+			auto &lane = claimLane();
+			RangeBufferPtr range;
+			while (lane.filled.pop(range))
 			{
-				// failures will typically happen when target isn't frozen, as it's
-				// memory allocations will change between the start and end of the scan.
-				// these are treated as non-fatal and somewhat expected
-				delete[] buffer;
-				return;
+				{
+					Trace::Scope scope("scan", "scan", range->base, range->size);
+					this->scanRange(*range, callback, counters);
+				}
+				lane.spares.push(std::move(range));
 			}
+		});
+	}
+
+	{
+		std::unique_ptr<ThreadPool> readers(this->threadPinning ? new ThreadPool(readerCpus) : new ThreadPool(readerCount));
+		ProgressTracker tracker(
+			this->progressCallback,
+			"Block",
+			readers->getNumberOfWorkers() + scanners->getNumberOfWorkers(),
+			blocks.size(),
+			(blocks.size() / 100) + 1
+		);
 
-			// scan
-			callback(block->allocationBase, buffer, block->allocationSize);
-			delete[] buffer;
+		for (auto block = blocks.cbegin(); block != blocks.cend(); block++)
+		{
+			readers->execute([this, &target, &forEachRange, &lanes, &getNodeLane, metrics, block]() -> void {
+				auto counters = metrics ? &metrics->getThreadCounters() : nullptr;
+				auto &lane = *lanes[getNodeLane()];
+				Trace::Scope scope("scan", "block", block->allocationBase, block->allocationSize);
+
+				forEachRange(*block, [this, &target, &lane, counters](const MemoryAddress &base, const size_t &size) -> void {
+					RangeBufferPtr range;
+					if (!lane.spares.tryPop(range))
+						range.reset(new RangeBuffer());
+
+					range->base = base;
+					range->size = size;
+					if (this->readRange(target, *range, counters))
+						lane.filled.push(std::move(range));
+					else
+						lane.spares.push(std::move(range));
+				});
+			});
+		}
+
+		readers->join([&blocks, &tracker](size_t remaining) -> void {
+			tracker.setNumberOfCompleteTasks(blocks.size() - remaining);
 		});
 	}
 
-	pool.join([&blocks, &tracker](size_t remaining) -> void {
-		tracker.setNumberOfCompleteTasks(blocks.size() - remaining);
-	});
+	// every reader has finished by now, so once the scanners empty the queues they're done
+	for (auto lane = lanes.begin(); lane != lanes.end(); lane++)
+		(*lane)->filled.close();
 }
 
-void Scanner::doScan(const ScannerTargetShPtr &target, const ScanResultCollection &needles, const CompareTypeFlags &compType)
+bool Scanner::doScan(const ScannerTargetShPtr &target, const ScanResultCollection &needles, const CompareTypeFlags &compType, ScanMetricsRecorder* metrics)
 {
 	// determine which blocks of memory can be scanned
-	auto blocks = this->getScannableBlocks(target);
+	MemoryInformationCollection blocks;
+	{
+		ScanMetricsRecorder::PhaseTimer phase(metrics, "blocks");
+		blocks = this->getScannableBlocks(target);
+
+		bool onlyPatterns = !needles.empty();
+		for (auto needle = needles.cbegin(); needle != needles.cend(); needle++)
+			onlyPatterns &= needle->isPattern();
+		if (onlyPatterns && this->patternScanExecutableOnly)
+		{
+			blocks.erase(
+				std::remove_if(blocks.begin(), blocks.end(), [](const MemoryInformation &block) -> bool { return !block.isExecutable; }),
+				blocks.end()
+			);
+		}
+	}
 
 	// helper lambda that takes care of scanning each chunk
 	std::mutex mutex;
 	ScanResultMap results;
 	ScanResultAddressAllocator resLocAllocator;
 	bool isLittleEndian = target->isLittleEndian();
-	auto scanChunk = [needles, compType, isLittleEndian, &mutex, &resLocAllocator, &results]
+
+	// if none of the needles can match a run of zeros, pages that are known to be
+	// all zeros don't need to be scanned. this is checked by just trying it
+	bool zerosCanMatch = false;
+	size_t largestNeedle = 0;
+	std::vector<uint8_t> zeros;
+	std::vector<size_t> zeroMatches;
+	for (auto needle = needles.cbegin(); needle != needles.cend() && !zerosCanMatch; needle++)
+	{
+		if (!needle->getSize())
+		{
+			zerosCanMatch = true;
+			break;
+		}
+
+		largestNeedle = std::max(largestNeedle, needle->getSize());
+		zeros.assign(needle->getSize(), 0);
+		zeroMatches.clear();
+		needle->searchForMatchesInChunk(&zeros[0], zeros.size(), compType, (MemoryAddress)0, isLittleEndian, zeroMatches);
+		zerosCanMatch = !zeroMatches.empty();
+	}
+
+	// once there are too many results to keep in memory, they all go to disk instead,
+	// as just their address and the needle that found them, written out a run at a
+	// time. the results found before that are turned into hits too, so that they can
+	// follow. they stay in memory until the spill works, in case it doesn't
+	ScanResultSpillWriter spill;
+	std::vector<SpilledScanResult> spillHits;
+	bool spilling = false;
+	auto spillThreshold = this->resultSpillThreshold;
+
+	auto scanChunk = [needles, compType, isLittleEndian, spillThreshold, metrics, &mutex, &resLocAllocator, &results, &spill, &spillHits, &spilling]
 					(const MemoryAddress &baseAddress, const uint8_t* chunk, const size_t &chunkSize)
 					-> void
 	{
+		// time spent waiting on the results is the cost of sharing them between threads
+		auto counters = metrics ? &metrics->getThreadCounters() : nullptr;
+		auto lock = [&mutex, counters]() -> void
+		{
+			if (!counters)
+			{
+				mutex.lock();
+				return;
+			}
+
+			auto start = ScanMetricsRecorder::Clock::now();
+			mutex.lock();
+			counters->lockWait += ScanMetricsRecorder::Clock::now() - start;
+		};
+
 		// for each needle generated, see if it's in the chunk
+		Trace::Scope scope("scan", "search", baseAddress, chunkSize);
 		std::vector<size_t> locations;
-		for (auto needle = needles.cbegin(); needle != needles.cend(); needle++)
+		std::vector<SpilledScanResult> spillRun;
+		for (size_t needleIndex = 0; needleIndex < needles.size(); needleIndex++)
 		{
+			auto needle = &needles[needleIndex];
 			locations.clear();
 			needle->searchForMatchesInChunk(chunk, chunkSize, compType, baseAddress, isLittleEndian, locations);
 			for (auto loc = locations.cbegin(); loc != locations.cend(); loc++)
 			{
-				auto resultLoc =
-					std::allocate_shared
-						<
-							ScanResultAddress,
-							ScanResultAddressAllocator
-						>
-						(
-							resLocAllocator,
-							(MemoryAddress)((size_t)baseAddress + *loc)
-						);
+				auto address = (MemoryAddress)((size_t)baseAddress + *loc);
 
-				mutex.lock();
-				auto found = results.find(resultLoc);
-				if (found == results.end())
+				lock();
+				if (!spilling)
 				{
-					ScanResultCollection temp;
-					temp.push_back(ScanVariant::FromRawBuffer(&chunk[*loc], chunkSize - *loc, isLittleEndian, *needle));
-					results.emplace(std::make_pair(resultLoc, temp));
+					auto resultLoc =
+						std::allocate_shared
+							<
+								ScanResultAddress,
+								ScanResultAddressAllocator
+							>
+							(
+								resLocAllocator,
+								address
+							);
+
+					auto found = results.find(resultLoc);
+					if (found == results.end())
+					{
+						ScanResultCollection temp;
+						temp.push_back(ScanVariant::FromRawBuffer(&chunk[*loc], chunkSize - *loc, isLittleEndian, *needle));
+						results.emplace(std::make_pair(resultLoc, temp));
+					}
+					else
+						found->second.push_back(*needle);
+
+					if (spillThreshold && results.size() > spillThreshold)
+					{
+						spilling = true;
+						for (auto result = results.cbegin(); result != results.cend(); result++)
+						{
+							// every needle has a type of its own, and the values
+							// have the (underlying) type of the needle that found them
+							auto resultAddress = ((ScanResultAddress*)result->first.get())->getAddress();
+							for (auto value = result->second.cbegin(); value != result->second.cend(); value++)
+							{
+								size_t index = 0;
+								while (index < needles.size() && needles[index].getUnderlyingType() != value->getUnderlyingType())
+									index++;
+								ASSERT(index < needles.size());
+								SpilledScanResult hit = { (uint64_t)resultAddress, (uint32_t)index };
+								spillHits.push_back(hit);
+							}
+						}
+					}
 				}
 				else
-					found->second.push_back(*needle);
+				{
+					SpilledScanResult hit = { (uint64_t)address, (uint32_t)needleIndex };
+					spillHits.push_back(hit);
+				}
+
+				if (spilling && spillHits.size() >= spill.getRunSize())
+					spillRun.swap(spillHits);
 				mutex.unlock();
+
+				// runs are sorted and written without holding up the other threads
+				if (!spillRun.empty())
+					spill.addRun(spillRun);
 			}
 		}
 	};
 
-	this->iterateOverBlocks(target, blocks, scanChunk);
-	this->scanState->updateState(results);
+	{
+		ScanMetricsRecorder::PhaseTimer phase(metrics, "scan");
+		this->iterateOverBlocks(target, blocks, scanChunk, metrics, !zerosCanMatch && largestNeedle, largestNeedle);
+	}
+
+	ScanMetricsRecorder::PhaseTimer phase(metrics, "merge");
+	Trace::Scope scope("scan", "merge");
+	if (!spilling)
+	{
+		this->scanState->updateState(results);
+		return true;
+	}
+
+	spill.addRun(spillHits);
+	auto spilled = spill.finish();
+	if (!spilled)
+	{
+		// all that's left are the results that were found before spilling started
+		this->scanState->updateState(results);
+		return false;
+	}
+	this->scanState->updateState(spilled, needles);
+	return true;
 }
 
-void Scanner::doReScan(const ScannerTargetShPtr &target, const ScanResultCollection &needles, const CompareTypeFlags &compType)
+void Scanner::doReScan(const ScannerTargetShPtr &target, const ScanResultCollection &needles, const CompareTypeFlags &compType, ScanMetricsRecorder* metrics)
 {
-	ScanResultMap newResults;
+	auto survivors = this->scanState->createHitSet();
+	ScanValueStoreShPtr survivorValues(new ScanValueStore(this->scanState->isSpilled()));
+	auto counters = metrics ? &metrics->getThreadCounters() : nullptr;
+	std::unique_ptr<ScanMetricsRecorder::PhaseTimer> phase(new ScanMetricsRecorder::PhaseTimer(metrics, "rescan"));
+	std::unique_ptr<Trace::Scope> scope(new Trace::Scope("scan", "rescan"));
 
 	//TODO: If re-scans search for a string of a size that is larger than the initial scan, and it somehow surpasses 0x1000 in size, 
 	// this will end badly. Fix.
 	size_t bufferSize = 0x1000;
 	uint8_t* buffer = new uint8_t[bufferSize];
 	bool isLittleEndian = target->isLittleEndian();
+	ScanResultCollection results;
+	std::vector<size_t> resultIndexes;
 	for (auto resultLocation = this->scanState->beginResult(); resultLocation != this->scanState->endResult(); resultLocation++)
 	{
+		results.clear();
+		resultIndexes.clear();
+		resultLocation.getResults(results, &resultIndexes);
+
 		size_t bytesToRead = 0;
-		ScanResultCollection searchNeedles;
-		for (auto result = resultLocation->second.begin(); result != resultLocation->second.end(); result++)
+		std::vector<std::pair<size_t, ScanResultCollection::const_iterator>> searchNeedles;
+		for (size_t result = 0; result < results.size(); result++)
 		{
 			for (auto needle = needles.begin(); needle != needles.end(); needle++)
 			{
-				if (needle->isCompatibleWith(*result, true))
+				if (needle->isCompatibleWith(results[result], true))
 				{
-					bytesToRead = std::max(bytesToRead, result->getSize());
-					searchNeedles.push_back(*needle);
+					bytesToRead = std::max(bytesToRead, std::max(results[result].getSize(), this->scanState->getHitSize(resultIndexes[result])));
+					searchNeedles.push_back(std::make_pair(resultIndexes[result], needle));
 				}
 			}
 		}
@@ -244,26 +942,54 @@ void Scanner::doReScan(const ScannerTargetShPtr &target, const ScanResultCollect
 			buffer = new uint8_t[bufferSize];
 		}
 
-		if (!resultLocation->first->readCurrentValue(target, buffer, bytesToRead))
-			continue;
+		ScanMetricsRecorder::Clock::time_point start, readEnd;
+		if (counters)
+			start = ScanMetricsRecorder::Clock::now();
 
-		ScanResultCollection newResultValues;
+		auto read = resultLocation.getLocation()->readCurrentValue(target, buffer, bytesToRead);
+		if (counters)
+		{
+			readEnd = ScanMetricsRecorder::Clock::now();
+			counters->read += readEnd - start;
+			if (!read)
+				counters->readFailures++;
+		}
+		if (!read)
+			continue;
 
+		// a hit survives if any needle of it's type still matches, and keeps the bytes
+		// that were just read (as many as its value has). the needles are in hit order,
+		// so the values are too
 		for (auto needle = searchNeedles.begin(); needle != searchNeedles.end(); needle++)
 		{
-			auto res = needle->compareTo(buffer, isLittleEndian);
+			if (survivors.test(needle->first))
+				continue;
+
+			auto res = needle->second->compareTo(buffer, isLittleEndian);
 			if ((res & compType) != 0)
-				newResultValues.push_back(ScanVariant::FromRawBuffer(buffer, bufferSize, isLittleEndian, *needle));
+			{
+				survivors.set(needle->first);
+				survivorValues->append(buffer, this->scanState->getHitSize(needle->first));
+			}
 		}
 
-		if (newResultValues.size())
-			newResults.insert(std::make_pair(resultLocation->first, newResultValues));
+		if (counters)
+		{
+			counters->bytesRead += bytesToRead;
+			counters->bytesScanned += bytesToRead;
+			counters->scan += ScanMetricsRecorder::Clock::now() - readEnd;
+		}
 	}
 	delete [] buffer;
-	this->scanState->updateState(newResults);
+	phase.reset();
+	scope.reset();
+
+	ScanMetricsRecorder::PhaseTimer merge(metrics, "merge");
+	Trace::Scope mergeScope("scan", "merge");
+	this->scanState->updateState(survivors, survivorValues, isLittleEndian);
 }
 
-void Scanner::doDataStructureScan(const ScannerTargetShPtr &target, const std::string &type)
+void Scanner::doDataStructureScan(const ScannerTargetShPtr &target, const std::string &type, ScanMetricsRecorder* metrics)
 {
 	auto supported = target->getSupportedBlueprints();
 	if (supported.find(type) == supported.cend())
@@ -274,7 +1000,11 @@ void Scanner::doDataStructureScan(const ScannerTargetShPtr &target, const std::s
 
 
 	// determine which blocks of memory can be scanned
-	auto blocks = this->getScannableBlocks(target);
+	MemoryInformationCollection blocks;
+	{
+		ScanMetricsRecorder::PhaseTimer phase(metrics, "blocks");
+		blocks = this->getScannableBlocks(target);
+	}
 
 	// calculate block bounds, this will help speed up the pointer locator
 	MemoryAddress upperBound, lowerBound;
@@ -285,10 +1015,13 @@ void Scanner::doDataStructureScan(const ScannerTargetShPtr &target, const std::s
 	// even if a pointer appears multiple times, we only need to scan it once
 	std::mutex mutex;
 	PointerMap foundPointers;
-	auto findPointers = [this, upperBound, lowerBound, &target, &blocks, &mutex, &foundPointers]
+	auto findPointers = [this, upperBound, lowerBound, metrics, &target, &blocks, &mutex, &foundPointers]
 						(const MemoryAddress &baseAddress, const uint8_t* chunk, const size_t &chunkSize)
 						-> void
 	{
+		auto counters = metrics ? &metrics->getThreadCounters() : nullptr;
+		Trace::Scope scope("scan", "pointers", baseAddress, chunkSize);
+
 		// TODO: might have to fix this for platforms with different address sizes
 		size_t desiredAlignment = target->getPointerSize();
 		size_t chunkAlignment = (size_t)baseAddress % desiredAlignment;
@@ -306,16 +1039,28 @@ void Scanner::doDataStructureScan(const ScannerTargetShPtr &target, const std::s
 					(size_t)startOffset + (size_t)baseAddress + i * desiredAlignment
 				);
 
+				ScanMetricsRecorder::Clock::time_point start;
+				if (counters)
+					start = ScanMetricsRecorder::Clock::now();
 				mutex.lock();
+				if (counters)
+					counters->lockWait += ScanMetricsRecorder::Clock::now() - start;
 				foundPointers[check].push_back(location);
 				mutex.unlock();
 			}
 		}
 	};
-	this->iterateOverBlocks(target, blocks, findPointers);
+	// a page of zeros can't hold pointers, unless something is mapped at null
+	{
+		ScanMetricsRecorder::PhaseTimer phase(metrics, "pointers");
+		this->iterateOverBlocks(target, blocks, findPointers, metrics, !this->isValidPointer(lowerBound, upperBound, (MemoryAddress)0), target->getPointerSize());
+	}
 
 	// with the list of pointers, scan for valid structures
 	DataStructureResultMap results;
-	DataStructureBlueprint::findDataStructures(target, type, foundPointers, results);
+	{
+		ScanMetricsRecorder::PhaseTimer phase(metrics, "blueprints");
+		DataStructureBlueprint::findDataStructures(target, type, foundPointers, results, this->progressCallback);
+	}
 	this->scanState->updateState(results);
 }
\ No newline at end of file
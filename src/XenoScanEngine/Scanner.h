@@ -2,6 +2,7 @@
 #include <string>
 #include <memory>
 #include <map>
+#include <mutex>
 #include <vector>
 #include <functional>
 
@@ -11,7 +12,13 @@
 #include "ScanVariant.h"
 #include "ScanResult.h"
 #include "ScanState.h"
+#include "BlockFilter.h"
+#include "MemoryDiff.h"
+#include "FreezeList.h"
+#include "WatchList.h"
+#include "ScanMetrics.h"
 #include "RangeList.h"
+#include "ProgressTracker.h"
 
 
 class Scanner
@@ -49,17 +56,94 @@ public:
 
 	typedef std::function<bool(bool, const MemoryInformation&)> ScannableBlockChecker;
 
+	static constexpr uint32_t DefaultConsistentScanBudget = 500;
+	static constexpr size_t DefaultPipelineQueueDepth = 8;
+
 	ScanStateShPtr scanState;
 
 	Scanner();
 	~Scanner();
 
 	void setBlockChecker(const ScannableBlockChecker& checker);
+	void setBlockFilter(const BlockFilter& filter);
+	void invalidateRegionCache();
+
+	// once a first scan finds more than this many locations, its results are
+	// written to temporary files instead of being kept in memory. 0 never spills
+	void setResultSpillThreshold(const size_t &threshold);
+
+	// scans only record metrics while this is on. getLastScanMetrics()
+	// describes the last scan that ran with it on
+	void setMetricsEnabled(const bool &enabled);
+	bool getMetricsEnabled() const { return this->metricsEnabled; }
+	const ScanMetrics& getLastScanMetrics() const { return this->lastScanMetrics; }
+
+	// scans, diffs and structure scans report how far along they are to this,
+	// on the thread that started them. nothing is reported without one, and
+	// a ConsoleProgressPrinter prints the progress to the console
+	void setProgressCallback(const ProgressCallback &callback);
+
+	// pipelined scans split the workers into readers, which copy memory out of the
+	// target into a queue of at most queueDepth buffers, and scanners, which search
+	// whatever is on the queue. reads and compares then happen at the same time,
+	// which pays off when reads are slow (like they are from other processes).
+	// 0 readers turns it off, so every worker reads a block and then scans it.
+	// 0 scanners gives the scanners every thread that the readers didn't take
+	void setScanPipeline(const size_t &readerThreads, const size_t &scannerThreads = 0, const size_t &queueDepth = DefaultPipelineQueueDepth);
+
+	// pinned scans give every worker its own CPU, spread over the NUMA nodes, so
+	// each buffer is allocated, read and scanned on one node (and without the
+	// pipeline, on one CPU). pipelined scans get a queue for each node
+	void setThreadPinning(const bool &enabled);
+	bool getThreadPinning() const { return this->threadPinning; }
+
+	// byte patterns are for finding code, so scans for them only go through the
+	// executable blocks unless this is turned off. the block filter and checker
+	// still decide which blocks are scannable in the first place
+	void setPatternScanExecutableOnly(const bool &enabled);
+	bool getPatternScanExecutableOnly() const { return this->patternScanExecutableOnly; }
+
+	// the parts of the scanned blocks which couldn't be read during the last scan
+	// (or structure scan). targets that can't salvage partial reads report the
+	// whole range they were asked for
+	MemoryAddressBounds getLastUnreadableRanges() const;
+
+	// consistent scans suspend the target, copy the blocks they're about to scan
+	// (spending at most budgetMs with it stopped), let it go again, and then scan
+	// the copy. that way every value comes from the same moment, even though the
+	// scan itself takes much longer. blocks that didn't get copied in time are
+	// read live. rescans do the same with just the pages that hold their results.
+	// targets that can't be suspended are scanned live
+	void setConsistentScan(const bool &enabled, const uint32_t &budgetMs = DefaultConsistentScanBudget);
+	bool getConsistentScan() const { return this->consistentScan; }
 
 	void startNewScan();
-	void runScan(const ScannerTargetShPtr &target, const ScanVariant &needle, const CompareTypeFlags &comp, const ScanInferType &type);
+	// returns false if a first scan had to spill its results to disk and couldn't,
+	// in which case only the results found before it started spilling are kept
+	bool runScan(const ScannerTargetShPtr &target, const ScanVariant &needle, const CompareTypeFlags &comp, const ScanInferType &type);
 	void runDataStructureScan(const ScannerTargetShPtr &target, const std::string &type);
 
+	// writes the scannable memory of target to a file, which can
+	// then be attached to (and scanned) as a "snapshot" target
+	bool captureSnapshot(const ScannerTargetShPtr &target, const std::string &path, const SnapshotOptions &options = SnapshotOptions()) const;
+
+	// finds everything that changed between two targets (usually snapshots).
+	// the block filter and checker are applied to both of them
+	void runDiff(const ScannerTargetShPtr &before, const ScannerTargetShPtr &after, const size_t &minimumWidth, MemoryChangeCollection &changes) const;
+
+	// frozen values are written back every intervalMs until they're unfrozen
+	// (or the scanner goes away). freezeValue() returns 0 on failure
+	FreezeList::FreezeId freezeValue(const ScannerTargetShPtr &target, const MemoryAddress &address, const ScanVariant &value, const uint32_t &intervalMs);
+	bool unfreezeValue(const FreezeList::FreezeId &id);
+	void unfreezeAllValues();
+
+	// watched memory is sampled every intervalMs, and changes to it are queued up
+	// for takeWatchChange(), which should only be called from one thread
+	WatchList::WatchId watchMemory(const ScannerTargetShPtr &target, const MemoryAddress &address, const size_t &size, const uint32_t &intervalMs);
+	bool unwatchMemory(const WatchList::WatchId &id);
+	void unwatchAllMemory();
+	bool takeWatchChange(WatchList::Change &change);
+
 private:
 	typedef IRangeList<typename ScanVariant::ScanVariantType> IScanVariantTypeRange;
 	typedef RangeList<typename ScanVariant::ScanVariantType> ScanVariantTypeRange;
@@ -69,21 +153,92 @@ private:
 	ScanVariantTypeRangeAggregate inferCrosswalkAll;
 	IScanVariantTypeRange* inferTypeCrosswalk[SCAN_INFER_TYPE_END + 1];
 	ScannableBlockChecker blockChecker;
+	BlockFilter blockFilter;
+	uint64_t checkerGeneration;
+
+	// each in-memory location costs a few hundred bytes, so this is
+	// somewhere around a gigabyte of results before they go to disk
+	static constexpr size_t DefaultResultSpillThreshold = 0x400000;
+	size_t resultSpillThreshold;
 
-	bool shouldScanBlock(const MemoryInformation& meminfo) const;
+	bool metricsEnabled;
+	ScanMetrics lastScanMetrics;
+
+	ProgressCallback progressCallback;
+
+	// consistent rescans copy their results a page at a time
+	static constexpr size_t ConsistentRescanPageSize = 0x1000;
+	bool consistentScan;
+	uint32_t consistentScanBudget;
+
+	size_t pipelineReaders, pipelineScanners, pipelineQueueDepth;
+	bool threadPinning;
+	bool patternScanExecutableOnly;
+
+	FreezeList freezeList;
+	WatchList watchList;
+
+	// the last enumeration of the target's regions, along with what
+	// shouldScanBlock() said about each of them. see getScannableBlocks()
+	struct RegionCache
+	{
+		std::weak_ptr<ScannerTarget> target;
+		bool hasRegionGeneration;
+		uint64_t regionGeneration, checkerGeneration;
+		MemoryInformationCollection regions, blocks;
+		std::vector<bool> scannable;
+	};
+	mutable RegionCache regionCache;
+
+	mutable std::mutex unreadableMutex;
+	mutable MemoryAddressBounds lastUnreadableRanges;
+
+	bool shouldScanBlock(const MemoryInformation& meminfo, const BlockFilter::Compiled& filter) const;
+	bool isSameRegion(const MemoryInformation& a, const MemoryInformation& b) const;
 	MemoryInformationCollection getScannableBlocks(const ScannerTargetShPtr &target) const;
 
+	// suspends target and copies its scannable blocks, pointing the region cache
+	// at the copy. liveCache gets what it should be put back to once the scan is
+	// done. returns null (with the cache untouched) if target couldn't be suspended
+	ScannerTargetShPtr createConsistentCopy(const ScannerTargetShPtr &target, RegionCache &liveCache, ScanMetricsRecorder* metrics);
+
+	// the same for a rescan, but only the pages holding the current results are copied
+	ScannerTargetShPtr createConsistentResultCopy(const ScannerTargetShPtr &target, ScanMetricsRecorder* metrics);
+
+	// suspends target, copies as much of blocks as it can in the budget, and lets it
+	// go again. returns null if target couldn't be suspended
+	ScannerTargetShPtr copyWhileSuspended(const ScannerTargetShPtr &target, const MemoryInformationCollection &regions, const MemoryInformationCollection &blocks, ScanMetricsRecorder* metrics);
+
 	typedef std::function<void(const MemoryAddress &baseAddress, const uint8_t* chunk, const size_t &chunkSize)> blockIterationCallback;
-	void iterateOverBlocks(const ScannerTargetShPtr &target, const MemoryInformationCollection &blocks, blockIterationCallback callback) const;
+
+	// one range of a block, as read out of the target by readRange(). targets
+	// that hold their memory locally just hand out a direct pointer instead
+	struct RangeBuffer
+	{
+		MemoryAddress base;
+		size_t size, capacity;
+		const uint8_t* direct;
+		std::unique_ptr<uint8_t[]> data;
+		MemoryAddressBounds unreadable;
+
+		RangeBuffer() : base(0), size(0), capacity(0), direct(nullptr) {}
+	};
+	// returns false if there's nothing to scan in the range
+	bool readRange(const ScannerTargetShPtr &target, RangeBuffer &range, ScanMetricsRecorder::ThreadCounters* counters) const;
+	void scanRange(const RangeBuffer &range, const blockIterationCallback &callback, ScanMetricsRecorder::ThreadCounters* counters) const;
+
+	void iterateOverBlocks(
+		const ScannerTargetShPtr &target, const MemoryInformationCollection &blocks, blockIterationCallback callback, ScanMetricsRecorder* metrics,
+		const bool &skipZeroPages = false, const size_t &zeroPageMargin = 0) const;
 	void calculateBoundsOfBlocks(const ScannerTargetShPtr &target, const MemoryInformationCollection &blocks, MemoryAddress &lower, MemoryAddress &upper) const;
 	inline bool isValidPointer(const MemoryAddress &lower, const MemoryAddress &upper, const MemoryAddress &address) const
 	{
 		return (address >= lower && address <= upper);
 	}
 
-	void doScan(const ScannerTargetShPtr &target, const ScanResultCollection &needles, const CompareTypeFlags &compType);
-	void doReScan(const ScannerTargetShPtr &target, const ScanResultCollection &needles, const CompareTypeFlags &compType);
+	bool doScan(const ScannerTargetShPtr &target, const ScanResultCollection &needles, const CompareTypeFlags &compType, ScanMetricsRecorder* metrics);
+	void doReScan(const ScannerTargetShPtr &target, const ScanResultCollection &needles, const CompareTypeFlags &compType, ScanMetricsRecorder* metrics);
 
-	void doDataStructureScan(const ScannerTargetShPtr &target, const std::string &type);
+	void doDataStructureScan(const ScannerTargetShPtr &target, const std::string &type, ScanMetricsRecorder* metrics);
 };
 typedef std::shared_ptr<Scanner> ScannerShPtr;
\ No newline at end of file
@@ -1,11 +1,18 @@
 #include "ScannerTarget.h"
 
 #include "ScannerTargetWindows.h"
+#include "ScannerTargetLinux.h"
 #include "ScannerTargetDolphin.h"
+#include "ScannerTargetSnapshot.h"
+#include "ScannerTargetSelf.h"
 
 // We do everything in this file, rather than
 // create each producer in the .cpp file of it's class,
 // to ensure that the factory has already been initialized
 CREATE_FACTORY(ScannerTarget);
+#ifdef NativeScannerTarget
 CREATE_PRODUCER(ScannerTarget, NativeScannerTarget,   "proc");
-CREATE_PRODUCER(ScannerTarget, ScannerTargetDolphin,  "dolphin");
\ No newline at end of file
+#endif
+CREATE_PRODUCER(ScannerTarget, ScannerTargetDolphin,  "dolphin");
+CREATE_PRODUCER(ScannerTarget, ScannerTargetSnapshot, "snapshot");
+CREATE_PRODUCER(ScannerTarget, ScannerTargetSelf,     "self");
\ No newline at end of file
@@ -11,25 +11,111 @@ friend class ScannerTargetHelper<ScannerTarget>;
 public:
 	static FACTORY_TYPE Factory;
 
-	ScannerTarget() {};
+	ScannerTarget() : regionGeneration(0) {};
 	~ScannerTarget() {};
 
 	// Now, everything below this point is abstract
 	virtual bool attach(const ProcessIdentifier &pid) = 0;
 	virtual bool isAttached() const = 0;
 
+	// targets which are backed by files (instead of processes) attach here
+	virtual bool attachFile(const std::string &/*path*/)
+	{
+		return false;
+	}
+
 	virtual bool queryMemory(const MemoryAddress &adr, MemoryInformation& meminfo, MemoryAddress &nextAdr) const = 0;
 	
 	virtual bool isWithinModule(MemoryAddress &start, MemoryAddress &end) const = 0;
 	virtual bool getMainModuleBounds(MemoryAddress &start, MemoryAddress &end) const = 0;
 
+	// targets which don't have modules (or can't name them) just return false
+	virtual bool getModules(ModuleInformationCollection &/*modules*/) const
+	{
+		return false;
+	}
+
 	virtual uint64_t getFileTime64() const = 0;
 	virtual uint32_t getTickTime32() const = 0;
 
+	// targets that can tell when their regions change should return true and
+	// bump regionGeneration whenever they do. anything else gets its regions
+	// re-queried every time they're needed
+	virtual bool getRegionGeneration(uint64_t &/*generation*/) const
+	{
+		return false;
+	}
+
+	// targets which already have their memory in our address space can hand it
+	// out directly, which saves the scanner from having to copy it. the pointer
+	// is only valid while the target is attached
+	virtual const uint8_t* getDirectPointer(const MemoryAddress &/*adr*/, const size_t &/*size*/) const
+	{
+		return nullptr;
+	}
+
+	// targets which know that some of their pages are all zeros (without reading
+	// them) can say so, and scans that can't match zeros will skip them
+	virtual bool getZeroPages(const MemoryAddress &/*start*/, const MemoryAddress &/*end*/, MemoryAddressBounds &/*zeroPages*/) const
+	{
+		return false;
+	}
+
+	// targets that can stop every thread of their process do so here, giving up
+	// (and leaving it running) if that takes longer than timeoutMs. resume() lets
+	// it go again, and has to be called from the thread that called suspend()
+	virtual bool suspend(const uint32_t &/*timeoutMs*/)
+	{
+		return false;
+	}
+	virtual void resume()
+	{
+	}
+
+	// reads whatever it can of [adr, adr + size). targets that can tell which parts
+	// of a range couldn't be read (instead of failing all of it) add those parts
+	// to unreadable, and the rest is good. returns false if nothing could be read,
+	// which is all the default (an all or nothing read) can ever say
+	virtual bool readPartial(const MemoryAddress &adr, const size_t &size, void* result, MemoryAddressBounds &unreadable) const
+	{
+		if (this->rawRead(adr, size, result))
+			return true;
+		unreadable.insert(adr, (MemoryAddress)((size_t)adr + size));
+		return false;
+	}
+
+	// targets with vectored reads and writes (like process_vm_readv/writev) can do
+	// a whole batch in one call; everything else does them one at a time. reads
+	// fill in buffers that are already the right size, and empty the ones that
+	// can't be read. both return how many of the reads or writes worked
+	virtual size_t readBatch(MemoryBufferCollection &reads) const
+	{
+		size_t read = 0;
+		for (auto buffer = reads.begin(); buffer != reads.end(); buffer++)
+		{
+			if (!buffer->data.empty() && this->rawRead(buffer->address, buffer->data.size(), &buffer->data[0]))
+				read++;
+			else
+				buffer->data.clear();
+		}
+		return read;
+	}
+	virtual size_t writeBatch(const MemoryBufferCollection &writes) const
+	{
+		size_t written = 0;
+		for (auto write = writes.cbegin(); write != writes.cend(); write++)
+		{
+			if (!write->data.empty() && this->rawWrite(write->address, write->data.size(), &write->data[0]))
+				written++;
+		}
+		return written;
+	}
+
 protected:
 	bool littleEndian;
 	size_t pointerSize;
 	MemoryAddress lowestAddress, highestAddress;
+	uint64_t regionGeneration;
 	std::set<std::string> supportedBlueprints;
 
 	virtual bool rawRead(const MemoryAddress &adr, const size_t objectSize, void* result) const = 0;
@@ -0,0 +1,196 @@
+#include "ScannerTargetCopy.h"
+#include "RegionList.h"
+
+#include "Assert.h"
+#include "ThreadPool.h"
+#include "Trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+ScannerTargetCopy::ScannerTargetCopy(const ScannerTargetShPtr &target, const MemoryInformationCollection &regions) :
+	target(target), regions(regions)
+{
+	ASSERT(target.get() != nullptr);
+
+	this->supportedBlueprints = target->getSupportedBlueprints();
+	this->pointerSize = target->getPointerSize();
+	this->littleEndian = target->isLittleEndian();
+	this->lowestAddress = target->getLowestAddress();
+	this->highestAddress = target->getHighestAddress();
+}
+
+ScannerTargetCopy::~ScannerTargetCopy()
+{
+}
+
+size_t ScannerTargetCopy::copyBlocks(const MemoryInformationCollection &blocks, const std::chrono::steady_clock::time_point &deadline)
+{
+	this->blocks.clear();
+	this->blocks.resize(blocks.size());
+	for (size_t b = 0; b < blocks.size(); b++)
+	{
+		this->blocks[b].base = (size_t)blocks[b].allocationBase;
+		this->blocks[b].end = (size_t)blocks[b].allocationEnd;
+		this->blocks[b].copied = false;
+	}
+	std::sort(this->blocks.begin(), this->blocks.end(),
+		[](const Block &a, const Block &b) -> bool { return (a.base < b.base); });
+
+	// each block belongs to one task, so they can all be filled in without locks.
+	// blocks are copied a chunk at a time, and any block that isn't finished by
+	// the deadline is thrown away and left to be read live
+	std::atomic<size_t> copied(0);
+	{
+		ThreadPool pool;
+		for (auto block = this->blocks.begin(); block != this->blocks.end(); block++)
+		{
+			pool.execute([this, block, &deadline, &copied]() -> void {
+				Trace::Scope scope("scan", "copy", (MemoryAddress)block->base, block->end - block->base);
+
+				// the buffer only grows as chunks are read, since zeroing a huge block
+				// all at once can take longer than the whole budget
+				auto blockSize = block->end - block->base;
+				block->data.reserve(blockSize);
+
+				bool anyRead = false;
+				for (size_t offset = 0; offset < blockSize; offset += CopyChunkSize)
+				{
+					if (std::chrono::steady_clock::now() > deadline)
+					{
+						block->data = std::vector<uint8_t>();
+						block->unreadable = MemoryAddressBounds();
+						return;
+					}
+
+					auto size = std::min(blockSize - offset, CopyChunkSize);
+					block->data.resize(offset + size);
+					if (this->target->readPartial((MemoryAddress)(block->base + offset), size, &block->data[offset], block->unreadable))
+						anyRead = true;
+				}
+
+				if (anyRead)
+				{
+					block->copied = true;
+					copied++;
+				}
+				else
+					block->data = std::vector<uint8_t>();
+			});
+		}
+		pool.join();
+	}
+	return copied;
+}
+
+bool ScannerTargetCopy::attach(const ProcessIdentifier &pid)
+{
+	return false;
+}
+
+bool ScannerTargetCopy::isAttached() const
+{
+	return this->target->isAttached();
+}
+
+bool ScannerTargetCopy::queryMemory(const MemoryAddress &adr, MemoryInformation& meminfo, MemoryAddress &nextAdr) const
+{
+	return RegionList::find(this->regions, adr, this->highestAddress, meminfo, nextAdr);
+}
+
+bool ScannerTargetCopy::isWithinModule(MemoryAddress &start, MemoryAddress &end) const
+{
+	return this->target->isWithinModule(start, end);
+}
+
+bool ScannerTargetCopy::getMainModuleBounds(MemoryAddress &start, MemoryAddress &end) const
+{
+	return this->target->getMainModuleBounds(start, end);
+}
+
+bool ScannerTargetCopy::getModules(ModuleInformationCollection &modules) const
+{
+	return this->target->getModules(modules);
+}
+
+uint64_t ScannerTargetCopy::getFileTime64() const
+{
+	return this->target->getFileTime64();
+}
+
+uint32_t ScannerTargetCopy::getTickTime32() const
+{
+	return this->target->getTickTime32();
+}
+
+bool ScannerTargetCopy::getRegionGeneration(uint64_t &generation) const
+{
+	generation = 0;
+	return true;
+}
+
+const uint8_t* ScannerTargetCopy::getDirectPointer(const MemoryAddress &adr, const size_t &size) const
+{
+	// blocks with holes in them go through readPartial(), which knows where the holes are
+	auto block = this->findCopy(adr, size);
+	if (!block || !block->unreadable.empty())
+		return nullptr;
+	return &block->data[(size_t)adr - block->base];
+}
+
+bool ScannerTargetCopy::readPartial(const MemoryAddress &adr, const size_t &size, void* result, MemoryAddressBounds &unreadable) const
+{
+	auto block = this->findCopy(adr, size);
+	if (!block)
+		return this->target->readPartial(adr, size, result, unreadable);
+
+	auto start = (size_t)adr;
+	auto end = start + size;
+	memcpy(result, &block->data[start - block->base], size);
+	for (auto range = block->unreadable.begin(); range != block->unreadable.end(); range++)
+	{
+		auto holeStart = std::max((size_t)range->first, start);
+		auto holeEnd = std::min((size_t)range->second, end);
+		if (holeStart < holeEnd)
+			unreadable.insert((MemoryAddress)holeStart, (MemoryAddress)holeEnd);
+	}
+	return !unreadable.contains(adr, (MemoryAddress)end);
+}
+
+bool ScannerTargetCopy::rawRead(const MemoryAddress &adr, const size_t objectSize, void* result) const
+{
+	auto block = this->findCopy(adr, objectSize);
+	if (!block)
+	{
+		auto buffer = (uint8_t*)result;
+		return this->target->readArray<uint8_t>(adr, objectSize, buffer);
+	}
+
+	auto end = (MemoryAddress)((size_t)adr + objectSize);
+	if (block->unreadable.overlaps(adr, end))
+		return false;
+	memcpy(result, &block->data[(size_t)adr - block->base], objectSize);
+	return true;
+}
+
+bool ScannerTargetCopy::rawWrite(const MemoryAddress &adr, const size_t objectSize, const void* const data) const
+{
+	return this->target->writeArray<uint8_t>(adr, objectSize, (const uint8_t*)data);
+}
+
+const ScannerTargetCopy::Block* ScannerTargetCopy::findCopy(const MemoryAddress &adr, const size_t &size) const
+{
+	auto start = (size_t)adr;
+	auto block = std::upper_bound(
+		this->blocks.cbegin(), this->blocks.cend(), start,
+		[](const size_t &address, const Block &block) -> bool { return (address < block.base); }
+	);
+	if (block == this->blocks.cbegin())
+		return nullptr;
+
+	block--;
+	if (!block->copied || start + size > block->end)
+		return nullptr;
+	return &(*block);
+}
\ No newline at end of file
@@ -0,0 +1,69 @@
+#pragma once
+
+#ifndef XENOSCANENGINE_LIB
+#error This header is for internal library use. Include "ScannerTarget.h" instead.
+#endif
+
+#include <chrono>
+#include <vector>
+
+#include "ScannerTarget.h"
+
+
+// An in-memory copy of the blocks a scan is about to look at, taken while the
+// real target was suspended, so that the whole scan sees the target as it was
+// at one moment. It has the regions the scanner enumerated, and hands the
+// copied blocks out with getDirectPointer(). Anything that didn't get copied
+// (and everything that isn't memory, like modules and clocks) comes from the
+// real target, and writes always go to it.
+class ScannerTargetCopy : public ScannerTarget
+{
+public:
+	ScannerTargetCopy(const ScannerTargetShPtr &target, const MemoryInformationCollection &regions);
+	~ScannerTargetCopy();
+
+	// copies as many of the blocks as it can before the deadline, and returns how
+	// many that was. the deadline is checked between chunks, so one huge block can't
+	// hold the target suspended for long past it. the target should be suspended
+	// for the whole thing
+	size_t copyBlocks(const MemoryInformationCollection &blocks, const std::chrono::steady_clock::time_point &deadline);
+
+	virtual bool attach(const ProcessIdentifier &pid);
+	virtual bool isAttached() const;
+
+	virtual bool queryMemory(const MemoryAddress &adr, MemoryInformation& meminfo, MemoryAddress &nextAdr) const;
+
+	virtual bool isWithinModule(MemoryAddress &start, MemoryAddress &end) const;
+	virtual bool getMainModuleBounds(MemoryAddress &start, MemoryAddress &end) const;
+	virtual bool getModules(ModuleInformationCollection &modules) const;
+
+	virtual uint64_t getFileTime64() const;
+	virtual uint32_t getTickTime32() const;
+
+	// the regions never change, so this is always the same
+	virtual bool getRegionGeneration(uint64_t &generation) const;
+	virtual const uint8_t* getDirectPointer(const MemoryAddress &adr, const size_t &size) const;
+	virtual bool readPartial(const MemoryAddress &adr, const size_t &size, void* result, MemoryAddressBounds &unreadable) const;
+
+protected:
+	virtual bool rawRead(const MemoryAddress &adr, const size_t objectSize, void* result) const;
+	virtual bool rawWrite(const MemoryAddress &adr, const size_t objectSize, const void* const data) const;
+
+private:
+	static constexpr size_t CopyChunkSize = 0x100000;
+
+	struct Block
+	{
+		size_t base, end;
+		bool copied;
+		std::vector<uint8_t> data;
+		MemoryAddressBounds unreadable;
+	};
+
+	ScannerTargetShPtr target;
+	MemoryInformationCollection regions;
+	std::vector<Block> blocks; // sorted by base
+
+	// the copied block holding all of [adr, adr + size), if there is one
+	const Block* findCopy(const MemoryAddress &adr, const size_t &size) const;
+};
\ No newline at end of file
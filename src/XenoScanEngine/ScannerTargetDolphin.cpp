@@ -67,6 +67,9 @@ bool ScannerTargetDolphin::attach(const ProcessIdentifier &pid)
 			this->lowestAddress = map->logicalBase;
 	}
 
+	// the views are the only regions we have, and they only change here
+	this->regionGeneration++;
+
 	// we good!
 	return true;
 }
@@ -129,6 +132,12 @@ bool ScannerTargetDolphin::queryMemory(const MemoryAddress &adr, MemoryInformati
 	return false;
 }
 
+bool ScannerTargetDolphin::getRegionGeneration(uint64_t &generation) const
+{
+	generation = this->regionGeneration;
+	return this->isAttached();
+}
+
 bool ScannerTargetDolphin::isWithinModule(MemoryAddress &start, MemoryAddress &end) const
 {
 	return false;
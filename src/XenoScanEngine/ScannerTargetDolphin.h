@@ -27,6 +27,8 @@ public:
 	virtual uint64_t getFileTime64() const;
 	virtual uint32_t getTickTime32() const;
 
+	virtual bool getRegionGeneration(uint64_t &generation) const;
+
 protected:
 	virtual bool rawRead(const MemoryAddress &adr, const size_t objectSize, void* result) const;
 	virtual bool rawWrite(const MemoryAddress &adr, const size_t objectSize, const void* const data) const;
@@ -0,0 +1,652 @@
+#include "ScannerTargetLinux.h"
+
+#ifdef __linux__
+#include "Assert.h"
+#include "StdListBlueprint.h"
+#include "StdMapBlueprint.h"
+#include "StdVectorBlueprint.h"
+#include "StdUnorderedMapBlueprint.h"
+#include "NativeClassInstanceBlueprint.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include <thread>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ptrace.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+
+ScannerTargetLinux::ScannerTargetLinux() :
+	pid(0), memFile(-1), pageSize(0), vmCallsUnavailable(false), suspendMode(SUSPEND_NONE),
+	regions([this](MemoryInformationCollection &regions, ModuleInformationCollection &modules) -> void
+	{
+		ScannerTargetLinux::listRegions(this->procPath, regions, modules);
+	})
+{
+	this->supportedBlueprints.insert(StdListBlueprint::Key);
+	this->supportedBlueprints.insert(StdMapBlueprint::Key);
+	this->supportedBlueprints.insert(StdVectorBlueprint::Key);
+	this->supportedBlueprints.insert(StdUnorderedMapBlueprint::Key);
+	this->supportedBlueprints.insert(NativeClassInstanceBlueprint::Key);
+
+	this->pointerSize = sizeof(void*);
+
+	uint16_t endianness = 1;
+	this->littleEndian = (*(uint8_t*)&endianness == 1);
+
+	static_assert(sizeof(void*) <= sizeof(MemoryAddress), "MemoryAddress type is too small!");
+}
+
+ScannerTargetLinux::~ScannerTargetLinux()
+{
+	this->detach();
+}
+
+bool ScannerTargetLinux::attach(const ProcessIdentifier &pid)
+{
+	// detach if we're attached to something else
+	this->detach();
+
+	this->procPath = "/proc/" + std::to_string(pid);
+
+	// maps can only be read by someone who's allowed to read the memory, so
+	// if we get any regions out of it, we're good to go
+	ScannerTargetLinux::getAddressRange(this->pageSize, this->lowestAddress, this->highestAddress);
+	this->regions.refresh();
+	if (this->regions.empty())
+	{
+		this->procPath.clear();
+		return false;
+	}
+
+	// without this, there's nothing to fall back to (and huge reads are bisected too)
+	auto memPath = this->procPath + "/mem";
+	this->memFile = open(memPath.c_str(), O_RDWR | O_CLOEXEC);
+	if (this->memFile < 0)
+		this->memFile = open(memPath.c_str(), O_RDONLY | O_CLOEXEC);
+
+	// the target can be a 32bit (or other endian) process, which its ELF header says
+	uint8_t ident[6];
+	std::ifstream executable(this->procPath + "/exe", std::ios::binary);
+	if (executable.read((char*)ident, sizeof(ident)) && memcmp(ident, "\x7F" "ELF", 4) == 0)
+	{
+		this->pointerSize = (ident[4] == 1) ? 4 : 8;
+		this->littleEndian = (ident[5] == 1);
+	}
+
+	this->pid = pid;
+	this->vmCallsUnavailable = false;
+	return true;
+}
+
+bool ScannerTargetLinux::isAttached() const
+{
+	return !this->procPath.empty();
+}
+
+void ScannerTargetLinux::detach()
+{
+	this->resume();
+	if (this->memFile >= 0)
+	{
+		close(this->memFile);
+		this->memFile = -1;
+	}
+	this->procPath.clear();
+	this->pid = 0;
+}
+
+bool ScannerTargetLinux::queryMemory(const MemoryAddress &adr, MemoryInformation& meminfo, MemoryAddress &nextAdr) const
+{
+	ASSERT(this->isAttached());
+	return this->regions.query(adr, this->lowestAddress, this->highestAddress, meminfo, nextAdr);
+}
+
+bool ScannerTargetLinux::isWithinModule(MemoryAddress &start, MemoryAddress &end) const
+{
+	return this->regions.isWithinModule(start, end);
+}
+
+bool ScannerTargetLinux::getMainModuleBounds(MemoryAddress &start, MemoryAddress &end) const
+{
+	return this->regions.getMainModuleBounds(start, end);
+}
+
+bool ScannerTargetLinux::getModules(ModuleInformationCollection &modules) const
+{
+	this->regions.getModules(modules);
+	return true;
+}
+
+uint64_t ScannerTargetLinux::getFileTime64() const
+{
+	return ScannerTargetLinux::getSystemFileTime64();
+}
+
+uint32_t ScannerTargetLinux::getTickTime32() const
+{
+	return ScannerTargetLinux::getSystemTickTime32();
+}
+
+bool ScannerTargetLinux::rawRead(const MemoryAddress &adr, const size_t objectSize, void* result) const
+{
+	ASSERT(this->isAttached());
+	return (this->readFront((size_t)adr, objectSize, (uint8_t*)result) == objectSize);
+}
+
+bool ScannerTargetLinux::rawWrite(const MemoryAddress &adr, const size_t objectSize, const void* const data) const
+{
+	ASSERT(this->isAttached());
+	return this->writeAll((size_t)adr, objectSize, (const uint8_t*)data);
+}
+
+bool ScannerTargetLinux::suspend(const uint32_t &timeoutMs)
+{
+	ASSERT(this->isAttached());
+	if (this->suspendMode != SUSPEND_NONE)
+		return true;
+
+	// stopping ourselves would stop whoever is waiting on the suspend, too
+	if (this->pid == (ProcessIdentifier)getpid())
+		return false;
+
+	if (this->areAllThreadsStopped())
+	{
+		this->suspendMode = SUSPEND_ALREADY_STOPPED;
+		return true;
+	}
+
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+	if (this->suspendWithPtrace(deadline))
+		return true;
+	return (std::chrono::steady_clock::now() < deadline && this->suspendWithSignal(deadline));
+}
+
+void ScannerTargetLinux::resume()
+{
+	if (this->suspendMode == SUSPEND_PTRACE)
+	{
+		for (auto thread = this->seizedThreads.begin(); thread != this->seizedThreads.end(); thread++)
+		{
+			// seized threads can only be detached while they're stopped, so any thread
+			// that didn't stop in time is waited on. the interrupt is already on its way
+			int status;
+			while (!thread->stopped && waitpid(thread->tid, &status, __WALL) == thread->tid)
+				thread->stopped = WIFSTOPPED(status);
+			ptrace(PTRACE_DETACH, thread->tid, nullptr, (void*)(intptr_t)thread->signal);
+		}
+		this->seizedThreads.clear();
+	}
+	else if (this->suspendMode == SUSPEND_SIGNAL)
+		kill((pid_t)this->pid, SIGCONT);
+
+	this->suspendMode = SUSPEND_NONE;
+}
+
+std::vector<int> ScannerTargetLinux::listThreads() const
+{
+	std::vector<int> threads;
+	auto taskPath = this->procPath + "/task";
+	auto tasks = opendir(taskPath.c_str());
+	if (!tasks)
+		return threads;
+
+	while (auto task = readdir(tasks))
+	{
+		auto tid = atoi(task->d_name);
+		if (tid > 0)
+			threads.push_back(tid);
+	}
+	closedir(tasks);
+	return threads;
+}
+
+bool ScannerTargetLinux::areAllThreadsStopped() const
+{
+	auto threads = this->listThreads();
+	for (auto tid = threads.cbegin(); tid != threads.cend(); tid++)
+	{
+		// the state comes right after the name, which is in parens and can have anything in it
+		std::ifstream stat(this->procPath + "/task/" + std::to_string(*tid) + "/stat");
+		std::string line;
+		std::getline(stat, line);
+		auto nameEnd = line.rfind(')');
+		if (nameEnd == std::string::npos || nameEnd + 2 >= line.size())
+			continue; // it exited
+		auto state = line[nameEnd + 2];
+		if (state != 'T' && state != 't')
+			return false;
+	}
+	return !threads.empty();
+}
+
+bool ScannerTargetLinux::suspendWithPtrace(const std::chrono::steady_clock::time_point &deadline)
+{
+	// ptrace goes thread by thread, and threads can start while we're going through
+	// them, so the list is read again until there's nothing new on it
+	for (bool foundNew = true; foundNew; )
+	{
+		if (std::chrono::steady_clock::now() > deadline)
+		{
+			this->suspendMode = SUSPEND_PTRACE;
+			this->resume();
+			return false;
+		}
+
+		foundNew = false;
+		auto threads = this->listThreads();
+		for (auto tid = threads.cbegin(); tid != threads.cend(); tid++)
+		{
+			auto seized = std::find_if(this->seizedThreads.cbegin(), this->seizedThreads.cend(),
+				[tid](const SeizedThread &thread) -> bool { return (thread.tid == *tid); });
+			if (seized != this->seizedThreads.cend())
+				continue;
+
+			foundNew = true;
+			if (ptrace(PTRACE_SEIZE, *tid, nullptr, nullptr) != 0)
+			{
+				if (errno == ESRCH)
+					continue; // it exited
+				this->suspendMode = SUSPEND_PTRACE;
+				this->resume();
+				return false;
+			}
+
+			SeizedThread thread = { *tid, 0, false };
+			this->seizedThreads.push_back(thread);
+			ptrace(PTRACE_INTERRUPT, *tid, nullptr, nullptr);
+		}
+	}
+	this->suspendMode = SUSPEND_PTRACE;
+
+	// now wait for all of them to actually stop
+	size_t stopped = 0;
+	while (stopped < this->seizedThreads.size())
+	{
+		stopped = 0;
+		for (auto thread = this->seizedThreads.begin(); thread != this->seizedThreads.end(); )
+		{
+			int status;
+			auto result = thread->stopped ? 0 : waitpid(thread->tid, &status, __WALL | WNOHANG);
+			if ((result == thread->tid && !WIFSTOPPED(status)) || (result < 0 && errno == ECHILD))
+			{
+				thread = this->seizedThreads.erase(thread); // it exited
+				continue;
+			}
+
+			if (result == thread->tid)
+			{
+				// anything other than our interrupt is a signal that was on its way in
+				thread->stopped = true;
+				if ((status >> 16) != PTRACE_EVENT_STOP && WSTOPSIG(status) != SIGTRAP)
+					thread->signal = WSTOPSIG(status);
+			}
+			if (thread->stopped)
+				stopped++;
+			thread++;
+		}
+
+		if (stopped < this->seizedThreads.size())
+		{
+			if (std::chrono::steady_clock::now() > deadline)
+			{
+				this->resume();
+				return false;
+			}
+			std::this_thread::sleep_for(std::chrono::microseconds(50));
+		}
+	}
+	return true;
+}
+
+bool ScannerTargetLinux::suspendWithSignal(const std::chrono::steady_clock::time_point &deadline)
+{
+	if (kill((pid_t)this->pid, SIGSTOP) != 0)
+		return false;
+	this->suspendMode = SUSPEND_SIGNAL;
+
+	// the signal is delivered to each thread on its own time
+	while (!this->areAllThreadsStopped())
+	{
+		if (std::chrono::steady_clock::now() > deadline)
+		{
+			this->resume();
+			return false;
+		}
+		std::this_thread::sleep_for(std::chrono::microseconds(50));
+	}
+	return true;
+}
+
+bool ScannerTargetLinux::readPartial(const MemoryAddress &adr, const size_t &size, void* result, MemoryAddressBounds &unreadable) const
+{
+	ASSERT(this->isAttached());
+
+	auto start = (size_t)adr;
+	this->readSalvaging(start, size, (uint8_t*)result, unreadable);
+
+	// unreadable ranges are coalesced, so if all of it failed there's one range covering it
+	return !unreadable.contains(adr, (MemoryAddress)(start + size));
+}
+
+size_t ScannerTargetLinux::readBatch(MemoryBufferCollection &reads) const
+{
+	ASSERT(this->isAttached());
+
+	// as many buffers as the kernel takes go in each call. it stops at the first one
+	// that can't be read, so that one is dropped and the rest go again after it
+	size_t read = 0;
+	size_t next = 0;
+	std::vector<iovec> local, remote;
+	while (next < reads.size() && !this->vmCallsUnavailable)
+	{
+		local.clear();
+		remote.clear();
+		for (auto buffer = reads.begin() + next; buffer != reads.end() && local.size() < IOV_MAX; buffer++)
+		{
+			local.push_back({ buffer->data.empty() ? nullptr : &buffer->data[0], buffer->data.size() });
+			remote.push_back({ buffer->address, buffer->data.size() });
+		}
+
+		auto result = process_vm_readv(this->pid, &local[0], local.size(), &remote[0], remote.size(), 0);
+		if (result < 0 && (errno == EPERM || errno == ENOSYS))
+		{
+			this->vmCallsUnavailable = true;
+			break;
+		}
+
+		auto remaining = (size_t)std::max<ssize_t>(result, 0);
+		auto batchEnd = next + local.size();
+		for (; next < batchEnd; next++)
+		{
+			auto &buffer = reads[next];
+			if (!buffer.data.empty() && remaining >= buffer.data.size())
+			{
+				remaining -= buffer.data.size();
+				read++;
+				continue;
+			}
+
+			// empty, or the one that stopped the call
+			bool stoppedHere = !buffer.data.empty();
+			buffer.data.clear();
+			if (stoppedHere)
+			{
+				next++;
+				break;
+			}
+		}
+	}
+
+	// whatever is left goes one at a time, through /proc/<pid>/mem
+	for (; next < reads.size(); next++)
+	{
+		auto &buffer = reads[next];
+		if (!buffer.data.empty() && this->rawRead(buffer.address, buffer.data.size(), &buffer.data[0]))
+			read++;
+		else
+			buffer.data.clear();
+	}
+	return read;
+}
+
+size_t ScannerTargetLinux::writeBatch(const MemoryBufferCollection &writes) const
+{
+	ASSERT(this->isAttached());
+
+	// same as readBatch(), except there's nothing to clear
+	size_t written = 0;
+	size_t next = 0;
+	std::vector<iovec> local, remote;
+	while (next < writes.size() && !this->vmCallsUnavailable)
+	{
+		local.clear();
+		remote.clear();
+		for (auto write = writes.cbegin() + next; write != writes.cend() && local.size() < IOV_MAX; write++)
+		{
+			local.push_back({ write->data.empty() ? nullptr : (void*)&write->data[0], write->data.size() });
+			remote.push_back({ write->address, write->data.size() });
+		}
+
+		auto result = process_vm_writev(this->pid, &local[0], local.size(), &remote[0], remote.size(), 0);
+		if (result < 0 && (errno == EPERM || errno == ENOSYS))
+		{
+			this->vmCallsUnavailable = true;
+			break;
+		}
+
+		auto remaining = (size_t)std::max<ssize_t>(result, 0);
+		auto batchEnd = next + local.size();
+		for (; next < batchEnd; next++)
+		{
+			auto &write = writes[next];
+			if (!write.data.empty() && remaining >= write.data.size())
+			{
+				remaining -= write.data.size();
+				written++;
+			}
+			else if (!write.data.empty())
+			{
+				next++;
+				break;
+			}
+		}
+	}
+
+	for (; next < writes.size(); next++)
+	{
+		auto &write = writes[next];
+		if (!write.data.empty() && this->rawWrite(write.address, write.data.size(), &write.data[0]))
+			written++;
+	}
+	return written;
+}
+
+size_t ScannerTargetLinux::readFront(const size_t &address, const size_t &size, uint8_t* buffer) const
+{
+	if ((size < HugeReadSize || this->memFile < 0) && !this->vmCallsUnavailable)
+	{
+		iovec local = { buffer, size };
+		iovec remote = { (void*)address, size };
+		auto result = process_vm_readv(this->pid, &local, 1, &remote, 1, 0);
+		if (result >= 0)
+			return (size_t)result;
+		if (errno != EPERM && errno != ENOSYS)
+			return 0;
+		this->vmCallsUnavailable = true;
+	}
+
+	if (this->memFile < 0)
+		return 0;
+
+	// preads can come up short even when everything is readable, so keep going
+	// until one fails (or reads nothing), which means the next page is bad
+	size_t read = 0;
+	while (read < size)
+	{
+		auto result = pread(this->memFile, &buffer[read], size - read, (off_t)(address + read));
+		if (result <= 0)
+			break;
+		read += (size_t)result;
+	}
+	return read;
+}
+
+void ScannerTargetLinux::readSalvaging(size_t address, size_t size, uint8_t* buffer, MemoryAddressBounds &unreadable) const
+{
+	while (size)
+	{
+		auto read = this->readFront(address, size, buffer);
+		if (read == size)
+			return;
+		if (read)
+		{
+			address += read;
+			size -= read;
+			buffer += read;
+			continue;
+		}
+
+		// nothing came back at all. a single page is as small as unreadable memory
+		// gets, so that's where we stop. anything bigger gets split in half (on a
+		// page boundary) and each half is tried again
+		auto firstPageEnd = (address | (this->pageSize - 1)) + 1;
+		if (size <= firstPageEnd - address)
+		{
+			unreadable.insert((MemoryAddress)address, (MemoryAddress)(address + size));
+			return;
+		}
+
+		auto middle = std::max((address + (size / 2)) & ~(this->pageSize - 1), firstPageEnd);
+		auto firstSize = middle - address;
+		this->readSalvaging(address, firstSize, buffer, unreadable);
+
+		address = middle;
+		size -= firstSize;
+		buffer += firstSize;
+	}
+}
+
+bool ScannerTargetLinux::writeAll(const size_t &address, const size_t &size, const uint8_t* data) const
+{
+	if (!this->vmCallsUnavailable)
+	{
+		iovec local = { (void*)data, size };
+		iovec remote = { (void*)address, size };
+		auto result = process_vm_writev(this->pid, &local, 1, &remote, 1, 0);
+		if (result >= 0)
+			return ((size_t)result == size);
+		if (errno != EPERM && errno != ENOSYS)
+			return false;
+		this->vmCallsUnavailable = true;
+	}
+
+	if (this->memFile < 0)
+		return false;
+
+	size_t written = 0;
+	while (written < size)
+	{
+		auto result = pwrite(this->memFile, &data[written], size - written, (off_t)(address + written));
+		if (result <= 0)
+			return false;
+		written += (size_t)result;
+	}
+	return true;
+}
+
+void ScannerTargetLinux::listRegions(const std::string &procPath, MemoryInformationCollection &regions, ModuleInformationCollection &modules)
+{
+	// <procPath>/exe names the file that the main module was mapped from
+	char executable[4096];
+	auto executablePath = procPath + "/exe";
+	auto executableLength = readlink(executablePath.c_str(), executable, sizeof(executable) - 1);
+	executable[(executableLength > 0) ? executableLength : 0] = 0;
+
+	std::ifstream maps(procPath + "/maps");
+	std::vector<std::string> paths;
+	std::string line;
+	while (std::getline(maps, line))
+	{
+		// start-end perms offset device inode [path]
+		size_t start, end;
+		std::string permissions, offset, device, inode, path;
+		std::istringstream fields(line);
+		fields >> std::hex >> start;
+		fields.ignore(1);
+		fields >> end >> permissions >> offset >> device >> inode;
+		std::getline(fields >> std::ws, path);
+		if (fields.bad() || permissions.size() < 4 || start >= end)
+			continue;
+
+		// vsyscall sits above user space, and vvar can fault for parts of it
+		if (path == "[vsyscall]")
+			continue;
+		bool isSpecial = (path.compare(0, 5, "[vvar") == 0);
+
+		MemoryInformation meminfo;
+		meminfo.isModule = meminfo.isMirror = meminfo.isMappedImage = false;
+		meminfo.isCommitted = (permissions[0] == 'r' && !isSpecial);
+		meminfo.isWriteable = (permissions[1] == 'w');
+		meminfo.isExecutable = (permissions[2] == 'x');
+		meminfo.isMapped = (permissions[3] == 's' || (path.size() && path[0] == '/'));
+		meminfo.allocationBase = (MemoryAddress)start;
+		meminfo.allocationEnd = (MemoryAddress)end;
+		meminfo.allocationSize = end - start;
+		regions.push_back(meminfo);
+		paths.push_back(path);
+	}
+
+	// files with executable mappings are our modules, and all of their mappings
+	// are its image. everything else that came from a file stays just mapped.
+	// modules are named like they are on Windows, without their directory
+	std::vector<std::string> modulePaths;
+	for (size_t r = 0; r < regions.size(); r++)
+	{
+		if (!regions[r].isExecutable || !paths[r].size() || paths[r][0] != '/')
+			continue;
+		if (std::find(modulePaths.cbegin(), modulePaths.cend(), paths[r]) != modulePaths.cend())
+			continue;
+		modulePaths.push_back(paths[r]);
+
+		ModuleInformation module;
+		module.name = paths[r].substr(paths[r].find_last_of('/') + 1);
+		module.base = regions[r].allocationBase;
+		module.end = regions[r].allocationEnd;
+		for (size_t other = 0; other < regions.size(); other++)
+		{
+			if (paths[other] != paths[r])
+				continue;
+			regions[other].isMappedImage = true;
+			regions[other].isMapped = false;
+			module.base = std::min(module.base, regions[other].allocationBase);
+			module.end = std::max(module.end, regions[other].allocationEnd);
+		}
+
+		if (paths[r] == executable)
+			modules.insert(modules.begin(), module);
+		else
+			modules.push_back(module);
+	}
+}
+
+void ScannerTargetLinux::getAddressRange(size_t &pageSize, MemoryAddress &lowest, MemoryAddress &highest)
+{
+	pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	lowest = reinterpret_cast<MemoryAddress>(pageSize);
+
+	// the top of user space (47 bits) on the 64bit platforms we build for
+	highest = (sizeof(void*) == 8)
+		? reinterpret_cast<MemoryAddress>((size_t)0x800000000000 - pageSize)
+		: reinterpret_cast<MemoryAddress>((size_t)0xFFFFFFFF & ~(pageSize - 1));
+}
+
+uint64_t ScannerTargetLinux::getSystemFileTime64()
+{
+	// FILETIME counts 100ns intervals from 1601, which is this long before 1970
+	const uint64_t unixEpoch = 116444736000000000ULL;
+
+	timespec time;
+	clock_gettime(CLOCK_REALTIME, &time);
+	return unixEpoch + ((uint64_t)time.tv_sec * 10000000ULL) + ((uint64_t)time.tv_nsec / 100);
+}
+
+uint32_t ScannerTargetLinux::getSystemTickTime32()
+{
+	// milliseconds since boot, like GetTickCount()
+	timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return static_cast<uint32_t>(((uint64_t)time.tv_sec * 1000) + ((uint64_t)time.tv_nsec / 1000000));
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,130 @@
+#pragma once
+
+#ifndef XENOSCANENGINE_LIB
+#error This header is for internal library use. Include "ScannerTarget.h" instead.
+#endif
+
+
+// This file is include guarded because we want to ignore it on non-Linux systems.
+// CMake will stop the compiler from seeing it, but it wont stop inclusion.
+#ifdef __linux__
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "ScannerTarget.h"
+#include "RegionList.h"
+
+
+// We define NativeScannerTarget as ScannerTargetLinux so that the
+// factory will use this class for native processes
+#ifndef NativeScannerTarget
+#define NativeScannerTarget ScannerTargetLinux
+#else
+#error Only one NativeScannerTarget can exist!
+#endif
+
+/*
+	Linux processes are read with process_vm_readv, which copies straight from
+	their address space into ours in one syscall. If any page of a range can't be
+	read, the whole call fails. So readPartial() bisects failed ranges down to the
+	pages that really are unreadable, reports those, and keeps everything else.
+
+	Huge ranges are read with pread on /proc/<pid>/mem instead. A pread stops at
+	the first bad page and says how far it got, so it only has to be bisected
+	from there. /proc/<pid>/mem is also what everything falls back to when
+	process_vm_readv isn't allowed (or doesn't exist).
+
+	Regions come from /proc/<pid>/maps, and are kept in a RegionList, which
+	reads them again whenever a walk starts (a query at the lowest address).
+
+	suspend() seizes and interrupts every thread with ptrace, so nothing but us
+	ever sees the stop (the target's parent doesn't get a SIGCHLD, for one). If it
+	can't (another debugger, or ptrace being locked down), the whole process gets
+	a SIGSTOP instead, and a SIGCONT when it's resumed.
+*/
+class ScannerTargetLinux : public ScannerTarget
+{
+public:
+	static ScannerTarget::FACTORY_TYPE::KEY_TYPE Key;
+
+	ScannerTargetLinux();
+	~ScannerTargetLinux();
+
+	virtual bool attach(const ProcessIdentifier &pid);
+	virtual bool isAttached() const;
+
+	virtual bool queryMemory(const MemoryAddress &adr, MemoryInformation& meminfo, MemoryAddress &nextAdr) const;
+
+	virtual bool isWithinModule(MemoryAddress &start, MemoryAddress &end) const;
+	virtual bool getMainModuleBounds(MemoryAddress &start, MemoryAddress &end) const;
+	virtual bool getModules(ModuleInformationCollection &modules) const;
+
+	virtual uint64_t getFileTime64() const;
+	virtual uint32_t getTickTime32() const;
+
+	virtual bool suspend(const uint32_t &timeoutMs);
+	virtual void resume();
+
+	virtual bool readPartial(const MemoryAddress &adr, const size_t &size, void* result, MemoryAddressBounds &unreadable) const;
+	virtual size_t readBatch(MemoryBufferCollection &reads) const;
+	virtual size_t writeBatch(const MemoryBufferCollection &writes) const;
+
+	// these are shared with ScannerTargetSelf. procPath is "/proc/<pid>" or "/proc/self".
+	// regions come back in ascending order, without the free space between them, and
+	// modules (files with executable mappings) come back with the main one first
+	static void listRegions(const std::string &procPath, MemoryInformationCollection &regions, ModuleInformationCollection &modules);
+	static void getAddressRange(size_t &pageSize, MemoryAddress &lowest, MemoryAddress &highest);
+	static uint64_t getSystemFileTime64();
+	static uint32_t getSystemTickTime32();
+
+protected:
+	virtual bool rawRead(const MemoryAddress &adr, const size_t objectSize, void* result) const;
+	virtual bool rawWrite(const MemoryAddress &adr, const size_t objectSize, const void* const data) const;
+
+private:
+	// ranges this big are read from /proc/<pid>/mem
+	static constexpr size_t HugeReadSize = 0x4000000;
+
+	ProcessIdentifier pid;
+	std::string procPath;
+	int memFile;
+	size_t pageSize;
+
+	// set once process_vm_readv/writev turn out to be off limits
+	mutable std::atomic<bool> vmCallsUnavailable;
+
+	enum SuspendMode
+	{
+		SUSPEND_NONE,
+		SUSPEND_PTRACE,
+		SUSPEND_SIGNAL,
+		SUSPEND_ALREADY_STOPPED, // someone else stopped it, so they get to continue it
+	};
+	struct SeizedThread
+	{
+		int tid;
+		int signal; // a signal the thread stopped for, which is handed back when we let go
+		bool stopped;
+	};
+	SuspendMode suspendMode;
+	std::vector<SeizedThread> seizedThreads;
+
+	std::vector<int> listThreads() const;
+	bool areAllThreadsStopped() const;
+	bool suspendWithPtrace(const std::chrono::steady_clock::time_point &deadline);
+	bool suspendWithSignal(const std::chrono::steady_clock::time_point &deadline);
+
+	mutable RegionList regions;
+
+	void detach();
+
+	// reads as much as it can from the front of the range, and returns how much that was
+	size_t readFront(const size_t &address, const size_t &size, uint8_t* buffer) const;
+	void readSalvaging(size_t address, size_t size, uint8_t* buffer, MemoryAddressBounds &unreadable) const;
+	bool writeAll(const size_t &address, const size_t &size, const uint8_t* data) const;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,341 @@
+#include "ScannerTargetSelf.h"
+
+#include "Assert.h"
+#include "StdListBlueprint.h"
+#include "StdMapBlueprint.h"
+#include "StdVectorBlueprint.h"
+#include "StdUnorderedMapBlueprint.h"
+#include "NativeClassInstanceBlueprint.h"
+
+#include <cstring>
+
+ScannerTargetSelf::ScannerTargetSelf() :
+	attached(false), pageSize(0),
+	regions(&ScannerTargetSelf::listRegions)
+{
+	this->supportedBlueprints.insert(StdListBlueprint::Key);
+	this->supportedBlueprints.insert(StdMapBlueprint::Key);
+	this->supportedBlueprints.insert(StdVectorBlueprint::Key);
+	this->supportedBlueprints.insert(StdUnorderedMapBlueprint::Key);
+	this->supportedBlueprints.insert(NativeClassInstanceBlueprint::Key);
+
+	this->pointerSize = sizeof(void*);
+
+	uint16_t endianness = 1;
+	this->littleEndian = (*(uint8_t*)&endianness == 1);
+
+	static_assert(sizeof(void*) <= sizeof(MemoryAddress), "MemoryAddress type is too small!");
+}
+
+ScannerTargetSelf::~ScannerTargetSelf()
+{
+}
+
+bool ScannerTargetSelf::attach(const ProcessIdentifier &pid)
+{
+	if (pid != 0 && pid != ScannerTargetSelf::getCurrentProcessId())
+		return false;
+	if (!ScannerTargetSelf::installFaultHandler())
+		return false;
+
+	ScannerTargetSelf::getAddressRange(this->pageSize, this->lowestAddress, this->highestAddress);
+	this->regions.refresh();
+
+	this->attached = true;
+	return true;
+}
+
+bool ScannerTargetSelf::isAttached() const
+{
+	return this->attached;
+}
+
+bool ScannerTargetSelf::queryMemory(const MemoryAddress &adr, MemoryInformation& meminfo, MemoryAddress &nextAdr) const
+{
+	ASSERT(this->isAttached());
+	return this->regions.query(adr, this->lowestAddress, this->highestAddress, meminfo, nextAdr);
+}
+
+bool ScannerTargetSelf::isWithinModule(MemoryAddress &start, MemoryAddress &end) const
+{
+	return this->regions.isWithinModule(start, end);
+}
+
+bool ScannerTargetSelf::getMainModuleBounds(MemoryAddress &start, MemoryAddress &end) const
+{
+	return this->regions.getMainModuleBounds(start, end);
+}
+
+bool ScannerTargetSelf::getModules(ModuleInformationCollection &modules) const
+{
+	this->regions.getModules(modules);
+	return true;
+}
+
+bool ScannerTargetSelf::rawRead(const MemoryAddress &adr, const size_t objectSize, void* result) const
+{
+	ASSERT(this->isAttached());
+	return ScannerTargetSelf::probedCopy(result, adr, objectSize);
+}
+
+bool ScannerTargetSelf::rawWrite(const MemoryAddress &adr, const size_t objectSize, const void* const data) const
+{
+	ASSERT(this->isAttached());
+	return ScannerTargetSelf::probedCopy(adr, data, objectSize);
+}
+
+#ifdef WIN32
+#include <Windows.h>
+#include <tlhelp32.h>
+
+// the protection can carry PAGE_GUARD and friends in its upper bits
+#define WIN32_IS_EXECUTABLE_PROT(x) ((x & 0xFF) == PAGE_EXECUTE || (x & 0xFF) == PAGE_EXECUTE_READ || (x & 0xFF) == PAGE_EXECUTE_READWRITE || (x & 0xFF) == PAGE_EXECUTE_WRITECOPY)
+#define WIN32_IS_WRITEABLE_PROT(x) ((x & 0xFF) == PAGE_EXECUTE_READWRITE || (x & 0xFF) == PAGE_READWRITE)
+
+ProcessIdentifier ScannerTargetSelf::getCurrentProcessId()
+{
+	return static_cast<ProcessIdentifier>(GetCurrentProcessId());
+}
+
+bool ScannerTargetSelf::installFaultHandler()
+{
+	// SEH catches the faults right where they happen, so there's nothing to install
+	return true;
+}
+
+void ScannerTargetSelf::getAddressRange(size_t &pageSize, MemoryAddress &lowest, MemoryAddress &highest)
+{
+	SYSTEM_INFO sysinfo;
+	GetSystemInfo(&sysinfo);
+
+	pageSize = static_cast<size_t>(sysinfo.dwPageSize);
+	lowest = reinterpret_cast<MemoryAddress>(sysinfo.lpMinimumApplicationAddress);
+	highest = reinterpret_cast<MemoryAddress>(sysinfo.lpMaximumApplicationAddress);
+}
+
+void ScannerTargetSelf::listRegions(MemoryInformationCollection &regions, ModuleInformationCollection &modules)
+{
+	MemoryAddress lowest, highest;
+	size_t pageSize;
+	ScannerTargetSelf::getAddressRange(pageSize, lowest, highest);
+
+	MEMORY_BASIC_INFORMATION memoryInfo;
+	auto address = (size_t)lowest;
+	while (address < (size_t)highest && VirtualQuery((LPCVOID)address, &memoryInfo, sizeof(memoryInfo)))
+	{
+		address = (size_t)memoryInfo.BaseAddress + memoryInfo.RegionSize;
+		if (memoryInfo.State == MEM_FREE)
+			continue;
+
+		// touching a guard page from in here would take the guard away from
+		// whoever set it (usually a thread's stack), so those are never committed
+		MemoryInformation meminfo;
+		meminfo.isModule = meminfo.isMirror = false;
+		meminfo.isCommitted = (memoryInfo.State == MEM_COMMIT && !(memoryInfo.Protect & (PAGE_GUARD | PAGE_NOACCESS)));
+		meminfo.allocationBase = memoryInfo.BaseAddress;
+		meminfo.allocationSize = memoryInfo.RegionSize;
+		meminfo.allocationEnd = (MemoryAddress)address;
+		meminfo.isMappedImage = (memoryInfo.Type == MEM_IMAGE);
+		meminfo.isMapped = (memoryInfo.Type == MEM_MAPPED);
+		meminfo.isExecutable = WIN32_IS_EXECUTABLE_PROT(memoryInfo.Protect);
+		meminfo.isWriteable = WIN32_IS_WRITEABLE_PROT(memoryInfo.Protect);
+		regions.push_back(meminfo);
+	}
+
+	auto type = (sizeof(MemoryAddress) == 4) ? TH32CS_SNAPMODULE : (TH32CS_SNAPMODULE32 | TH32CS_SNAPMODULE);
+
+	MODULEENTRY32W entry;
+	entry.dwSize = sizeof(MODULEENTRY32W);
+
+	auto snapshot = CreateToolhelp32Snapshot(type, GetCurrentProcessId());
+	if (snapshot == INVALID_HANDLE_VALUE)
+		return;
+
+	// the first module is our executable, same as for ScannerTargetWindows
+	if (Module32FirstW(snapshot, &entry) == TRUE)
+	{
+		do
+		{
+			std::wstring name(entry.szModule);
+			ModuleInformation module;
+			module.name = std::string(name.begin(), name.end());
+			module.base = reinterpret_cast<MemoryAddress>(entry.modBaseAddr);
+			module.end = reinterpret_cast<MemoryAddress>(&entry.modBaseAddr[entry.modBaseSize]);
+			modules.push_back(module);
+		}
+		while (Module32NextW(snapshot, &entry) == TRUE);
+	}
+	CloseHandle(snapshot);
+}
+
+static inline int probeFilter(const DWORD &code)
+{
+	if (code == EXCEPTION_ACCESS_VIOLATION || code == EXCEPTION_IN_PAGE_ERROR || code == EXCEPTION_GUARD_PAGE)
+		return EXCEPTION_EXECUTE_HANDLER;
+	return EXCEPTION_CONTINUE_SEARCH;
+}
+
+bool ScannerTargetSelf::probedCopy(void* destination, const void* source, const size_t &size)
+{
+	__try
+	{
+		memcpy(destination, source, size);
+		return true;
+	}
+	__except (probeFilter(GetExceptionCode()))
+	{
+		return false;
+	}
+}
+
+uint64_t ScannerTargetSelf::getFileTime64() const
+{
+	FILETIME time;
+	GetSystemTimeAsFileTime(&time);
+
+	uint64_t ret;
+	static_assert(sizeof(ret) <= sizeof(time), "FILETIME must be able to fill uint64_t!");
+	memcpy(&ret, &time, sizeof(ret));
+	return ret;
+}
+
+uint32_t ScannerTargetSelf::getTickTime32() const
+{
+	return static_cast<uint32_t>(GetTickCount());
+}
+
+#else
+#include "ScannerTargetLinux.h"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <setjmp.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+// a thread inside of probedCopy() owns one of these, so the handler knows where to go.
+// thread_local isn't safe to touch from a signal handler (the first touch can allocate),
+// so it's a fixed table keyed by thread id instead. owner is a lock-free atomic and jump
+// is volatile, which is all a handler is allowed to rely on
+struct ProbeSlot
+{
+	std::atomic<long> owner;
+	sigjmp_buf* volatile jump;
+};
+static_assert(ATOMIC_LONG_LOCK_FREE == 2, "the probe table needs lock-free atomics");
+static const size_t ProbeSlotCount = 64;
+static ProbeSlot probeSlots[ProbeSlotCount];
+static struct sigaction previousSegvAction, previousBusAction;
+
+static inline long getProbeThreadId()
+{
+	// a raw syscall, unlike pthread_self() it's fine to call from the handler
+	return static_cast<long>(syscall(SYS_gettid));
+}
+
+static inline ProbeSlot* claimProbeSlot(const long &thread)
+{
+	// there are only ever as many copies going as there are scan threads, so
+	// running out means waiting for a copy to finish, which is quick
+	while (true)
+	{
+		for (size_t i = 0; i < ProbeSlotCount; i++)
+		{
+			long expected = 0;
+			if (probeSlots[i].owner.compare_exchange_strong(expected, thread))
+				return &probeSlots[i];
+		}
+		std::this_thread::yield();
+	}
+}
+
+static void handleProbeFault(int signal, siginfo_t* info, void* context)
+{
+	auto thread = getProbeThreadId();
+	for (size_t i = 0; i < ProbeSlotCount; i++)
+	{
+		auto &slot = probeSlots[i];
+		if (slot.owner.load() == thread && slot.jump)
+			siglongjmp(*slot.jump, 1);
+	}
+
+	// not a probe, so it's a real crash (or someone else's to handle)
+	auto &previous = (signal == SIGSEGV) ? previousSegvAction : previousBusAction;
+	if (previous.sa_flags & SA_SIGINFO)
+		previous.sa_sigaction(signal, info, context);
+	else if (previous.sa_handler == SIG_DFL)
+	{
+		// returning runs the faulting instruction again, which now kills us like it should
+		sigaction(signal, &previous, nullptr);
+	}
+	else if (previous.sa_handler != SIG_IGN)
+		previous.sa_handler(signal);
+}
+
+ProcessIdentifier ScannerTargetSelf::getCurrentProcessId()
+{
+	return static_cast<ProcessIdentifier>(getpid());
+}
+
+bool ScannerTargetSelf::installFaultHandler()
+{
+	static std::once_flag once;
+	static bool installed = false;
+	std::call_once(once, []() -> void
+	{
+		// SA_NODEFER leaves the signal unblocked when we jump out of the handler,
+		// which lets probedCopy() skip saving and restoring the signal mask
+		struct sigaction action;
+		memset(&action, 0, sizeof(action));
+		action.sa_sigaction = &handleProbeFault;
+		action.sa_flags = SA_SIGINFO | SA_NODEFER | SA_ONSTACK;
+		sigemptyset(&action.sa_mask);
+
+		installed = (sigaction(SIGSEGV, &action, &previousSegvAction) == 0 &&
+			sigaction(SIGBUS, &action, &previousBusAction) == 0);
+	});
+	return installed;
+}
+
+void ScannerTargetSelf::getAddressRange(size_t &pageSize, MemoryAddress &lowest, MemoryAddress &highest)
+{
+	ScannerTargetLinux::getAddressRange(pageSize, lowest, highest);
+}
+
+void ScannerTargetSelf::listRegions(MemoryInformationCollection &regions, ModuleInformationCollection &modules)
+{
+	ScannerTargetLinux::listRegions("/proc/self", regions, modules);
+}
+
+bool ScannerTargetSelf::probedCopy(void* destination, const void* source, const size_t &size)
+{
+	auto slot = claimProbeSlot(getProbeThreadId());
+
+	sigjmp_buf jump;
+	if (sigsetjmp(jump, 0) != 0)
+	{
+		slot->jump = nullptr;
+		slot->owner.store(0);
+		return false;
+	}
+
+	slot->jump = &jump;
+	memcpy(destination, source, size);
+	slot->jump = nullptr;
+	slot->owner.store(0);
+	return true;
+}
+
+uint64_t ScannerTargetSelf::getFileTime64() const
+{
+	return ScannerTargetLinux::getSystemFileTime64();
+}
+
+uint32_t ScannerTargetSelf::getTickTime32() const
+{
+	return ScannerTargetLinux::getSystemTickTime32();
+}
+
+#endif
\ No newline at end of file
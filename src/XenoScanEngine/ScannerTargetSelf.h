@@ -0,0 +1,67 @@
+#pragma once
+
+#ifndef XENOSCANENGINE_LIB
+#error This header is for internal library use. Include "ScannerTarget.h" instead.
+#endif
+
+#include "ScannerTarget.h"
+#include "RegionList.h"
+
+
+/*
+	A target for the process we're running in. Reads and writes are plain memcpy
+	calls, so scans of it don't make a single syscall per block, which makes it a
+	baseline for how fast the scanner itself can go. It works the same on Windows
+	and Linux, so the tests can use it on either.
+
+	Copies are probed: if a region goes away (or turns out to be unreadable) while
+	we copy from it, the fault is caught and the read just fails. On Windows
+	that's an SEH filter, on Linux it's a SIGSEGV/SIGBUS handler which
+	jumps back out of the copy (and hands any fault that isn't ours along to
+	whatever handler was there before).
+
+	Listing our regions can mean reading all of them at once (/proc/self/maps),
+	so they're kept in a RegionList, like ScannerTargetLinux keeps them.
+*/
+class ScannerTargetSelf : public ScannerTarget
+{
+public:
+	static ScannerTarget::FACTORY_TYPE::KEY_TYPE Key;
+
+	ScannerTargetSelf();
+	~ScannerTargetSelf();
+
+	// pid is either 0 or our own
+	virtual bool attach(const ProcessIdentifier &pid);
+	virtual bool isAttached() const;
+
+	virtual bool queryMemory(const MemoryAddress &adr, MemoryInformation& meminfo, MemoryAddress &nextAdr) const;
+
+	virtual bool isWithinModule(MemoryAddress &start, MemoryAddress &end) const;
+	virtual bool getMainModuleBounds(MemoryAddress &start, MemoryAddress &end) const;
+	virtual bool getModules(ModuleInformationCollection &modules) const;
+
+	virtual uint64_t getFileTime64() const;
+	virtual uint32_t getTickTime32() const;
+
+protected:
+	virtual bool rawRead(const MemoryAddress &adr, const size_t objectSize, void* result) const;
+	virtual bool rawWrite(const MemoryAddress &adr, const size_t objectSize, const void* const data) const;
+
+private:
+	bool attached;
+	size_t pageSize;
+	mutable RegionList regions;
+
+	// these helper functions will be implemented for each OS
+	static ProcessIdentifier getCurrentProcessId();
+	static bool installFaultHandler();
+	static void getAddressRange(size_t &pageSize, MemoryAddress &lowest, MemoryAddress &highest);
+
+	// regions come back in ascending order, without the free space between them. the
+	// main module comes first in modules
+	static void listRegions(MemoryInformationCollection &regions, ModuleInformationCollection &modules);
+
+	// copies size bytes, returning false instead of crashing if either side faults
+	static bool probedCopy(void* destination, const void* source, const size_t &size);
+};
\ No newline at end of file
@@ -0,0 +1,756 @@
+#include "ScannerTargetSnapshot.h"
+
+#include "Assert.h"
+#include "BlockCompressor.h"
+#include "StdListBlueprint.h"
+#include "StdMapBlueprint.h"
+#include "StdVectorBlueprint.h"
+#include "StdUnorderedMapBlueprint.h"
+#include "NativeClassInstanceBlueprint.h"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <cstring>
+#include <unordered_map>
+
+
+const char ScannerTargetSnapshot::Magic[8] = { 'X', 'E', 'N', 'O', 'S', 'N', 'A', 'P' };
+
+ScannerTargetSnapshot::ScannerTargetSnapshot() :
+	fileHandle(nullptr), mappingHandle(nullptr), mapping(nullptr), mappingSize(0),
+	fileTime64(0), tickTime32(0), mainModuleStart(0), mainModuleEnd(0), instanceId(0)
+{
+	this->pointerSize = sizeof(void*);
+	this->littleEndian = true;
+	this->lowestAddress = 0;
+	this->highestAddress = 0;
+}
+
+ScannerTargetSnapshot::~ScannerTargetSnapshot()
+{
+	this->detach();
+}
+
+bool ScannerTargetSnapshot::write(const ScannerTargetShPtr &target, const MemoryInformationCollection &blocks, const std::string &path, const SnapshotOptions &options)
+{
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+		return false;
+
+	SnapshotHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, ScannerTargetSnapshot::Magic, sizeof(header.magic));
+	header.version = ScannerTargetSnapshot::Version;
+	header.pointerSize = static_cast<uint32_t>(target->getPointerSize());
+	header.littleEndian = target->isLittleEndian() ? 1 : 0;
+	header.fileTime64 = target->getFileTime64();
+	header.tickTime32 = target->getTickTime32();
+	header.lowestAddress = (uint64_t)target->getLowestAddress();
+	header.highestAddress = (uint64_t)target->getHighestAddress();
+
+	MemoryAddress mainModuleStart, mainModuleEnd;
+	if (target->getMainModuleBounds(mainModuleStart, mainModuleEnd))
+	{
+		header.mainModuleStart = (uint64_t)mainModuleStart;
+		header.mainModuleEnd = (uint64_t)mainModuleEnd;
+	}
+
+	// the header gets written again at the end, once we know what's in the file
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	// paged regions put their pages into chunks, which get
+	// written out (and maybe compressed) whenever they fill up
+	std::vector<SnapshotPage> pages;
+	std::vector<SnapshotChunk> chunks;
+	std::vector<uint8_t> chunkBuffer(PagesPerChunk * PageSize);
+	std::vector<uint8_t> compressBuffer(BlockCompressor::getMaximumCompressedSize(chunkBuffer.size()));
+	uint32_t chunkPages = 0;
+	auto flushChunk = [&file, &chunks, &chunkBuffer, &compressBuffer, &chunkPages, &options]() -> void
+	{
+		if (!chunkPages)
+			return;
+
+		SnapshotChunk chunk;
+		chunk.dataOffset = static_cast<uint64_t>(file.tellp());
+		chunk.pageCount = chunkPages;
+		chunk.storedSize = static_cast<uint32_t>(chunkPages * PageSize);
+
+		// chunks which don't get any smaller are stored as they are
+		size_t compressedSize = 0;
+		if (options.compress)
+			compressedSize = BlockCompressor::compress(&chunkBuffer[0], chunk.storedSize, &compressBuffer[0], compressBuffer.size());
+		if (compressedSize && compressedSize < chunk.storedSize)
+		{
+			chunk.storedSize = static_cast<uint32_t>(compressedSize);
+			file.write(reinterpret_cast<const char*>(&compressBuffer[0]), compressedSize);
+		}
+		else
+			file.write(reinterpret_cast<const char*>(&chunkBuffer[0]), chunk.storedSize);
+
+		chunks.push_back(chunk);
+		chunkPages = 0;
+	};
+
+	// pages are deduplicated on a 128 bit hash of their contents
+	typedef std::pair<uint64_t, uint64_t> PageHash;
+	struct PageHashHasher
+	{
+		size_t operator()(const PageHash &hash) const { return static_cast<size_t>(hash.first); }
+	};
+	std::unordered_map<PageHash, SnapshotPage, PageHashHasher> storedPages;
+
+	auto addPage = [&](const uint8_t* page) -> void
+	{
+		SnapshotPage entry;
+		if (options.elideZeroPages && ScannerTargetSnapshot::isZeroPage(page))
+		{
+			entry.chunk = ZeroPage;
+			entry.slot = 0;
+			pages.push_back(entry);
+			return;
+		}
+
+		PageHash hash;
+		if (options.deduplicatePages)
+		{
+			uint64_t parts[2];
+			ScannerTargetSnapshot::hashPage(page, parts);
+			hash = std::make_pair(parts[0], parts[1]);
+
+			auto stored = storedPages.find(hash);
+			if (stored != storedPages.end())
+			{
+				pages.push_back(stored->second);
+				return;
+			}
+		}
+
+		entry.chunk = static_cast<uint32_t>(chunks.size());
+		entry.slot = chunkPages;
+		memcpy(&chunkBuffer[chunkPages * PageSize], page, PageSize);
+		if (++chunkPages == PagesPerChunk)
+			flushChunk();
+
+		if (options.deduplicatePages)
+			storedPages[hash] = entry;
+		pages.push_back(entry);
+	};
+
+	// big regions are copied over in pieces so we don't need a buffer as large
+	// as the largest region. regions we can't read are left out of the snapshot
+	const size_t pieceSize = 0x1000000;
+	std::vector<uint8_t> buffer;
+	std::vector<SnapshotRegion> regions;
+	for (auto block = blocks.cbegin(); block != blocks.cend(); block++)
+	{
+		SnapshotRegion region;
+		memset(&region, 0, sizeof(region));
+		region.base = (uint64_t)block->allocationBase;
+		region.size = block->allocationSize;
+
+		uint64_t offset = static_cast<uint64_t>(file.tellp());
+		if (options.isPaged())
+			region.dataOffset = pages.size();
+		else
+		{
+			offset = (offset + PageSize - 1) & ~(uint64_t)(PageSize - 1);
+			region.dataOffset = offset;
+			file.seekp(offset);
+		}
+
+		bool complete = true;
+		for (size_t done = 0; done < block->allocationSize; done += pieceSize)
+		{
+			auto size = std::min(pieceSize, block->allocationSize - done);
+			buffer.resize((size < PageSize) ? PageSize : size);
+			auto bufferPointer = &buffer[0];
+			if (!target->readArray<uint8_t>((MemoryAddress)((size_t)block->allocationBase + done), size, bufferPointer))
+			{
+				complete = false;
+				break;
+			}
+
+			if (!options.isPaged())
+			{
+				file.write(reinterpret_cast<const char*>(bufferPointer), size);
+				continue;
+			}
+
+			// a partial page at the end of a region gets padded with zeros
+			for (size_t page = 0; page < size; page += PageSize)
+			{
+				if (size - page < PageSize)
+				{
+					memmove(&buffer[0], &buffer[page], size - page);
+					memset(&buffer[size - page], 0, PageSize - (size - page));
+					addPage(&buffer[0]);
+				}
+				else
+					addPage(&buffer[page]);
+			}
+		}
+
+		if (!complete)
+		{
+			// pages which made it into chunks are just orphaned
+			if (options.isPaged())
+				pages.resize(static_cast<size_t>(region.dataOffset));
+			else
+				file.seekp(offset);
+			continue;
+		}
+
+		region.flags =
+			(block->isModule ? SNAPSHOT_REGION_MODULE : 0) |
+			(block->isCommitted ? SNAPSHOT_REGION_COMMITTED : 0) |
+			(block->isMirror ? SNAPSHOT_REGION_MIRROR : 0) |
+			(block->isWriteable ? SNAPSHOT_REGION_WRITEABLE : 0) |
+			(block->isExecutable ? SNAPSHOT_REGION_EXECUTABLE : 0) |
+			(block->isMappedImage ? SNAPSHOT_REGION_MAPPED_IMAGE : 0) |
+			(block->isMapped ? SNAPSHOT_REGION_MAPPED : 0) |
+			(options.isPaged() ? SNAPSHOT_REGION_PAGED : 0);
+		regions.push_back(region);
+	}
+	flushChunk();
+
+	ModuleInformationCollection modules;
+	target->getModules(modules);
+
+	header.regionCount = regions.size();
+	header.moduleCount = modules.size();
+	header.regionTableOffset = static_cast<uint64_t>(file.tellp());
+	if (regions.size())
+		file.write(reinterpret_cast<const char*>(&regions[0]), regions.size() * sizeof(SnapshotRegion));
+
+	// names go after the module table, so we know where they'll land up front
+	uint64_t nameOffset = header.regionTableOffset + regions.size() * sizeof(SnapshotRegion) + modules.size() * sizeof(SnapshotModule);
+	for (auto module = modules.cbegin(); module != modules.cend(); module++)
+	{
+		SnapshotModule entry;
+		entry.base = (uint64_t)module->base;
+		entry.end = (uint64_t)module->end;
+		entry.nameOffset = nameOffset;
+		entry.nameLength = module->name.length();
+		file.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+		nameOffset += entry.nameLength;
+	}
+	for (auto module = modules.cbegin(); module != modules.cend(); module++)
+		file.write(module->name.c_str(), module->name.length());
+
+	header.pageCount = pages.size();
+	header.pageTableOffset = static_cast<uint64_t>(file.tellp());
+	if (pages.size())
+		file.write(reinterpret_cast<const char*>(&pages[0]), pages.size() * sizeof(SnapshotPage));
+
+	header.chunkCount = chunks.size();
+	header.chunkTableOffset = static_cast<uint64_t>(file.tellp());
+	if (chunks.size())
+		file.write(reinterpret_cast<const char*>(&chunks[0]), chunks.size() * sizeof(SnapshotChunk));
+
+	file.seekp(0);
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	return file.good();
+}
+
+bool ScannerTargetSnapshot::attach(const ProcessIdentifier &/*pid*/)
+{
+	// snapshots are files, see attachFile()
+	return false;
+}
+
+bool ScannerTargetSnapshot::attachFile(const std::string &path)
+{
+	this->detach();
+
+	this->mapping = ScannerTargetSnapshot::mapFile(path, this->mappingSize, this->fileHandle, this->mappingHandle);
+	if (!this->mapping)
+		return false;
+
+	if (!this->parse())
+	{
+		this->detach();
+		return false;
+	}
+
+	// blueprints read pointers as MemoryAddress, so they only
+	// work on snapshots of targets that look like we do
+	this->supportedBlueprints.clear();
+	if (this->pointerSize == sizeof(void*) && this->littleEndian)
+	{
+		this->supportedBlueprints.insert(StdListBlueprint::Key);
+		this->supportedBlueprints.insert(StdMapBlueprint::Key);
+		this->supportedBlueprints.insert(StdVectorBlueprint::Key);
+		this->supportedBlueprints.insert(StdUnorderedMapBlueprint::Key);
+		this->supportedBlueprints.insert(NativeClassInstanceBlueprint::Key);
+	}
+
+	// a fresh id makes sure no thread uses a chunk it cached from an old file
+	static std::atomic<uint64_t> nextInstanceId(1);
+	this->instanceId = nextInstanceId++;
+
+	this->regionGeneration++;
+	return true;
+}
+
+bool ScannerTargetSnapshot::isAttached() const
+{
+	return (this->mapping != nullptr);
+}
+
+bool ScannerTargetSnapshot::parse()
+{
+	if (this->mappingSize < sizeof(SnapshotHeader))
+		return false;
+
+	SnapshotHeader header;
+	memcpy(&header, this->mapping, sizeof(header));
+	if (memcmp(header.magic, ScannerTargetSnapshot::Magic, sizeof(header.magic)) != 0 || header.version != ScannerTargetSnapshot::Version)
+		return false;
+
+	// make sure that nothing in the tables points outside of the file. the counts
+	// come from the file, so they're divided into what's left instead of multiplied
+	// out, which a corrupt count could overflow
+	auto fileSize = static_cast<uint64_t>(this->mappingSize);
+	if (header.regionTableOffset > fileSize)
+		return false;
+	auto tablesRemaining = fileSize - header.regionTableOffset;
+	if (header.regionCount > tablesRemaining / sizeof(SnapshotRegion))
+		return false;
+	tablesRemaining -= header.regionCount * sizeof(SnapshotRegion);
+	if (header.moduleCount > tablesRemaining / sizeof(SnapshotModule))
+		return false;
+
+	this->pointerSize = header.pointerSize;
+	this->littleEndian = (header.littleEndian != 0);
+	this->fileTime64 = header.fileTime64;
+	this->tickTime32 = header.tickTime32;
+	this->lowestAddress = (MemoryAddress)header.lowestAddress;
+	this->highestAddress = (MemoryAddress)header.highestAddress;
+	this->mainModuleStart = (MemoryAddress)header.mainModuleStart;
+	this->mainModuleEnd = (MemoryAddress)header.mainModuleEnd;
+
+	// the page and chunk tables have to be in place before any paged region
+	if (header.pageTableOffset > fileSize || header.pageCount > (fileSize - header.pageTableOffset) / sizeof(SnapshotPage))
+		return false;
+	if (header.chunkTableOffset > fileSize || header.chunkCount > (fileSize - header.chunkTableOffset) / sizeof(SnapshotChunk))
+		return false;
+
+	auto chunkTable = &this->mapping[header.chunkTableOffset];
+	for (uint64_t i = 0; i < header.chunkCount; i++)
+	{
+		SnapshotChunk entry;
+		memcpy(&entry, &chunkTable[i * sizeof(SnapshotChunk)], sizeof(entry));
+		if (entry.dataOffset > fileSize || entry.storedSize > fileSize - entry.dataOffset)
+			return false;
+		if (entry.pageCount == 0 || entry.pageCount > PagesPerChunk || entry.storedSize > entry.pageCount * PageSize)
+			return false;
+
+		Chunk chunk;
+		chunk.data = &this->mapping[entry.dataOffset];
+		chunk.storedSize = entry.storedSize;
+		chunk.pageCount = entry.pageCount;
+		this->chunks.push_back(chunk);
+	}
+
+	this->pages.resize(static_cast<size_t>(header.pageCount));
+	if (header.pageCount)
+		memcpy(&this->pages[0], &this->mapping[header.pageTableOffset], this->pages.size() * sizeof(SnapshotPage));
+	for (auto page = this->pages.cbegin(); page != this->pages.cend(); page++)
+	{
+		if (page->chunk != ZeroPage && (page->chunk >= this->chunks.size() || page->slot >= this->chunks[page->chunk].pageCount))
+			return false;
+	}
+
+	auto regionTable = &this->mapping[header.regionTableOffset];
+	for (uint64_t i = 0; i < header.regionCount; i++)
+	{
+		SnapshotRegion entry;
+		memcpy(&entry, &regionTable[i * sizeof(SnapshotRegion)], sizeof(entry));
+		Region region;
+		if (entry.flags & SNAPSHOT_REGION_PAGED)
+		{
+			auto pageCount = (entry.size + PageSize - 1) / PageSize;
+			if (entry.dataOffset > header.pageCount || pageCount > header.pageCount - entry.dataOffset)
+				return false;
+			region.data = nullptr;
+			region.firstPage = entry.dataOffset;
+		}
+		else
+		{
+			if (entry.dataOffset > fileSize || entry.size > fileSize - entry.dataOffset)
+				return false;
+			region.data = &this->mapping[entry.dataOffset];
+			region.firstPage = 0;
+		}
+		region.meminfo.allocationBase = (MemoryAddress)entry.base;
+		region.meminfo.allocationSize = static_cast<size_t>(entry.size);
+		region.meminfo.allocationEnd = (MemoryAddress)(entry.base + entry.size);
+		region.meminfo.isModule = (entry.flags & SNAPSHOT_REGION_MODULE) != 0;
+		region.meminfo.isCommitted = (entry.flags & SNAPSHOT_REGION_COMMITTED) != 0;
+		region.meminfo.isMirror = (entry.flags & SNAPSHOT_REGION_MIRROR) != 0;
+		region.meminfo.isWriteable = (entry.flags & SNAPSHOT_REGION_WRITEABLE) != 0;
+		region.meminfo.isExecutable = (entry.flags & SNAPSHOT_REGION_EXECUTABLE) != 0;
+		region.meminfo.isMappedImage = (entry.flags & SNAPSHOT_REGION_MAPPED_IMAGE) != 0;
+		region.meminfo.isMapped = (entry.flags & SNAPSHOT_REGION_MAPPED) != 0;
+		this->regions.push_back(region);
+	}
+
+	std::sort(this->regions.begin(), this->regions.end(),
+		[](const Region &a, const Region &b) -> bool { return a.meminfo.allocationBase < b.meminfo.allocationBase; }
+	);
+
+	auto moduleTable = &regionTable[header.regionCount * sizeof(SnapshotRegion)];
+	for (uint64_t i = 0; i < header.moduleCount; i++)
+	{
+		SnapshotModule entry;
+		memcpy(&entry, &moduleTable[i * sizeof(SnapshotModule)], sizeof(entry));
+		if (entry.nameOffset > fileSize || entry.nameLength > fileSize - entry.nameOffset)
+			return false;
+
+		ModuleInformation module;
+		module.name = std::string(reinterpret_cast<const char*>(&this->mapping[entry.nameOffset]), static_cast<size_t>(entry.nameLength));
+		module.base = (MemoryAddress)entry.base;
+		module.end = (MemoryAddress)entry.end;
+		this->modules.push_back(module);
+		this->moduleBounds.insert(module.base, module.end);
+	}
+
+	return true;
+}
+
+void ScannerTargetSnapshot::detach()
+{
+	if (this->mapping)
+		ScannerTargetSnapshot::unmapFile(this->mapping, this->mappingSize, this->fileHandle, this->mappingHandle);
+
+	this->mapping = nullptr;
+	this->mappingSize = 0;
+	this->fileHandle = nullptr;
+	this->mappingHandle = nullptr;
+	this->regions.clear();
+	this->pages.clear();
+	this->chunks.clear();
+	this->modules.clear();
+	this->moduleBounds.clear();
+}
+
+std::vector<ScannerTargetSnapshot::Region>::const_iterator ScannerTargetSnapshot::findRegion(const MemoryAddress &adr) const
+{
+	// the only region which can hold the address is the last one starting at or before it
+	auto region = std::upper_bound(
+		this->regions.cbegin(), this->regions.cend(), adr,
+		[](const MemoryAddress &a, const Region &b) -> bool { return a < b.meminfo.allocationBase; }
+	);
+	if (region == this->regions.cbegin())
+		return this->regions.cend();
+
+	region--;
+	return (adr < region->meminfo.allocationEnd) ? region : this->regions.cend();
+}
+
+bool ScannerTargetSnapshot::queryMemory(const MemoryAddress &adr, MemoryInformation& meminfo, MemoryAddress &nextAdr) const
+{
+	ASSERT(this->isAttached());
+
+	// if the address isn't in a region, give back the next region above it
+	auto region = this->findRegion(adr);
+	if (region == this->regions.cend())
+	{
+		region = std::upper_bound(
+			this->regions.cbegin(), this->regions.cend(), adr,
+			[](const MemoryAddress &a, const Region &b) -> bool { return a < b.meminfo.allocationBase; }
+		);
+	}
+
+	if (region == this->regions.cend())
+	{
+		nextAdr = this->highestAddress;
+		return false;
+	}
+
+	meminfo = region->meminfo;
+	nextAdr = meminfo.allocationEnd;
+	return true;
+}
+
+bool ScannerTargetSnapshot::isWithinModule(MemoryAddress &start, MemoryAddress &end) const
+{
+	return this->moduleBounds.contains(start, end);
+}
+
+bool ScannerTargetSnapshot::getMainModuleBounds(MemoryAddress &start, MemoryAddress &end) const
+{
+	start = this->mainModuleStart;
+	end = this->mainModuleEnd;
+	return (this->mainModuleStart != this->mainModuleEnd);
+}
+
+bool ScannerTargetSnapshot::getModules(ModuleInformationCollection &modules) const
+{
+	modules = this->modules;
+	return true;
+}
+
+uint64_t ScannerTargetSnapshot::getFileTime64() const
+{
+	// time stands still in a snapshot, so dynamic values
+	// compare against the moment it was captured
+	return this->fileTime64;
+}
+
+uint32_t ScannerTargetSnapshot::getTickTime32() const
+{
+	return this->tickTime32;
+}
+
+bool ScannerTargetSnapshot::getRegionGeneration(uint64_t &generation) const
+{
+	generation = this->regionGeneration;
+	return this->isAttached();
+}
+
+const uint8_t* ScannerTargetSnapshot::getDirectPointer(const MemoryAddress &adr, const size_t &size) const
+{
+	auto region = this->findRegion(adr);
+	if (region == this->regions.cend() || !region->data)
+		return nullptr;
+
+	auto offset = (size_t)adr - (size_t)region->meminfo.allocationBase;
+	if (size > region->meminfo.allocationSize - offset)
+		return nullptr;
+	return &region->data[offset];
+}
+
+bool ScannerTargetSnapshot::getZeroPages(const MemoryAddress &start, const MemoryAddress &end, MemoryAddressBounds &zeroPages) const
+{
+	auto region = this->findRegion(start);
+	if (region == this->regions.cend() || region->data)
+		return false;
+
+	auto base = (size_t)region->meminfo.allocationBase;
+	auto first = ((size_t)start - base) / PageSize;
+	auto last = (std::min((size_t)end, (size_t)region->meminfo.allocationEnd) - base + PageSize - 1) / PageSize;
+	for (auto page = first; page < last; page++)
+	{
+		if (this->pages[region->firstPage + page].chunk == ZeroPage)
+		{
+			auto pageStart = base + page * PageSize;
+			auto pageEnd = std::min(pageStart + PageSize, (size_t)region->meminfo.allocationEnd);
+			zeroPages.insert((MemoryAddress)pageStart, (MemoryAddress)pageEnd);
+		}
+	}
+	return true;
+}
+
+const uint8_t* ScannerTargetSnapshot::getChunkData(const uint32_t &chunk) const
+{
+	auto &info = this->chunks[chunk];
+	if (!info.isCompressed())
+		return info.data;
+
+	// scans read front to back, so remembering the last chunk each thread
+	// decompressed means that every chunk gets decompressed about once
+	struct ChunkCache
+	{
+		uint64_t instanceId;
+		uint32_t chunk;
+		std::vector<uint8_t> data;
+	};
+	static thread_local ChunkCache cache = {};
+	if (cache.instanceId == this->instanceId && cache.chunk == chunk)
+		return &cache.data[0];
+
+	cache.data.resize(info.pageCount * PageSize);
+	if (!BlockCompressor::decompress(info.data, info.storedSize, &cache.data[0], cache.data.size()))
+	{
+		cache.instanceId = 0;
+		return nullptr;
+	}
+
+	cache.instanceId = this->instanceId;
+	cache.chunk = chunk;
+	return &cache.data[0];
+}
+
+bool ScannerTargetSnapshot::rawRead(const MemoryAddress &adr, const size_t objectSize, void* result) const
+{
+	ASSERT(this->isAttached());
+
+	auto region = this->findRegion(adr);
+	if (region == this->regions.cend())
+		return false;
+
+	auto offset = (size_t)adr - (size_t)region->meminfo.allocationBase;
+	if (objectSize > region->meminfo.allocationSize - offset)
+		return false;
+
+	if (region->data)
+	{
+		memcpy(result, &region->data[offset], objectSize);
+		return true;
+	}
+
+	// paged regions are put back together a page at a time
+	auto output = static_cast<uint8_t*>(result);
+	for (size_t remaining = objectSize; remaining; )
+	{
+		auto pageOffset = offset % PageSize;
+		auto size = std::min(PageSize - pageOffset, remaining);
+
+		auto &page = this->pages[region->firstPage + (offset / PageSize)];
+		if (page.chunk == ZeroPage)
+			memset(output, 0, size);
+		else
+		{
+			auto data = this->getChunkData(page.chunk);
+			if (!data)
+				return false;
+			memcpy(output, &data[page.slot * PageSize + pageOffset], size);
+		}
+
+		output += size;
+		offset += size;
+		remaining -= size;
+	}
+	return true;
+}
+
+bool ScannerTargetSnapshot::rawWrite(const MemoryAddress &/*adr*/, const size_t /*objectSize*/, const void* const /*data*/) const
+{
+	// snapshots are read only
+	return false;
+}
+
+
+
+bool ScannerTargetSnapshot::isZeroPage(const uint8_t* page)
+{
+	uint64_t combined = 0;
+	for (size_t i = 0; i < PageSize; i += sizeof(uint64_t))
+	{
+		uint64_t word;
+		memcpy(&word, &page[i], sizeof(word));
+		combined |= word;
+	}
+	return (combined == 0);
+}
+
+void ScannerTargetSnapshot::hashPage(const uint8_t* page, uint64_t hash[2])
+{
+	// two independently mixed 64 bit lanes. this isn't cryptographic,
+	// but with 128 bits an accidental collision isn't a real concern
+	uint64_t a = 0x9E3779B97F4A7C15ULL, b = 0xC2B2AE3D27D4EB4FULL;
+	for (size_t i = 0; i < PageSize; i += sizeof(uint64_t))
+	{
+		uint64_t word;
+		memcpy(&word, &page[i], sizeof(word));
+		a = (a ^ word) * 0xFF51AFD7ED558CCDULL;
+		a = (a << 31) | (a >> 33);
+		b = (b + word) * 0xC4CEB9FE1A85EC53ULL;
+		b = ((b << 27) | (b >> 37)) ^ a;
+	}
+
+	auto finalize = [](uint64_t value) -> uint64_t
+	{
+		value ^= value >> 33;
+		value *= 0xFF51AFD7ED558CCDULL;
+		value ^= value >> 33;
+		value *= 0xC4CEB9FE1A85EC53ULL;
+		value ^= value >> 33;
+		return value;
+	};
+	hash[0] = finalize(a);
+	hash[1] = finalize(b + a);
+}
+
+
+
+#ifdef WIN32
+#include <Windows.h>
+
+const uint8_t* ScannerTargetSnapshot::mapFile(const std::string &path, size_t &size, void* &fileHandle, void* &mappingHandle)
+{
+	static_assert(sizeof(void*) >= sizeof(HANDLE), "void* should be able to store a handle!");
+
+	auto file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return nullptr;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0 || (uint64_t)fileSize.QuadPart > SIZE_MAX)
+	{
+		CloseHandle(file);
+		return nullptr;
+	}
+
+	auto map = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!map)
+	{
+		CloseHandle(file);
+		return nullptr;
+	}
+
+	auto view = (const uint8_t*)MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0);
+	if (!view)
+	{
+		CloseHandle(map);
+		CloseHandle(file);
+		return nullptr;
+	}
+
+	size = static_cast<size_t>(fileSize.QuadPart);
+	fileHandle = (void*)file;
+	mappingHandle = (void*)map;
+	return view;
+}
+
+void ScannerTargetSnapshot::unmapFile(const uint8_t* mapping, const size_t &/*size*/, void* fileHandle, void* mappingHandle)
+{
+	UnmapViewOfFile((void*)mapping);
+	CloseHandle((HANDLE)mappingHandle);
+	CloseHandle((HANDLE)fileHandle);
+}
+
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+const uint8_t* ScannerTargetSnapshot::mapFile(const std::string &path, size_t &size, void* &fileHandle, void* &mappingHandle)
+{
+	auto file = open(path.c_str(), O_RDONLY);
+	if (file < 0)
+		return nullptr;
+
+	struct stat info;
+	if (fstat(file, &info) != 0 || info.st_size == 0)
+	{
+		close(file);
+		return nullptr;
+	}
+
+	auto view = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	if (view == MAP_FAILED)
+	{
+		close(file);
+		return nullptr;
+	}
+
+	// scans walk each region front to back
+	madvise(view, info.st_size, MADV_SEQUENTIAL);
+
+	size = static_cast<size_t>(info.st_size);
+	fileHandle = (void*)(intptr_t)file;
+	mappingHandle = nullptr;
+	return (const uint8_t*)view;
+}
+
+void ScannerTargetSnapshot::unmapFile(const uint8_t* mapping, const size_t &size, void* fileHandle, void* /*mappingHandle*/)
+{
+	munmap((void*)mapping, size);
+	close((int)(intptr_t)fileHandle);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,173 @@
+#pragma once
+
+#ifndef XENOSCANENGINE_LIB
+#error This header is for internal library use. Include "ScannerTarget.h" instead.
+#endif
+
+#include <string>
+#include <vector>
+
+#include "ScannerTarget.h"
+
+/*
+	A snapshot is a copy of a target's scannable memory, stored in a file so that
+	it can be scanned later (and as many times as we want) without the target.
+	The file looks like:
+
+		SnapshotHeader
+		<region data, each region starting on a page boundary>
+		<chunk data>
+		SnapshotRegion[regionCount]          <- at regionTableOffset
+		SnapshotModule[moduleCount]          <- right after the regions
+		<module names, back to back>
+		SnapshotPage[pageCount]              <- at pageTableOffset
+		SnapshotChunk[chunkCount]            <- at chunkTableOffset
+
+	The whole file is mapped, so reads come straight out of the mapping
+	and the scanner can use the data without copying it at all.
+
+	Depending on the SnapshotOptions, regions can instead be paged. Their data
+	is then a run of entries in the page table, each of which says the page is
+	all zeros or where it lives in a chunk. Chunks hold a handful of (unique)
+	pages, and are optionally compressed. They're decompressed lazily as
+	they're read, so paged regions can't be scanned in place.
+*/
+class ScannerTargetSnapshot : public ScannerTarget
+{
+public:
+	static ScannerTarget::FACTORY_TYPE::KEY_TYPE Key;
+
+	ScannerTargetSnapshot();
+	~ScannerTargetSnapshot();
+
+	static bool write(const ScannerTargetShPtr &target, const MemoryInformationCollection &blocks, const std::string &path, const SnapshotOptions &options);
+
+	virtual bool attach(const ProcessIdentifier &pid);
+	virtual bool attachFile(const std::string &path);
+	virtual bool isAttached() const;
+
+	virtual bool queryMemory(const MemoryAddress &adr, MemoryInformation& meminfo, MemoryAddress &nextAdr) const;
+
+	virtual bool isWithinModule(MemoryAddress &start, MemoryAddress &end) const;
+	virtual bool getMainModuleBounds(MemoryAddress &start, MemoryAddress &end) const;
+	virtual bool getModules(ModuleInformationCollection &modules) const;
+
+	virtual uint64_t getFileTime64() const;
+	virtual uint32_t getTickTime32() const;
+
+	virtual bool getRegionGeneration(uint64_t &generation) const;
+	virtual const uint8_t* getDirectPointer(const MemoryAddress &adr, const size_t &size) const;
+	virtual bool getZeroPages(const MemoryAddress &start, const MemoryAddress &end, MemoryAddressBounds &zeroPages) const;
+
+protected:
+	virtual bool rawRead(const MemoryAddress &adr, const size_t objectSize, void* result) const;
+	virtual bool rawWrite(const MemoryAddress &adr, const size_t objectSize, const void* const data) const;
+
+private:
+	static const char Magic[8];
+	static const uint32_t Version = 2;
+	static const size_t PageSize = 0x1000;
+	static const size_t PagesPerChunk = 16;
+	static const uint32_t ZeroPage = 0xFFFFFFFF;
+
+	enum SnapshotRegionFlags : uint32_t
+	{
+		SNAPSHOT_REGION_MODULE =       1 << 0,
+		SNAPSHOT_REGION_COMMITTED =    1 << 1,
+		SNAPSHOT_REGION_MIRROR =       1 << 2,
+		SNAPSHOT_REGION_WRITEABLE =    1 << 3,
+		SNAPSHOT_REGION_EXECUTABLE =   1 << 4,
+		SNAPSHOT_REGION_MAPPED_IMAGE = 1 << 5,
+		SNAPSHOT_REGION_MAPPED =       1 << 6,
+		SNAPSHOT_REGION_PAGED =        1 << 7, // dataOffset is an index in the page table
+	};
+
+	// everything on disk is fixed-size, so snapshots taken by 32bit
+	// and 64bit builds (or of 32bit and 64bit targets) are the same
+#pragma pack(push, 1)
+	struct SnapshotHeader
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t pointerSize;
+		uint32_t littleEndian;
+		uint32_t tickTime32;
+		uint64_t fileTime64;
+		uint64_t lowestAddress, highestAddress;
+		uint64_t mainModuleStart, mainModuleEnd;
+		uint64_t regionCount, moduleCount;
+		uint64_t regionTableOffset;
+		uint64_t pageCount, pageTableOffset;
+		uint64_t chunkCount, chunkTableOffset;
+	};
+
+	struct SnapshotRegion
+	{
+		uint64_t base, size;
+		uint64_t dataOffset;
+		uint32_t flags;
+		uint32_t reserved;
+	};
+
+	struct SnapshotModule
+	{
+		uint64_t base, end;
+		uint64_t nameOffset, nameLength;
+	};
+
+	struct SnapshotPage
+	{
+		uint32_t chunk; // ZeroPage if the page isn't stored
+		uint32_t slot;  // which page of the chunk this is
+	};
+
+	struct SnapshotChunk
+	{
+		uint64_t dataOffset;
+		uint32_t storedSize; // same as pageCount * PageSize if it isn't compressed
+		uint32_t pageCount;
+	};
+#pragma pack(pop)
+
+	struct Region
+	{
+		MemoryInformation meminfo;
+		const uint8_t* data;  // null if the region is paged
+		uint64_t firstPage;
+	};
+
+	struct Chunk
+	{
+		const uint8_t* data;
+		uint32_t storedSize, pageCount;
+		inline bool isCompressed() const { return (this->storedSize != this->pageCount * PageSize); }
+	};
+
+	void* fileHandle;
+	void* mappingHandle;
+	const uint8_t* mapping;
+	size_t mappingSize;
+
+	uint64_t fileTime64;
+	uint32_t tickTime32;
+	MemoryAddress mainModuleStart, mainModuleEnd;
+
+	uint64_t instanceId;
+	std::vector<Region> regions;
+	std::vector<SnapshotPage> pages;
+	std::vector<Chunk> chunks;
+	ModuleInformationCollection modules;
+	MemoryAddressBounds moduleBounds;
+
+	void detach();
+	bool parse();
+	std::vector<Region>::const_iterator findRegion(const MemoryAddress &adr) const;
+	const uint8_t* getChunkData(const uint32_t &chunk) const;
+
+	static bool isZeroPage(const uint8_t* page);
+	static void hashPage(const uint8_t* page, uint64_t hash[2]);
+
+	// these helper functions will be implemented for each OS
+	static const uint8_t* mapFile(const std::string &path, size_t &size, void* &fileHandle, void* &mappingHandle);
+	static void unmapFile(const uint8_t* mapping, const size_t &size, void* fileHandle, void* mappingHandle);
+};
\ No newline at end of file
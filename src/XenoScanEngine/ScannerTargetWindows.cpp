@@ -3,6 +3,8 @@
 #include "Assert.h"
 #include "StdListBlueprint.h"
 #include "StdMapBlueprint.h"
+#include "StdVectorBlueprint.h"
+#include "StdUnorderedMapBlueprint.h"
 #include "NativeClassInstanceBlueprint.h"
 
 #include <Windows.h>
@@ -18,6 +20,8 @@ ScannerTargetWindows::ScannerTargetWindows() :
 {
 	this->supportedBlueprints.insert(StdListBlueprint::Key);
 	this->supportedBlueprints.insert(StdMapBlueprint::Key);
+	this->supportedBlueprints.insert(StdVectorBlueprint::Key);
+	this->supportedBlueprints.insert(StdUnorderedMapBlueprint::Key);
 	this->supportedBlueprints.insert(NativeClassInstanceBlueprint::Key);
 
 	this->pointerSize = sizeof(void*);
@@ -28,6 +32,7 @@ ScannerTargetWindows::ScannerTargetWindows() :
 
 ScannerTargetWindows::~ScannerTargetWindows()
 {
+	this->resume();
 	if (this->processHandle)
 	{
 		CloseHandle(reinterpret_cast<HANDLE>(this->processHandle));
@@ -40,6 +45,7 @@ bool ScannerTargetWindows::attach(const ProcessIdentifier &pid)
 	// detach if we're attached to something else
 	if (this->isAttached())
 	{
+		this->resume();
 		CloseHandle(this->processHandle);
 		this->processHandle = NULL;
 	}
@@ -127,6 +133,12 @@ bool ScannerTargetWindows::getMainModuleBounds(MemoryAddress &start, MemoryAddre
 	return true;
 }
 
+bool ScannerTargetWindows::getModules(ModuleInformationCollection &modules) const
+{
+	modules = this->modules;
+	return true;
+}
+
 uint64_t ScannerTargetWindows::getFileTime64() const
 {
 	FILETIME time;
@@ -143,6 +155,75 @@ uint32_t ScannerTargetWindows::getTickTime32() const
 	return static_cast<uint32_t>(GetTickCount());
 }
 
+bool ScannerTargetWindows::suspend(const uint32_t &timeoutMs)
+{
+	ASSERT(this->isAttached());
+	if (!this->suspendedThreads.empty())
+		return true;
+
+	// suspending our own threads would suspend whoever is waiting on the suspend, too
+	if (this->pid == GetCurrentProcessId())
+		return false;
+
+	// threads can start while we're going through them, so the
+	// list is taken again until there's nothing new on it
+	auto deadline = GetTickCount64() + timeoutMs;
+	std::set<DWORD> seen;
+	for (bool foundNew = true; foundNew; )
+	{
+		foundNew = false;
+		auto snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0);
+		if (snapshot == INVALID_HANDLE_VALUE)
+			break;
+
+		THREADENTRY32 entry;
+		entry.dwSize = sizeof(THREADENTRY32);
+		if (Thread32First(snapshot, &entry) == TRUE)
+		{
+			do
+			{
+				if (entry.th32OwnerProcessID != this->pid || !seen.insert(entry.th32ThreadID).second)
+					continue;
+				foundNew = true;
+
+				auto thread = OpenThread(THREAD_SUSPEND_RESUME | THREAD_GET_CONTEXT, FALSE, entry.th32ThreadID);
+				if (!thread)
+					continue;
+				if (SuspendThread(thread) == (DWORD)-1)
+				{
+					CloseHandle(thread);
+					continue;
+				}
+
+				// SuspendThread() only asks, and getting the context waits until it's done
+				CONTEXT context;
+				context.ContextFlags = CONTEXT_CONTROL;
+				GetThreadContext(thread, &context);
+				this->suspendedThreads.push_back(thread);
+			}
+			while (Thread32Next(snapshot, &entry) == TRUE);
+		}
+		CloseHandle(snapshot);
+
+		if (GetTickCount64() > deadline)
+		{
+			this->resume();
+			return false;
+		}
+	}
+	return !this->suspendedThreads.empty();
+}
+
+void ScannerTargetWindows::resume()
+{
+	for (auto thread = this->suspendedThreads.cbegin(); thread != this->suspendedThreads.cend(); thread++)
+	{
+		ResumeThread((HANDLE)*thread);
+		CloseHandle((HANDLE)*thread);
+	}
+	this->suspendedThreads.clear();
+}
+
 bool ScannerTargetWindows::rawRead(const MemoryAddress &adr, const size_t objectSize, void* result) const
 {
 	ASSERT(this->isAttached());
@@ -159,6 +240,7 @@ void ScannerTargetWindows::buildModuleBounds()
 {
 	// WARNING: not thread safe for any updated members
 	this->moduleBounds.clear();
+	this->modules.clear();
 
 	auto type = (sizeof(MemoryAddress) == 4)
 		? TH32CS_SNAPMODULE // if we're 32bit, just query "native modules"
@@ -182,6 +264,13 @@ void ScannerTargetWindows::buildModuleBounds()
 				reinterpret_cast<MemoryAddress>(entry.modBaseAddr),
 				reinterpret_cast<MemoryAddress>(&entry.modBaseAddr[entry.modBaseSize])
 			);
+
+			std::wstring name(entry.szModule);
+			ModuleInformation module;
+			module.name = std::string(name.begin(), name.end());
+			module.base = reinterpret_cast<MemoryAddress>(entry.modBaseAddr);
+			module.end = reinterpret_cast<MemoryAddress>(&entry.modBaseAddr[entry.modBaseSize]);
+			this->modules.push_back(module);
 		}
 		while (Module32NextW(snapshot, &entry) == TRUE);
 	}
@@ -8,6 +8,8 @@
 // This file is include guarded because we want to ignore it on non-Windows systems.
 // CMake will stop the compiler from seeing it, but it wont stop inclusion.
 #ifdef WIN32 
+#include <vector>
+
 #include "ScannerTarget.h"
 
 
@@ -34,10 +36,14 @@ public:
 	
 	virtual bool isWithinModule(MemoryAddress &start, MemoryAddress &end) const;
 	virtual bool getMainModuleBounds(MemoryAddress &start, MemoryAddress &end) const;
+	virtual bool getModules(ModuleInformationCollection &modules) const;
 
 	virtual uint64_t getFileTime64() const;
 	virtual uint32_t getTickTime32() const;
 
+	virtual bool suspend(const uint32_t &timeoutMs);
+	virtual void resume();
+
 protected:
 	virtual bool rawRead(const MemoryAddress &adr, const size_t objectSize, void* result) const;
 	virtual bool rawWrite(const MemoryAddress &adr, const size_t objectSize, const void* const data) const;
@@ -46,8 +52,10 @@ private:
 	ProcessIdentifier pid;
 	ProcessHandle processHandle;
 	MemoryAddressBounds moduleBounds;
+	ModuleInformationCollection modules;
 	MemoryAddress mainModuleStart, mainModuleEnd;
 	size_t pageSize;
+	std::vector<void*> suspendedThreads;
 
 	void buildModuleBounds();
 };
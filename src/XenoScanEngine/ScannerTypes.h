@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <string>
 #include <vector>
 
 #include "BoundingList.h"
@@ -25,17 +26,41 @@ struct MemoryInformation
 
 typedef std::vector<MemoryInformation> MemoryInformationCollection;
 
+struct ModuleInformation
+{
+	std::string name;
+	MemoryAddress base, end;
+};
+
+typedef std::vector<ModuleInformation> ModuleInformationCollection;
 
-struct MemoryAddressBoundsComparator
+// controls how much work goes into making a snapshot small. with everything
+// off, a snapshot is a straight copy of memory which can be scanned in place
+struct SnapshotOptions
 {
-	typedef std::tuple<MemoryAddress, MemoryAddress> Range;
-	static bool CompareBounds(const Range& a, const Range& b)
+	bool elideZeroPages;   // don't store pages which are all zeros
+	bool deduplicatePages; // store pages with the same contents only once
+	bool compress;         // compress stored pages, in chunks
+
+	SnapshotOptions() : elideZeroPages(false), deduplicatePages(false), compress(false) {}
+
+	inline bool isPaged() const
 	{
-		return (std::get<0>(a) < std::get<0>(b) && std::get<1>(a) < std::get<1>(b));
+		return (this->elideZeroPages || this->deduplicatePages || this->compress);
 	}
 };
 
-typedef BoundingList<MemoryAddress, MemoryAddressBoundsComparator> MemoryAddressBounds;
+
+typedef BoundingList<MemoryAddress> MemoryAddressBounds;
+
+
+// a run of bytes to read or write, for targets that can do a batch of them at once
+struct MemoryBuffer
+{
+	MemoryAddress address;
+	std::vector<uint8_t> data;
+};
+typedef std::vector<MemoryBuffer> MemoryBufferCollection;
 
 
 // this represents an entire block of logically mapped memory
@@ -0,0 +1,132 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+#include <memory>
+
+#include "Assert.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+
+// A fixed-size bitset stored as blocks that can be shared between bitsets. A
+// block that is all clear isn't stored at all, and blocks with the same bits as
+// another bitset's can point at that bitset's block (see shareBlocksWith()), so
+// a set of bitsets which are mostly the same costs little more than one of them.
+// Once built, shared blocks must not change, so set() is only for building.
+class SharedBitset
+{
+public:
+	SharedBitset() : bitCount(0), setCount(0) {}
+	SharedBitset(const size_t &size, const bool &value) :
+		bitCount(size), setCount(value ? size : 0),
+		blocks((size + BitsPerBlock - 1) / BitsPerBlock)
+	{
+		if (!value || !size)
+			return;
+
+		// every full block can point to the same bits
+		auto full = std::make_shared<Block>(WordsPerBlock, ~0ULL);
+		for (size_t i = 0; i < this->blocks.size(); i++)
+			this->blocks[i] = full;
+
+		// but the last one can't have bits past the end
+		auto tail = size % BitsPerBlock;
+		if (tail)
+		{
+			auto last = std::make_shared<Block>(WordsPerBlock, 0);
+			for (size_t bit = 0; bit < tail; bit++)
+				(*last)[bit / 64] |= (1ULL << (bit % 64));
+			this->blocks.back() = last;
+		}
+	}
+
+	inline size_t size() const { return this->bitCount; }
+	inline size_t count() const { return this->setCount; }
+
+	inline bool test(const size_t &index) const
+	{
+		ASSERT(index < this->bitCount);
+		auto &block = this->blocks[index / BitsPerBlock];
+		if (!block)
+			return false;
+		return ((*block)[(index % BitsPerBlock) / 64] & (1ULL << (index % 64))) != 0;
+	}
+
+	inline void set(const size_t &index)
+	{
+		ASSERT(index < this->bitCount);
+		auto &block = this->blocks[index / BitsPerBlock];
+		if (!block)
+			block = std::make_shared<Block>(WordsPerBlock, 0);
+		ASSERT(block.use_count() == 1);
+
+		auto &word = (*block)[(index % BitsPerBlock) / 64];
+		auto bit = (1ULL << (index % 64));
+		if (!(word & bit))
+		{
+			word |= bit;
+			this->setCount++;
+		}
+	}
+
+	// returns the first set bit at or after index, or size() if there isn't one
+	inline size_t findNext(size_t index) const
+	{
+		while (index < this->bitCount)
+		{
+			auto &block = this->blocks[index / BitsPerBlock];
+			if (!block)
+			{
+				index = (index / BitsPerBlock + 1) * BitsPerBlock;
+				continue;
+			}
+
+			auto wordIndex = (index % BitsPerBlock) / 64;
+			auto word = (*block)[wordIndex] & (~0ULL << (index % 64));
+			if (word)
+			{
+				auto found = (index - (index % 64)) + SharedBitset::countTrailingZeros(word);
+				return (found < this->bitCount) ? found : this->bitCount;
+			}
+			index = (index - (index % 64)) + 64;
+		}
+		return this->bitCount;
+	}
+
+	// any block which has the same bits as the one in other is swapped for other's
+	void shareBlocksWith(const SharedBitset &other)
+	{
+		ASSERT(other.bitCount == this->bitCount);
+		for (size_t i = 0; i < this->blocks.size(); i++)
+		{
+			auto &mine = this->blocks[i];
+			auto &theirs = other.blocks[i];
+			if (mine && theirs && mine != theirs && *mine == *theirs)
+				mine = theirs;
+		}
+	}
+
+private:
+	// constexpr so they can be passed by reference without a definition
+	static constexpr size_t BitsPerBlock = 4096;
+	static constexpr size_t WordsPerBlock = BitsPerBlock / 64;
+	typedef std::vector<uint64_t> Block;
+
+	size_t bitCount, setCount;
+	std::vector<std::shared_ptr<Block>> blocks;
+
+	static inline size_t countTrailingZeros(const uint64_t &value)
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		if (_BitScanForward(&index, (unsigned long)(value & 0xFFFFFFFF)))
+			return index;
+		_BitScanForward(&index, (unsigned long)(value >> 32));
+		return index + 32;
+#else
+		return __builtin_ctzll(value);
+#endif
+	}
+};
\ No newline at end of file
@@ -54,6 +54,7 @@ public:
 						{
 							details.identifier = *object;
 							details.members.insert(std::make_pair(ItemCountTag, ScanVariant::FromNumber(size)));
+							details.nodes = objects;
 							return true;
 						}
 					}
@@ -185,6 +185,8 @@ private:
 		if (searched.size() <= 1) // we'll often find thousands of 1-sized maps, don't waste allocation time on them
 			return false;
 		details.members.insert(std::make_pair(ItemCountTag, ScanVariant::FromNumber(searched.size())));
+		details.nodes.assign(searched.begin(), searched.end());
+		details.nodes.push_back(details.identifier);
 		return true;
 	}
 };
\ No newline at end of file
@@ -0,0 +1,277 @@
+#pragma once
+
+#include <algorithm>
+
+#include "Assert.h"
+#include "ScannerTarget.h"
+#include "ScannerTypes.h"
+#include "ScanVariant.h"
+#include "DataStructureBlueprint.h"
+
+class StdUnorderedMapBlueprint : public DataStructureBlueprint
+{
+public:
+	static DataStructureBlueprint::FACTORY_TYPE::KEY_TYPE Key;
+
+	// anything bigger than this is much more likely to be garbage than a real
+	// bucket count. smaller garbage is caught by bucketsFitInRegion()
+	static const size_t MaxBucketCount = 0x1000000;
+
+	inline virtual bool walkStructure(
+		const ScannerTargetShPtr &target,
+		const MemoryAddress &startPointer,
+		const PointerMap &pointerMap,
+		DataStructureDetails& details) const
+	{
+		// the start pointer can be either the list head (MSVC)
+		// or the bucket array (libstdc++), so we try both
+		auto located = pointerMap.find(startPointer);
+		if (located == pointerMap.end())
+			return false;
+
+		for (auto ref = located->second.cbegin(); ref != located->second.cend(); ref++)
+		{
+			if (this->validateMSVC(target, *ref, pointerMap, details))
+				return true;
+			if (this->validateGNU(target, *ref, pointerMap, details))
+				return true;
+		}
+		return false;
+	}
+
+	virtual inline void findMatches(
+		const ScannerTargetShPtr &target,
+		const PointerMap &pointerMap,
+		DataStructureResultMap& results)
+	{
+		// Both layouts start with pointers that the pointer locator already found,
+		// so the location index lets us find candidates without reading anything.
+		//
+		// MSVC looks like:
+		//     <list head>                       <- location
+		//     <size>
+		//     <bucket vector first>
+		//     <bucket vector last>
+		//     <bucket vector end>
+		//     <mask>
+		//     <bucket count>
+		//
+		// libstdc++ looks like:
+		//     <bucket array>                    <- location
+		//     <bucket count>
+		//     <before begin, pointing to first node>
+		//     <element count>
+		PointerLocationIndex index;
+		DataStructureBlueprint::buildLocationIndex(pointerMap, index);
+
+		std::vector<MemoryAddress> msvcCandidates, gnuCandidates;
+		for (size_t i = 0; i < index.size(); i++)
+		{
+			auto location = index[i].first;
+
+			auto vectorFirst = target->incrementAddress(location, 2);
+			auto vectorLast = target->incrementAddress(location, 3);
+			auto vectorEnd = target->incrementAddress(location, 4);
+			if (this->hasLocation(index, i, vectorFirst) &&
+				this->hasLocation(index, i, vectorLast) &&
+				this->hasLocation(index, i, vectorEnd))
+				msvcCandidates.push_back(location);
+
+			auto beforeBegin = target->incrementAddress(location, 2);
+			if (this->hasLocation(index, i, beforeBegin))
+				gnuCandidates.push_back(location);
+		}
+
+		// Now validate what's left. Each candidate reads its header and
+		// its entire bucket array in one go, and every bucket is checked
+		// against the pointer map instead of walking the node list.
+		auto &found = results[this->getTypeName()];
+		for (auto candidate = msvcCandidates.cbegin(); candidate != msvcCandidates.cend(); candidate++)
+		{
+			DataStructureDetails details;
+			if (this->validateMSVC(target, *candidate, pointerMap, details))
+				found[details.identifier] = details;
+		}
+		for (auto candidate = gnuCandidates.cbegin(); candidate != gnuCandidates.cend(); candidate++)
+		{
+			if (found.find(*candidate) != found.end())
+				continue;
+
+			DataStructureDetails details;
+			if (this->validateGNU(target, *candidate, pointerMap, details))
+				found[details.identifier] = details;
+		}
+	}
+
+	virtual std::string getTypeName() const
+	{
+		return StdUnorderedMapBlueprint::Key;
+	}
+
+private:
+	inline bool hasLocation(
+		const PointerLocationIndex &index,
+		const size_t &from,
+		const MemoryAddress &location) const
+	{
+		// the locations we look for are always just after the one at [from],
+		// so a short forward search beats a binary search here
+		for (size_t i = from + 1; i < index.size() && index[i].first <= location; i++)
+			if (index[i].first == location)
+				return true;
+		return false;
+	}
+
+	inline bool isNode(const PointerMap &pointerMap, const MemoryAddress &node) const
+	{
+		// every node is pointed to by its neighbours, so it's in the pointer map
+		return (pointerMap.find(node) != pointerMap.end());
+	}
+
+	inline bool isPowerOfTwo(const size_t &value) const
+	{
+		return (value != 0 && (value & (value - 1)) == 0);
+	}
+
+	inline bool bucketsFitInRegion(const ScannerTargetShPtr &target, const MemoryAddress &buckets, const size_t &count) const
+	{
+		// a believable bucket count in garbage would otherwise have us reading (and
+		// allocating) up to MaxBucketCount pointers, so the array has to fit inside
+		// of the committed region that it starts in
+		MemoryInformation meminfo;
+		MemoryAddress next;
+		if (!target->queryMemory(buckets, meminfo, next) || !meminfo.isCommitted)
+			return false;
+		if (buckets < meminfo.allocationBase || buckets >= meminfo.allocationEnd)
+			return false;
+		return ((size_t)meminfo.allocationEnd - (size_t)buckets) / target->getPointerSize() >= count;
+	}
+
+	inline bool validateMSVC(
+		const ScannerTargetShPtr &target,
+		const MemoryAddress &location,
+		const PointerMap &pointerMap,
+		DataStructureDetails& details) const
+	{
+		MemoryAddress header[7];
+		auto headerPointer = &header[0];
+		if (!target->readArray<MemoryAddress>(location, 7, headerPointer))
+			return false;
+
+		auto head = header[0];
+		auto size = (size_t)header[1];
+		auto first = header[2];
+		auto last = header[3];
+		auto end = header[4];
+		auto mask = (size_t)header[5];
+		auto bucketCount = (size_t)header[6];
+
+		// the bucket vector holds a pair of iterators for every bucket, the
+		// bucket count is a power of two, and the mask is one less than it
+		if (size == 0 || !this->isPowerOfTwo(bucketCount) || bucketCount > MaxBucketCount)
+			return false;
+		if (mask != bucketCount - 1)
+			return false;
+		if (first > last || last > end || ((size_t)first % target->getPointerSize()) != 0)
+			return false;
+		if ((size_t)last - (size_t)first != bucketCount * 2 * target->getPointerSize())
+			return false;
+		if (!this->isNode(pointerMap, head))
+			return false;
+		if (!this->bucketsFitInRegion(target, first, bucketCount * 2))
+			return false;
+
+		// empty buckets have both iterators pointing at the list head,
+		// everything else has to point at a node
+		std::vector<MemoryAddress> buckets(bucketCount * 2);
+		auto bucketsPointer = &buckets[0];
+		if (!target->readArray<MemoryAddress>(first, buckets.size(), bucketsPointer))
+			return false;
+
+		size_t usedBuckets = 0;
+		for (size_t i = 0; i < buckets.size(); i += 2)
+		{
+			auto low = buckets[i];
+			auto high = buckets[i + 1];
+			if ((low == head) != (high == head))
+				return false;
+			if (low == head)
+				continue;
+			if (!this->isNode(pointerMap, low) || !this->isNode(pointerMap, high))
+				return false;
+			usedBuckets++;
+		}
+		if (usedBuckets == 0 || usedBuckets > size)
+			return false;
+
+		this->describeMap(location, size, bucketCount, "msvc", details);
+		return true;
+	}
+
+	inline bool validateGNU(
+		const ScannerTargetShPtr &target,
+		const MemoryAddress &location,
+		const PointerMap &pointerMap,
+		DataStructureDetails& details) const
+	{
+		MemoryAddress header[4];
+		auto headerPointer = &header[0];
+		if (!target->readArray<MemoryAddress>(location, 4, headerPointer))
+			return false;
+
+		auto bucketArray = header[0];
+		auto bucketCount = (size_t)header[1];
+		auto firstNode = header[2];
+		auto count = (size_t)header[3];
+
+		// a map with a single bucket is always empty, since the first
+		// insert will rehash it, and we don't waste time on empty maps
+		if (count == 0 || bucketCount <= 1 || bucketCount > MaxBucketCount)
+			return false;
+		if (((size_t)bucketArray % target->getPointerSize()) != 0)
+			return false;
+		if (!this->isNode(pointerMap, firstNode))
+			return false;
+		if (!this->bucketsFitInRegion(target, bucketArray, bucketCount))
+			return false;
+
+		// each bucket points to the node *before* its first node, so empty buckets
+		// are null, the bucket holding the first node points back into the header,
+		// and everything else has to point at a node
+		std::vector<MemoryAddress> buckets(bucketCount);
+		auto bucketsPointer = &buckets[0];
+		if (!target->readArray<MemoryAddress>(bucketArray, buckets.size(), bucketsPointer))
+			return false;
+
+		auto beforeBegin = target->incrementAddress(location, 2);
+		size_t usedBuckets = 0, headBuckets = 0;
+		for (auto bucket = buckets.cbegin(); bucket != buckets.cend(); bucket++)
+		{
+			if (*bucket == nullptr)
+				continue;
+			if (*bucket == beforeBegin)
+				headBuckets++;
+			else if (!this->isNode(pointerMap, *bucket))
+				return false;
+			usedBuckets++;
+		}
+		if (headBuckets != 1 || usedBuckets > count)
+			return false;
+
+		this->describeMap(location, count, bucketCount, "libstdc++", details);
+		return true;
+	}
+
+	inline void describeMap(
+		const MemoryAddress &location,
+		const size_t &size,
+		const size_t &bucketCount,
+		const std::string &layout,
+		DataStructureDetails& details) const
+	{
+		details.identifier = location;
+		details.members.insert(std::make_pair(ItemCountTag, ScanVariant::FromNumber(size)));
+		details.members.insert(std::make_pair(BucketCountTag, ScanVariant::FromNumber(bucketCount)));
+		details.members.insert(std::make_pair(LayoutTag, ScanVariant::FromString(layout)));
+	}
+};
\ No newline at end of file
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <algorithm>
+
+#include "Assert.h"
+#include "ScannerTarget.h"
+#include "ScannerTypes.h"
+#include "ScanVariant.h"
+#include "DataStructureBlueprint.h"
+
+class StdVectorBlueprint : public DataStructureBlueprint
+{
+public:
+	static DataStructureBlueprint::FACTORY_TYPE::KEY_TYPE Key;
+
+	// we can't know the element type, so every likely stride up to this size
+	// that evenly divides the size and capacity is reported, with the count it
+	// would give. it's up to the caller to pick one, so there's no item count
+	static const size_t MaxStrideCandidate = 0x100;
+
+	inline virtual bool walkStructure(
+		const ScannerTargetShPtr &target,
+		const MemoryAddress &startPointer,
+		const PointerMap &pointerMap,
+		DataStructureDetails& details) const
+	{
+		// this is the slow path, which has to read every triple that might
+		// start with the pointer. findMatches() doesn't use it.
+		auto located = pointerMap.find(startPointer);
+		if (located == pointerMap.end())
+			return false;
+
+		for (auto ref = located->second.cbegin(); ref != located->second.cend(); ref++)
+		{
+			MemoryAddress triple[3];
+			auto triplePointer = &triple[0];
+			if (!target->readArray<MemoryAddress>(*ref, 3, triplePointer))
+				continue;
+			if (pointerMap.find(triple[1]) == pointerMap.end() || pointerMap.find(triple[2]) == pointerMap.end())
+				continue;
+
+			MemoryInformation region;
+			if (this->isValidTriple(target, triple[0], triple[1], triple[2]) &&
+				this->queryRegion(target, triple[0], region) &&
+				this->describeVector(*ref, triple[0], triple[1], triple[2], region, target->getPointerSize(), details))
+				return true;
+		}
+		return false;
+	}
+
+	virtual inline void findMatches(
+		const ScannerTargetShPtr &target,
+		const PointerMap &pointerMap,
+		DataStructureResultMap& results)
+	{
+		// A vector is a triple which looks like:
+		//     <pointer to first element>
+		//     <pointer past last element>
+		//     <pointer past end of storage>
+		// Every part of the triple is a pointer that the pointer locator already
+		// found, so if we sort every pointer by where it lives we can find all of the
+		// triples in a single pass, without reading anything from the target.
+		PointerLocationIndex index;
+		DataStructureBlueprint::buildLocationIndex(pointerMap, index);
+
+		std::vector<VectorCandidate> candidates;
+		for (size_t i = 2; i < index.size(); i++)
+		{
+			auto &first = index[i - 2];
+			auto &last = index[i - 1];
+			auto &end = index[i];
+			if (last.first != target->incrementAddress(first.first, 1) ||
+				end.first != target->incrementAddress(first.first, 2))
+				continue;
+			if (!this->isValidTriple(target, first.second, last.second, end.second))
+				continue;
+
+			VectorCandidate candidate;
+			candidate.location = first.first;
+			candidate.first = first.second;
+			candidate.last = last.second;
+			candidate.end = end.second;
+			candidates.push_back(candidate);
+		}
+
+		// The last check needs to know the region that the storage lives in.
+		// Sorting on the storage lets neighbouring candidates share a query.
+		std::sort(candidates.begin(), candidates.end(),
+			[](const VectorCandidate &a, const VectorCandidate &b) -> bool { return a.first < b.first; }
+		);
+
+		bool hasRegion = false;
+		MemoryInformation region;
+		auto &found = results[this->getTypeName()];
+		for (auto candidate = candidates.cbegin(); candidate != candidates.cend(); candidate++)
+		{
+			if (!hasRegion || candidate->first < region.allocationBase || candidate->first >= region.allocationEnd)
+				hasRegion = this->queryRegion(target, candidate->first, region);
+			if (!hasRegion)
+				continue;
+
+			DataStructureDetails details;
+			if (this->describeVector(candidate->location, candidate->first, candidate->last, candidate->end, region, target->getPointerSize(), details))
+				found[details.identifier] = details;
+		}
+	}
+
+	virtual std::string getTypeName() const
+	{
+		return StdVectorBlueprint::Key;
+	}
+
+private:
+	struct VectorCandidate
+	{
+		MemoryAddress location, first, last, end;
+	};
+
+	inline bool isValidTriple(
+		const ScannerTargetShPtr &target,
+		const MemoryAddress &first,
+		const MemoryAddress &last,
+		const MemoryAddress &end) const
+	{
+		// heap allocations are aligned to two pointers, and
+		// we don't waste time on empty vectors
+		auto allocationAlignment = target->getPointerSize() * 2;
+		if (((size_t)first % allocationAlignment) != 0)
+			return false;
+		return (first < last && last <= end);
+	}
+
+	inline bool queryRegion(
+		const ScannerTargetShPtr &target,
+		const MemoryAddress &address,
+		MemoryInformation &region) const
+	{
+		MemoryAddress next;
+		if (!target->queryMemory(address, region, next))
+			return false;
+		return (address >= region.allocationBase && address < region.allocationEnd);
+	}
+
+	inline bool describeVector(
+		const MemoryAddress &location,
+		const MemoryAddress &first,
+		const MemoryAddress &last,
+		const MemoryAddress &end,
+		const MemoryInformation &region,
+		const size_t &pointerSize,
+		DataStructureDetails& details) const
+	{
+		// the triple has to describe a single allocation, so the storage
+		// needs to be entirely within the region of the first element
+		if (end > region.allocationEnd)
+			return false;
+
+		auto size = (size_t)last - (size_t)first;
+		auto capacity = (size_t)end - (size_t)first;
+
+		// the stride has to evenly divide both size and capacity. elements smaller
+		// than a pointer are almost always a power of two wide, and anything bigger
+		// almost always gets padded out to a multiple of the pointer size
+		std::vector<ScanVariant> strides;
+		for (size_t stride = 1; stride <= MaxStrideCandidate && stride <= size; )
+		{
+			if ((size % stride) == 0 && (capacity % stride) == 0)
+			{
+				std::vector<ScanVariant> strideAndCount;
+				strideAndCount.push_back(ScanVariant::FromNumber(stride));
+				strideAndCount.push_back(ScanVariant::FromNumber(size / stride));
+				strides.push_back(ScanVariant::FromStruct(strideAndCount));
+			}
+			stride = (stride < pointerSize) ? (stride * 2) : (stride + pointerSize);
+		}
+
+		details.identifier = location;
+		details.members.insert(std::make_pair(SizeInBytesTag, ScanVariant::FromNumber(size)));
+		details.members.insert(std::make_pair(CapacityInBytesTag, ScanVariant::FromNumber(capacity)));
+		details.members.insert(std::make_pair(StrideCandidatesTag, ScanVariant::FromStruct(strides)));
+		return true;
+	}
+};
\ No newline at end of file
@@ -16,25 +16,51 @@ ThreadPool::ThreadPool(float portion)
 	this->internalInit(threads);
 }
 
+ThreadPool::ThreadPool(const size_t &threadCount)
+{
+	auto maxThreads = (size_t)ThreadPool::getMaxThreadCount();
+	this->internalInit((int)std::min(maxThreads, std::max((size_t)1, threadCount)));
+}
+
+ThreadPool::ThreadPool(const std::vector<uint32_t> &cpus)
+{
+	ASSERT(!cpus.empty());
+	this->internalInit((int)cpus.size(), cpus);
+}
+
 ThreadPool::ThreadPool()
 {
 	this->internalInit(ThreadPool::getMaxThreadCount());
 }
 
-void ThreadPool::internalInit(int threadCount)
+void ThreadPool::internalInit(int threadCount, const std::vector<uint32_t> &cpus)
 {
 	ASSERT(threadCount <= ThreadPool::getMaxThreadCount());
 	ASSERT(threadCount >= 1);
 
 	this->shutdown = false;
+	this->activeTasks = 0;
 	for (int i = 0; i < threadCount; i++)
-		this->workers.push_back(std::shared_ptr<ThreadPoolWorker>(new ThreadPoolWorker(this)));
+	{
+		auto cpu = (i < (int)cpus.size()) ? (int64_t)cpus[i] : -1;
+		this->workers.push_back(std::shared_ptr<ThreadPoolWorker>(new ThreadPoolWorker(this, cpu)));
+	}
+}
+
+int64_t ThreadPool::getCurrentWorkerCpu()
+{
+	return ThreadPoolWorker::getCurrentCpu();
 }
 
 ThreadPool::~ThreadPool()
 {
 	this->shutdown = true;
 	this->join();
+	{
+		// workers check for shutdown under the lock, so this makes
+		// sure none of them are about to wait for a task that won't come
+		std::lock_guard<std::mutex> lock(this->mutex);
+	}
 	this->posted.notify_all();
 	this->workers.clear();
 }
@@ -42,13 +68,13 @@ ThreadPool::~ThreadPool()
 void ThreadPool::join(std::optional<JoinCallback> callback)
 {
 	std::unique_lock<std::mutex> lock(this->mutex);
-	while (!this->tasks.empty())
+	while (!this->tasks.empty() || this->activeTasks > 0)
 	{
 		this->posted.notify_all();
 		this->completed.wait(lock);
 		if (callback.has_value())
 		{
-			auto size = this->tasks.size();
+			auto size = this->tasks.size() + this->activeTasks;
 			lock.unlock();
 			callback.value()(size);
 			lock.lock();
@@ -68,9 +94,14 @@ void ThreadPool::execute(Action action)
 	this->posted.notify_one();
 }
 
-void ThreadPool::notifyWorkComplete()
+void ThreadPool::notifyWorkComplete(const bool &ranTask)
 {
-	this->completed.notify_one();
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		if (ranTask)
+			this->activeTasks--;
+	}
+	this->completed.notify_all();
 }
 
 std::optional<ThreadPool::Action> ThreadPool::getWork(bool &_shutdown)
@@ -91,5 +122,6 @@ std::optional<ThreadPool::Action> ThreadPool::getWork(bool &_shutdown)
 	_shutdown = false;
 	auto ret = this->tasks.front();
 	this->tasks.pop();
+	this->activeTasks++;
 	return ret;
 }
\ No newline at end of file
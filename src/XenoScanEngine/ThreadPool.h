@@ -1,5 +1,6 @@
 #pragma once
 
+#include <stdint.h>
 #include <queue>
 #include <vector>
 #include <thread>
@@ -14,9 +15,13 @@ public:
 	typedef std::function<void(size_t)> JoinCallback;
 
 	ThreadPool(float portion);
+	explicit ThreadPool(const size_t &threadCount);
+	// one worker for each of cpus, pinned to it. see CpuTopology
+	explicit ThreadPool(const std::vector<uint32_t> &cpus);
 	ThreadPool();
 	~ThreadPool();
 
+	// waits until every posted task has finished running
 	void join(std::optional<JoinCallback> callback = std::nullopt);
 	void execute(Action action);
 	size_t getNumberOfWorkers()
@@ -29,18 +34,23 @@ public:
 		return std::thread::hardware_concurrency();
 	}
 
+	// the CPU that the calling worker is pinned to, or -1 if it isn't one of
+	// the workers of a pinned pool (or pinning didn't work)
+	static int64_t getCurrentWorkerCpu();
+
 protected:
 	friend class ThreadPoolWorker;
 
-	void notifyWorkComplete();
+	void notifyWorkComplete(const bool &ranTask);
 	std::optional<Action> getWork(bool &shutdown);
 
 private:
 	std::mutex mutex;
 	std::queue<Action> tasks;
+	size_t activeTasks; // taken off of the queue, but not done yet
 	std::atomic<bool> shutdown;
 	std::condition_variable posted, completed;
 	std::vector<std::shared_ptr<ThreadPoolWorker>> workers;
 
-	void internalInit(int threadCount);
+	void internalInit(int threadCount, const std::vector<uint32_t> &cpus = std::vector<uint32_t>());
 };
\ No newline at end of file
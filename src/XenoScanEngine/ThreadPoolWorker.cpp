@@ -1,19 +1,29 @@
 #include "ThreadPoolWorker.h"
 #include "ThreadPool.h"
+#include "Trace.h"
+#include "CpuTopology.h"
 
 
-ThreadPoolWorker::ThreadPoolWorker(ThreadPool* executor)
+static thread_local int64_t currentCpu = -1;
+
+ThreadPoolWorker::ThreadPoolWorker(ThreadPool* executor, const int64_t &cpu)
 	: parentExecutor(executor)
 {
-	this->thread = std::thread([this]() -> void
+	this->thread = std::thread([this, cpu]() -> void
 	{
+		if (cpu >= 0 && CpuTopology::pinCurrentThread((uint32_t)cpu))
+			currentCpu = cpu;
+
 		bool shutdown = false;
 		while (!shutdown)
 		{
 			auto task = this->parentExecutor->getWork(shutdown);
 			if (task.has_value())
+			{
+				Trace::Scope scope("pool", "task");
 				task.value()();
-			this->parentExecutor->notifyWorkComplete();
+			}
+			this->parentExecutor->notifyWorkComplete(task.has_value());
 		}
 	});
 }
@@ -22,4 +32,9 @@ ThreadPoolWorker::~ThreadPoolWorker()
 {
 	this->thread.join();
 	this->parentExecutor = nullptr;
+}
+
+int64_t ThreadPoolWorker::getCurrentCpu()
+{
+	return currentCpu;
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <stdint.h>
 #include <thread>
 
 class ThreadPoolWorker
@@ -14,7 +15,10 @@ public:
 protected:
 	friend class ThreadPool;
 
-	ThreadPoolWorker(ThreadPool* executor);
+	// workers given a cpu pin themselves to it before they take any work
+	ThreadPoolWorker(ThreadPool* executor, const int64_t &cpu = -1);
+
+	static int64_t getCurrentCpu();
 
 private:
 	std::thread thread;
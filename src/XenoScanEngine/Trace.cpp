@@ -0,0 +1,153 @@
+#include "Trace.h"
+
+#include <mutex>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <fstream>
+#include <iomanip>
+
+
+struct TraceEvent
+{
+	const char* category;
+	const char* name;
+	uint64_t start, duration;
+	MemoryAddress address;
+	size_t size;
+	bool hasRange;
+};
+
+struct TraceBuffer
+{
+	uint32_t thread;
+	uint64_t session;
+	size_t recorded; // events wrap around once this passes events.size()
+	std::vector<TraceEvent> events;
+};
+
+std::atomic<bool> Trace::enabled(false);
+
+// buffers are only added (and thrown away by start()) under the lock. each thread
+// keeps hold of its own, and makes a new one when it sees that the session changed
+static std::mutex traceMutex;
+static std::vector<std::shared_ptr<TraceBuffer>> traceBuffers;
+static std::atomic<uint64_t> traceSession(0);
+static size_t traceEventsPerThread = Trace::DefaultEventsPerThread;
+static uint64_t traceStart = 0;
+static thread_local std::shared_ptr<TraceBuffer> traceLocalBuffer;
+
+
+void Trace::start(const size_t &eventsPerThread)
+{
+	std::lock_guard<std::mutex> lock(traceMutex);
+	traceBuffers.clear();
+	traceEventsPerThread = eventsPerThread ? eventsPerThread : 1;
+	traceStart = Trace::now();
+	traceSession++;
+	Trace::enabled = true;
+}
+
+void Trace::stop()
+{
+	Trace::enabled = false;
+}
+
+uint64_t Trace::now()
+{
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Trace::record(const char* category, const char* name, const uint64_t &start, const MemoryAddress &address, const size_t &size, const bool &hasRange)
+{
+	auto end = Trace::now();
+	auto buffer = traceLocalBuffer.get();
+	if (!buffer || buffer->session != traceSession.load())
+	{
+		std::lock_guard<std::mutex> lock(traceMutex);
+		if (!Trace::isEnabled() || start < traceStart)
+			return;
+
+		traceLocalBuffer.reset(new TraceBuffer());
+		buffer = traceLocalBuffer.get();
+		buffer->thread = (uint32_t)traceBuffers.size() + 1;
+		buffer->session = traceSession.load();
+		buffer->recorded = 0;
+		buffer->events.resize(traceEventsPerThread);
+		traceBuffers.push_back(traceLocalBuffer);
+	}
+
+	auto &event = buffer->events[buffer->recorded % buffer->events.size()];
+	event.category = category;
+	event.name = name;
+	event.start = start;
+	event.duration = end - start;
+	event.address = address;
+	event.size = size;
+	event.hasRange = hasRange;
+	buffer->recorded++;
+}
+
+bool Trace::write(const std::string &path)
+{
+	std::ofstream file(path, std::ios::trunc);
+	if (!file.is_open())
+		return false;
+
+	std::lock_guard<std::mutex> lock(traceMutex);
+
+	// times are in microseconds, from when the trace was started
+	file << std::fixed << std::setprecision(3);
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	bool first = true;
+	for (auto buffer = traceBuffers.cbegin(); buffer != traceBuffers.cend(); buffer++)
+	{
+		auto thread = (*buffer)->thread;
+		auto capacity = (*buffer)->events.size();
+		auto recorded = (*buffer)->recorded;
+		auto dropped = (recorded > capacity) ? recorded - capacity : 0;
+
+		if (!first)
+			file << ",";
+		first = false;
+		file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread
+			<< ",\"args\":{\"name\":\"thread " << thread;
+		if (dropped)
+			file << " (" << dropped << " oldest events dropped)";
+		file << "\"}}";
+
+		for (auto i = dropped; i < recorded; i++)
+		{
+			auto &event = (*buffer)->events[i % capacity];
+			file << ",{\"name\":\"" << event.name << "\",\"cat\":\"" << event.category << "\",\"ph\":\"X\""
+				<< ",\"pid\":1,\"tid\":" << thread
+				<< ",\"ts\":" << ((double)(event.start - traceStart) / 1000.0)
+				<< ",\"dur\":" << ((double)event.duration / 1000.0);
+			if (event.hasRange)
+				file << ",\"args\":{\"address\":\"0x" << std::hex << (size_t)event.address << std::dec << "\",\"size\":" << event.size << "}";
+			file << "}";
+		}
+	}
+	file << "]}";
+	return file.good();
+}
+
+
+Trace::Scope::Scope(const char* category, const char* name) :
+	category(category), name(name), address(0), size(0), hasRange(false),
+	start(Trace::isEnabled() ? Trace::now() : 0)
+{
+}
+
+Trace::Scope::Scope(const char* category, const char* name, const MemoryAddress &address, const size_t &size) :
+	category(category), name(name), address(address), size(size), hasRange(true),
+	start(Trace::isEnabled() ? Trace::now() : 0)
+{
+}
+
+Trace::Scope::~Scope()
+{
+	// scopes that were open when tracing started or stopped are left out
+	if (this->start && Trace::isEnabled())
+		Trace::record(this->category, this->name, this->start, this->address, this->size, this->hasRange);
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#include <string>
+
+#include "ScannerTypes.h"
+
+
+// Scoped trace events, which show what every thread was doing over the course
+// of a scan. Each thread records into its own ring buffer (so a long trace keeps
+// its most recent events), and write() saves everything as Chrome trace JSON
+// for chrome://tracing or Perfetto. While tracing is stopped a Scope is just a
+// flag check. Event names and categories must be string literals.
+class Trace
+{
+public:
+	static constexpr size_t DefaultEventsPerThread = 0x10000;
+
+	// starting again throws away everything recorded so far
+	static void start(const size_t &eventsPerThread = DefaultEventsPerThread);
+	static void stop();
+	static inline bool isEnabled() { return Trace::enabled.load(std::memory_order_relaxed); }
+
+	// only call this once the traced work is done; the buffers are read without locks
+	static bool write(const std::string &path);
+
+	class Scope
+	{
+	public:
+		Scope(const char* category, const char* name);
+		Scope(const char* category, const char* name, const MemoryAddress &address, const size_t &size);
+		~Scope();
+
+	private:
+		const char* category;
+		const char* name;
+		MemoryAddress address;
+		size_t size;
+		bool hasRange;
+		uint64_t start;
+	};
+
+private:
+	static std::atomic<bool> enabled;
+
+	static uint64_t now();
+	static void record(const char* category, const char* name, const uint64_t &start, const MemoryAddress &address, const size_t &size, const bool &hasRange);
+};
\ No newline at end of file
@@ -0,0 +1,230 @@
+#include "WatchList.h"
+
+#include <algorithm>
+#include <cstring>
+
+
+WatchList::WatchList(const size_t &capacity) :
+	nextId(1), shutdown(false),
+	ring(capacity ? capacity : 1), head(0), tail(0), dropped(0)
+{
+}
+
+WatchList::~WatchList()
+{
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->shutdown = true;
+	}
+	this->changed.notify_all();
+	if (this->thread.joinable())
+		this->thread.join();
+}
+
+WatchList::WatchId WatchList::add(const ScannerTargetShPtr &target, const MemoryAddress &address, const size_t &size, const uint32_t &intervalMs)
+{
+	ASSERT(target.get());
+	if (!size)
+		return 0;
+
+	Entry entry;
+	entry.target = target;
+	entry.address = address;
+	entry.size = size;
+	entry.interval = std::chrono::milliseconds(intervalMs ? intervalMs : 1);
+
+	// changes are reported from now on, even if they happen before the first sample
+	entry.last.resize(size);
+	auto last = &entry.last[0];
+	entry.hasLast = target->readArray<uint8_t>(address, size, last);
+
+	// like freezes, samples are lined up on multiples of the interval so
+	// that ranges with the same interval are read together
+	auto now = Clock::now();
+	entry.due = now + entry.interval - (now.time_since_epoch() % entry.interval);
+
+	WatchId id;
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		id = this->nextId++;
+		this->entries[id] = entry;
+
+		if (!this->thread.joinable())
+			this->thread = std::thread(&WatchList::run, this);
+	}
+	this->changed.notify_all();
+	return id;
+}
+
+bool WatchList::remove(const WatchId &id)
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->entries.erase(id) != 0;
+}
+
+void WatchList::clear()
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	this->entries.clear();
+}
+
+size_t WatchList::size() const
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->entries.size();
+}
+
+bool WatchList::pop(Change &change)
+{
+	auto head = this->head.load(std::memory_order_relaxed);
+	if (head == this->tail.load(std::memory_order_acquire))
+		return false;
+
+	// swapping leaves our old buffers in the slot, for the thread to reuse
+	std::swap(change, this->ring[head % this->ring.size()]);
+	this->head.store(head + 1, std::memory_order_release);
+	return true;
+}
+
+void WatchList::push(Change &change)
+{
+	auto tail = this->tail.load(std::memory_order_relaxed);
+	if (tail - this->head.load(std::memory_order_acquire) >= this->ring.size())
+	{
+		this->dropped++;
+		return;
+	}
+
+	std::swap(change, this->ring[tail % this->ring.size()]);
+	this->tail.store(tail + 1, std::memory_order_release);
+}
+
+void WatchList::run()
+{
+	std::unique_lock<std::mutex> lock(this->mutex);
+	while (!this->shutdown)
+	{
+		if (this->entries.empty())
+		{
+			this->changed.wait(lock);
+			continue;
+		}
+
+		auto now = Clock::now();
+		auto next = Clock::time_point::max();
+		for (auto entry = this->entries.cbegin(); entry != this->entries.cend(); entry++)
+			next = std::min(next, entry->second.due);
+		if (next > now)
+		{
+			this->changed.wait_until(lock, next);
+			continue;
+		}
+
+		std::vector<Sample> due;
+		for (auto entry = this->entries.begin(); entry != this->entries.end(); entry++)
+		{
+			auto &watched = entry->second;
+			if (watched.due > now)
+				continue;
+
+			Sample sample = { entry->first, watched.target, watched.address, watched.size, watched.last, watched.hasLast };
+			due.push_back(sample);
+			watched.due = now + watched.interval - (now.time_since_epoch() % watched.interval);
+		}
+
+		// the reads happen without the lock, so a slow target can't hold up add() and
+		// remove(). whatever was removed in the meantime just doesn't get its sample
+		lock.unlock();
+		this->sample(due);
+		lock.lock();
+
+		for (auto sampled = due.begin(); sampled != due.end(); sampled++)
+		{
+			auto entry = this->entries.find(sampled->id);
+			if (entry == this->entries.end())
+				continue;
+			entry->second.last.swap(sampled->last);
+			entry->second.hasLast = sampled->hasLast;
+		}
+	}
+}
+
+void WatchList::sample(std::vector<Sample> &due)
+{
+	std::sort(due.begin(), due.end(),
+		[](const Sample &a, const Sample &b) -> bool
+		{
+			if (a.target.get() != b.target.get())
+				return a.target.get() < b.target.get();
+			return (size_t)a.address < (size_t)b.address;
+		}
+	);
+
+	Change change;
+	for (size_t first = 0; first < due.size(); )
+	{
+		// everything for one target
+		auto target = due[first].target;
+		size_t last = first;
+		while (last < due.size() && due[last].target == target)
+			last++;
+
+		// work out which ranges are read together
+		MemoryBufferCollection reads;
+		std::vector<size_t> readOf(last - first);
+		for (size_t i = first; i < last; i++)
+		{
+			auto start = (size_t)due[i].address;
+			auto end = start + due[i].size;
+			if (!reads.empty())
+			{
+				auto &read = reads.back();
+				auto readStart = (size_t)read.address;
+				auto readEnd = readStart + read.data.size();
+				if (start <= readEnd + ReadGap && (start / PageSize) == ((readEnd - 1) / PageSize))
+				{
+					if (end > readEnd)
+						read.data.resize(end - readStart);
+					readOf[i - first] = reads.size() - 1;
+					continue;
+				}
+			}
+
+			MemoryBuffer read;
+			read.address = (MemoryAddress)start;
+			read.data.resize(end - start);
+			reads.push_back(read);
+			readOf[i - first] = reads.size() - 1;
+		}
+
+		target->readBatch(reads);
+
+		// then compare each range to what it was last time
+		for (size_t i = first; i < last; i++)
+		{
+			auto &watched = due[i];
+			auto &read = reads[readOf[i - first]];
+			if (read.data.empty())
+				continue;
+
+			auto current = &read.data[(size_t)watched.address - (size_t)read.address];
+			if (!watched.hasLast)
+			{
+				watched.last.assign(current, current + watched.size);
+				watched.hasLast = true;
+				continue;
+			}
+			if (memcmp(&watched.last[0], current, watched.size) == 0)
+				continue;
+
+			change.id = watched.id;
+			change.address = watched.address;
+			change.before.assign(watched.last.begin(), watched.last.end());
+			change.after.assign(current, current + watched.size);
+			watched.last.assign(current, current + watched.size);
+			this->push(change);
+		}
+
+		first = last;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,91 @@
+#pragma once
+#include <stdint.h>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+
+#include "Assert.h"
+#include "ScannerTypes.h"
+#include "ScannerTarget.h"
+
+
+// Ranges of memory which are sampled every so often by a background thread, so
+// that changes to them can be reported. Everything due at the same time is read
+// as one batch, with ranges that are close to each other read together. Changes
+// go into a ring buffer which one other thread (the one that's reporting them)
+// drains with pop(); if it falls too far behind, changes are dropped.
+class WatchList
+{
+public:
+	typedef uint32_t WatchId;
+	struct Change
+	{
+		WatchId id;
+		MemoryAddress address;
+		std::vector<uint8_t> before, after;
+	};
+
+	WatchList(const size_t &capacity = DefaultCapacity);
+	~WatchList();
+
+	// returns 0 if the range is empty
+	WatchId add(const ScannerTargetShPtr &target, const MemoryAddress &address, const size_t &size, const uint32_t &intervalMs);
+	bool remove(const WatchId &id);
+	void clear();
+
+	size_t size() const;
+
+	// takes the oldest change, if there is one. changes to ranges that have
+	// since been removed can still come out of here
+	bool pop(Change &change);
+	inline size_t getDroppedCount() const { return this->dropped.load(); }
+
+private:
+	typedef std::chrono::steady_clock Clock;
+	static constexpr size_t DefaultCapacity = 4096;
+
+	// ranges this close together are read as one, as long as they share a page
+	static constexpr size_t ReadGap = 64;
+	static constexpr size_t PageSize = 0x1000;
+
+	struct Entry
+	{
+		ScannerTargetShPtr target;
+		MemoryAddress address;
+		size_t size;
+		std::chrono::milliseconds interval;
+		Clock::time_point due;
+		std::vector<uint8_t> last;
+		bool hasLast;
+	};
+
+	// what gets sampled, copied out of an entry so it can be read without the lock
+	struct Sample
+	{
+		WatchId id;
+		ScannerTargetShPtr target;
+		MemoryAddress address;
+		size_t size;
+		std::vector<uint8_t> last;
+		bool hasLast;
+	};
+
+	mutable std::mutex mutex;
+	std::condition_variable changed;
+	std::map<WatchId, Entry> entries;
+	WatchId nextId;
+
+	std::thread thread;
+	bool shutdown;
+
+	// single producer (the thread), single consumer (pop())
+	std::vector<Change> ring;
+	std::atomic<size_t> head, tail, dropped;
+
+	void run();
+	void sample(std::vector<Sample> &due);
+	void push(Change &change);
+};
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "LuaEngine.h"
 
-LuaEngine::LuaEngine(void)
+LuaEngine::LuaEngine(void) :
+	thinking(false)
 {
 	for (auto exp = __luaEngineExports.begin(); exp != __luaEngineExports.end(); exp++)
 		this->pushGlobal(exp->first, exp->second());
@@ -10,6 +11,10 @@ LuaEngine::~LuaEngine(void) {}
 
 void LuaEngine::doThink()
 {
+	if (this->thinking)
+		return;
+	this->thinking = true;
+
 	auto currentTime = std::chrono::high_resolution_clock::now();
 	std::vector<LuaVariant> args;
 	for (auto evt = this->timedEvents.begin(); evt != this->timedEvents.end(); )
@@ -25,6 +30,46 @@ void LuaEngine::doThink()
 		else
 			evt++;
 	}
+
+	// report changes to watched memory. callbacks can unwatch things or destroy
+	// scanners, so we work from a copy of the list and look each watch up as we go
+	auto scanners = this->scanners;
+	WatchList::Change change;
+	for (auto scanner = scanners.cbegin(); scanner != scanners.cend(); scanner++)
+	{
+		while ((*scanner)->scanner->takeWatchChange(change))
+		{
+			auto watch = (*scanner)->watches.find(change.id);
+			if (watch == (*scanner)->watches.end())
+				continue; // unwatched since it changed
+
+			auto callback = watch->second;
+			args.clear();
+			args.push_back(LuaVariant(change.address));
+			args.push_back(this->createLuaWatchValue(**scanner, callback, change.after));
+			args.push_back(this->createLuaWatchValue(**scanner, callback, change.before));
+
+			// a failing callback has its error displayed, and stays watched
+			this->executeFunction(callback.function, args, 0, callback.function);
+		}
+	}
+
+	this->thinking = false;
+}
+
+LuaVariant LuaEngine::createLuaWatchValue(const ScannerPair& scanner, const WatchCallback& watch, const std::vector<uint8_t>& bytes) const
+{
+	if (watch.type == ScanVariant::SCAN_VARIANT_NULL)
+	{
+		LuaVariant::LuaVariantITable values;
+		for (auto byte = bytes.cbegin(); byte != bytes.cend(); byte++)
+			values.push_back(LuaVariant((LuaVariant::LuaVariantInt)*byte));
+		return values;
+	}
+
+	auto reference = ScanVariant::FromNumberTyped(0, watch.type);
+	auto value = ScanVariant::FromRawBuffer(&bytes[0], bytes.size(), scanner.target->isLittleEndian(), reference);
+	return this->getLuaVariantFromScanVariant(value);
 }
 
 LuaVariant LuaEngine::createLuaMemoryInformation(const MemoryInformation& meminfo) const
@@ -45,6 +90,109 @@ LuaVariant LuaEngine::createLuaMemoryInformation(const MemoryInformation& meminf
 	return info;
 }
 
+bool LuaEngine::getBlockFilterFromLuaTable(const LuaVariant::LuaVariantKTable& table, BlockFilter& filter, std::string& error) const
+{
+	// flags are true if required, false if excluded, and nil if we don't care
+	auto getFlag = [&table, &error](const std::string& name, BlockFilter::FlagRule& rule) -> bool
+	{
+		auto it = table.find(name);
+		if (it == table.end()) return true;
+
+		bool value;
+		if (!it->second.getAsBool(value))
+		{
+			error = "Expected boolean value for '" + name + "' field!";
+			return false;
+		}
+		rule = value ? BlockFilter::FLAG_RULE_REQUIRED : BlockFilter::FLAG_RULE_EXCLUDED;
+		return true;
+	};
+	auto getSize = [&table, &error](const std::string& name, size_t& size) -> bool
+	{
+		auto it = table.find(name);
+		if (it == table.end()) return true;
+
+		uint64_t value;
+		if (!it->second.getAsInt(value))
+		{
+			error = "Expected number value for '" + name + "' field!";
+			return false;
+		}
+		size = static_cast<size_t>(value);
+		return true;
+	};
+	auto getGlobs = [&table, &error](const std::string& name, std::vector<std::string>& globs) -> bool
+	{
+		auto it = table.find(name);
+		if (it == table.end()) return true;
+
+		LuaVariant::LuaVariantITable list;
+		if (!it->second.getAsITable(list))
+		{
+			error = "Expected array of strings for '" + name + "' field!";
+			return false;
+		}
+		for (auto entry = list.cbegin(); entry != list.cend(); entry++)
+		{
+			LuaVariant::LuaVariantString glob;
+			if (!entry->getAsString(glob))
+			{
+				error = "Expected array of strings for '" + name + "' field!";
+				return false;
+			}
+			globs.push_back(glob);
+		}
+		return true;
+	};
+	auto getRanges = [&table, &error](const std::string& name, MemoryAddressBounds& ranges) -> bool
+	{
+		auto it = table.find(name);
+		if (it == table.end()) return true;
+
+		// each range is a {start, end} pair of addresses
+		LuaVariant::LuaVariantITable list;
+		if (!it->second.getAsITable(list))
+		{
+			error = "Expected array of {start, end} pairs for '" + name + "' field!";
+			return false;
+		}
+		for (auto entry = list.cbegin(); entry != list.cend(); entry++)
+		{
+			LuaVariant::LuaVariantITable pair;
+			if (!entry->getAsITable(pair) || pair.size() != 2)
+			{
+				error = "Expected array of {start, end} pairs for '" + name + "' field!";
+				return false;
+			}
+
+			pair[0].coerceToPointer();
+			pair[1].coerceToPointer();
+
+			MemoryAddress start, end;
+			if (!pair[0].getAsPointer(start) || !pair[1].getAsPointer(end) || end < start)
+			{
+				error = "Expected array of {start, end} pairs for '" + name + "' field!";
+				return false;
+			}
+			ranges.insert(start, end);
+		}
+		return true;
+	};
+
+	return
+		getFlag("writeable", filter.writeable) &&
+		getFlag("executable", filter.executable) &&
+		getFlag("mapped", filter.mapped) &&
+		getFlag("mappedImage", filter.mappedImage) &&
+		getFlag("module", filter.module) &&
+		getSize("minSize", filter.minimumSize) &&
+		getSize("maxSize", filter.maximumSize) &&
+		getGlobs("modules", filter.includeModules) &&
+		getGlobs("excludeModules", filter.excludeModules) &&
+		getRanges("ranges", filter.includeRanges) &&
+		getRanges("excludeRanges", filter.excludeRanges);
+}
+
 LuaVariant LuaEngine::createLuaObject(const std::string& typeName, const void* pointer) const
 {
 	LuaVariant::LuaVariantKTable target;
@@ -201,7 +349,7 @@ LuaVariant LuaEngine::getLuaVariantFromScanVariant(const ScanVariant &variant) c
 			complex.push_back(this->getLuaVariantFromScanVariant(*v));
 		return complex;
 	}
-	else if (traits->isStringType())
+	else if (traits->isStringType() || variant.isPattern())
 	{
 		return LuaVariant(variant.toString());
 	}
@@ -1,6 +1,7 @@
 #pragma once
 #include <vector>
 #include <list>
+#include <map>
 #include <iostream>
 #include <chrono>
 #include <list>
@@ -36,19 +37,42 @@ public:
 
 	/* EXPORTED FUNCTIONS */
 	int settimeout();
+	int think();
 	int ptrcast();
 
 	int attach();
+	int attachFile();
 	int destroy();
 
 	int readMemory();
 	int writeMemory();
+	int freezeMemory();
+	int unfreezeMemory();
+	int watchMemory();
+	int unwatchMemory();
 
 	int setBlockChecker();
+	int setBlockFilter();
+	int captureSnapshot();
+	int diffSnapshots();
 	int newScan();
 	int runScan();
 	int getScanResultsSize();
 	int getScanResults();
+	int undoScan();
+	int getScanGeneration();
+	int setScanGeneration();
+	int setScanMetricsEnabled();
+	int getScanMetrics();
+	int getUnreadableRanges();
+	int setConsistentScan();
+	int setScanPipeline();
+	int setThreadPinning();
+	int setConsoleProgress();
+	int setPatternScanExecutableOnly();
+	int setResultSpillThreshold();
+	int startTrace();
+	int stopTrace();
 	int getDataStructures();
 
 protected:
@@ -59,11 +83,20 @@ protected:
 	}
 
 private:
+	// watched memory with a numeric type is reported as a number; anything else
+	// (type is SCAN_VARIANT_NULL) is reported as an array of bytes
+	struct WatchCallback
+	{
+		LuaVariant function;
+		ScanVariant::ScanVariantType type;
+	};
+
 	struct ScannerPair // TODO: fix naming for this
 	{
 		ScannerTargetShPtr target;
 		ScannerShPtr scanner;
 		LuaVariant blockChecker;
+		std::map<WatchList::WatchId, WatchCallback> watches;
 	};
 	typedef std::shared_ptr<ScannerPair> ScannerPairShPtr;
 	typedef std::list<ScannerPairShPtr> ScannerPairList;
@@ -75,8 +108,11 @@ private:
 		std::chrono::time_point<std::chrono::steady_clock> executeTime;
 	};
 	std::list<TimedEvent> timedEvents;
+	bool thinking; // doThink() can't run again from inside of one of its callbacks
 
 	LuaVariant createLuaMemoryInformation(const MemoryInformation& meminfo) const;
+	LuaVariant createLuaWatchValue(const ScannerPair& scanner, const WatchCallback& watch, const std::vector<uint8_t>& bytes) const;
+	bool getBlockFilterFromLuaTable(const LuaVariant::LuaVariantKTable& table, BlockFilter& filter, std::string& error) const;
 
 	LuaVariant createLuaObject(const std::string& typeName, const void* pointer) const;
 	bool getLuaObject(const LuaVariant& object, const std::string& typeName, void* &pointer) const;
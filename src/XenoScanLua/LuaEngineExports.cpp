@@ -4,6 +4,7 @@
 #include "XenoScanEngine/ScannerTarget.h"
 #include "XenoScanEngine/ScanVariant.h"
 #include "XenoScanEngine/Scanner.h"
+#include "XenoScanEngine/Trace.h"
 
 std::vector<std::pair<const std::string, const std::function<const LuaVariant()>>> __luaEngineExports;
 
@@ -37,6 +38,7 @@ LUAENGINE_EXPORT_VALUE(int32_t, SCAN_VARIANT_FLOAT,                      ScanVar
 LUAENGINE_EXPORT_VALUE(int32_t, SCAN_VARIANT_FILETIME64,                 ScanVariant::SCAN_VARIANT_FILETIME64);
 LUAENGINE_EXPORT_VALUE(int32_t, SCAN_VARIANT_TICKTIME32,                 ScanVariant::SCAN_VARIANT_TICKTIME32);
 LUAENGINE_EXPORT_VALUE(int32_t, SCAN_VARIANT_STRUCTURE,                  ScanVariant::SCAN_VARIANT_STRUCTURE);
+LUAENGINE_EXPORT_VALUE(int32_t, SCAN_VARIANT_PATTERN,                    ScanVariant::SCAN_VARIANT_PATTERN);
 
 // target keys
 LUAENGINE_EXPORT_FACTORY_KEYS(ScannerTarget::FACTORY_TYPE, ScannerTarget::Factory, ATTACH_TARGET_NAMES);
@@ -60,6 +62,17 @@ int LuaEngine::settimeout()
 	return this->luaRet(true);
 }
 
+LUAENGINE_EXPORT_FUNCTION(think, "doThink"); // doThink()
+int LuaEngine::think()
+{
+	// lets scripts that don't return to the console (like the tests) run their
+	// timeouts and watch callbacks
+	this->getArguments();
+	if (this->thinking) return this->luaRet(false, "doThink() can't be called from a timeout or watch callback!");
+	this->doThink();
+	return this->luaRet(true);
+}
+
 LUAENGINE_EXPORT_FUNCTION(ptrcast, "ptrcast"); // ptrcast(int)
 int LuaEngine::ptrcast()
 {
@@ -101,6 +114,35 @@ int LuaEngine::attach()
 	return this->luaRet(obj);
 }
 
+LUAENGINE_EXPORT_FUNCTION(attachFile, "attachFile"); // attachFile(type, path)
+int LuaEngine::attachFile()
+{
+	auto args = this->getArguments<LUA_VARIANT_STRING, LUA_VARIANT_STRING>();
+
+	std::string targetType;
+	args[0].getAsString(targetType);
+	std::string path;
+	args[1].getAsString(path);
+
+	// create the target
+	auto target = ScannerTarget::Factory.createInstance(targetType);
+	if (!target)
+		return this->luaRet();
+
+	// attach to the file
+	auto scannerPair = std::make_shared<ScannerPair>();
+	scannerPair->target = target;
+	if (!scannerPair->target->attachFile(path))
+		return this->luaRet();
+
+	// if attach succeeded, create a scanner and push lua object
+	scannerPair->scanner = std::make_shared<Scanner>();
+	this->scanners.push_back(scannerPair);
+
+	auto obj = this->createLuaObject("ScannerPair", scannerPair.get());
+	return this->luaRet(obj);
+}
+
 LUAENGINE_EXPORT_FUNCTION(destroy, "destroy"); // destroy(scanner)
 int LuaEngine::destroy()
 {
@@ -167,6 +209,121 @@ int LuaEngine::writeMemory()
 	return this->luaRet(writeVariant.writeToTarget(scanner->target, address));
 }
 
+LUAENGINE_EXPORT_FUNCTION(freezeMemory, "freezeMemory"); // freezeMemory(scanner, address, offset, value, type, interval)
+int LuaEngine::freezeMemory()
+{
+	auto args = this->getArguments<LUA_VARIANT_KTABLE, LUA_VARIANT_POINTER, LUA_VARIANT_INT, LUA_VARIANT_STRING, LUA_VARIANT_INT, LUA_VARIANT_INT>();
+	auto scanner = this->getArgAsScannerObject(args);
+	if (!scanner.get()) return this->luaRet(false);
+	if (!scanner->target->isAttached()) return this->luaRet(false);
+
+	MemoryAddress address;
+	args[1].getAsPointer(address);
+
+	LuaVariant::LuaVariantInt offset;
+	args[2].getAsInt(offset);
+
+	ScanVariant::ScanVariantType memberType;
+	args[4].getAsInt(memberType);
+
+	LuaVariant::LuaVariantInt interval;
+	args[5].getAsInt(interval);
+	if (interval <= 0)
+		return this->luaRet(false, "Freeze interval must be greater than zero!");
+
+	auto freezeVariant = this->getScanVariantFromLuaVariant(args[3], memberType, false);
+	if (freezeVariant.isNull())
+		return this->luaRet(false);
+
+	address = (MemoryAddress)((size_t)address + offset); // TODO need to clean this up when MemoryAddress operators are added
+	auto id = scanner->scanner->freezeValue(scanner->target, address, freezeVariant, (uint32_t)interval);
+	if (!id)
+		return this->luaRet(false, "Value can't be frozen!");
+	return this->luaRet((LuaVariant::LuaVariantInt)id);
+}
+
+LUAENGINE_EXPORT_FUNCTION(unfreezeMemory, "unfreezeMemory"); // unfreezeMemory(scanner, id), where an id of 0 unfreezes everything
+int LuaEngine::unfreezeMemory()
+{
+	auto args = this->getArguments<LUA_VARIANT_KTABLE, LUA_VARIANT_INT>();
+	auto scanner = this->getArgAsScannerObject(args);
+	if (!scanner.get()) return this->luaRet(false);
+
+	LuaVariant::LuaVariantInt id;
+	args[1].getAsInt(id);
+	if (id == 0)
+	{
+		scanner->scanner->unfreezeAllValues();
+		return this->luaRet(true);
+	}
+	if (id < 0)
+		return this->luaRet(false);
+	return this->luaRet(scanner->scanner->unfreezeValue((FreezeList::FreezeId)id));
+}
+
+LUAENGINE_EXPORT_FUNCTION(watchMemory, "watchMemory"); // watchMemory(scanner, address, offset, type, size, callback, interval)
+int LuaEngine::watchMemory()
+{
+	// one argument too many for the typed getArguments
+	auto args = this->getArguments();
+	if (args.size() != 7) return this->luaRet(false, "Expected a process, address, offset, type, size, callback and interval!");
+	args[1].coerceToPointer();
+
+	auto scanner = this->getArgAsScannerObject(args);
+	if (!scanner.get()) return this->luaRet(false);
+	if (!scanner->target->isAttached()) return this->luaRet(false);
+
+	MemoryAddress address;
+	LuaVariant::LuaVariantInt offset, size, interval;
+	ScanVariant::ScanVariantType memberType;
+	if (!args[1].getAsPointer(address) || !args[2].getAsInt(offset) || !args[3].getAsInt(memberType) ||
+		!args[4].getAsInt(size) || args[5].getType() != LUA_VARIANT_FUNCTION_REF || !args[6].getAsInt(interval))
+		return this->luaRet(false, "Bad arguments to watchMemory!");
+	if (interval <= 0)
+		return this->luaRet(false, "Watch interval must be greater than zero!");
+
+	// numbers are as big as their type, and anything else is a range of bytes
+	if (memberType >= ScanVariant::SCAN_VARIANT_NUMERICTYPES_BEGIN && memberType <= ScanVariant::SCAN_VARIANT_NUMERICTYPES_END)
+		size = ScanVariant::FromNumberTyped(0, memberType).getSize();
+	else
+		memberType = ScanVariant::SCAN_VARIANT_NULL;
+	if (size <= 0)
+		return this->luaRet(false, "Watched memory must have a size!");
+
+	address = (MemoryAddress)((size_t)address + offset); // TODO need to clean this up when MemoryAddress operators are added
+	auto id = scanner->scanner->watchMemory(scanner->target, address, (size_t)size, (uint32_t)interval);
+	if (!id)
+		return this->luaRet(false, "Memory can't be watched!");
+
+	WatchCallback watch;
+	watch.function = args[5];
+	watch.type = memberType;
+	scanner->watches[id] = watch;
+	return this->luaRet((LuaVariant::LuaVariantInt)id);
+}
+
+LUAENGINE_EXPORT_FUNCTION(unwatchMemory, "unwatchMemory"); // unwatchMemory(scanner, id), where an id of 0 unwatches everything
+int LuaEngine::unwatchMemory()
+{
+	auto args = this->getArguments<LUA_VARIANT_KTABLE, LUA_VARIANT_INT>();
+	auto scanner = this->getArgAsScannerObject(args);
+	if (!scanner.get()) return this->luaRet(false);
+
+	LuaVariant::LuaVariantInt id;
+	args[1].getAsInt(id);
+	if (id == 0)
+	{
+		scanner->scanner->unwatchAllMemory();
+		scanner->watches.clear();
+		return this->luaRet(true);
+	}
+	if (id < 0)
+		return this->luaRet(false);
+
+	scanner->watches.erase((WatchList::WatchId)id);
+	return this->luaRet(scanner->scanner->unwatchMemory((WatchList::WatchId)id));
+}
+
 LUAENGINE_EXPORT_FUNCTION(setBlockChecker, "setBlockChecker");
 int LuaEngine::setBlockChecker()
 {
@@ -194,6 +351,117 @@ int LuaEngine::setBlockChecker()
 	return this->luaRet(true);
 }
 
+LUAENGINE_EXPORT_FUNCTION(setBlockFilter, "setBlockFilter");
+int LuaEngine::setBlockFilter()
+{
+	// an empty table comes through as an array, so we can't type check this
+	// one. anything other than a non-empty dictionary clears the filter
+	auto args = this->getArguments();
+	if (args.size() != 2) return this->luaRet(false, "Expected a process and a filter table!");
+
+	auto scanner = this->getArgAsScannerObject(args);
+	if (!scanner.get()) return this->luaRet(false);
+
+	BlockFilter filter;
+	LuaVariant::LuaVariantKTable table;
+	if (args[1].getAsKTable(table))
+	{
+		std::string error;
+		if (!this->getBlockFilterFromLuaTable(table, filter, error))
+			return this->luaRet(false, error);
+	}
+	else if (!args[1].isNil() && !args[1].isArray())
+		return this->luaRet(false, "Expected filter to be a table!");
+
+	scanner->scanner->setBlockFilter(filter);
+	return this->luaRet(true);
+}
+
+LUAENGINE_EXPORT_FUNCTION(captureSnapshot, "captureSnapshot"); // captureSnapshot(scanner, path, compressed)
+int LuaEngine::captureSnapshot()
+{
+	auto args = this->getArguments<LUA_VARIANT_KTABLE, LUA_VARIANT_STRING, LUA_VARIANT_BOOL>();
+	auto scanner = this->getArgAsScannerObject(args);
+	if (!scanner.get()) return this->luaRet(false);
+	if (!scanner->target->isAttached()) return this->luaRet(false);
+
+	std::string path;
+	args[1].getAsString(path);
+
+	// compressed snapshots get everything that makes them smaller
+	bool compressed;
+	args[2].getAsBool(compressed);
+	SnapshotOptions options;
+	options.elideZeroPages = compressed;
+	options.deduplicatePages = compressed;
+	options.compress = compressed;
+
+	if (!scanner->scanner->captureSnapshot(scanner->target, path, options))
+		return this->luaRet(false, "Failed to write snapshot to " + path);
+	return this->luaRet(true);
+}
+
+LUAENGINE_EXPORT_FUNCTION(diffSnapshots, "diffSnapshots"); // diffSnapshots(before, after, minimumWidth)
+int LuaEngine::diffSnapshots()
+{
+	auto args = this->getArguments<LUA_VARIANT_KTABLE, LUA_VARIANT_KTABLE, LUA_VARIANT_INT>();
+	auto before = this->getArgAsScannerObject(args);
+	if (!before.get()) return this->luaRet(false);
+	if (!before->target->isAttached()) return this->luaRet(false);
+
+	LuaVariant::LuaVariantKTable _after;
+	args[1].getAsKTable(_after);
+	ScannerPairList::const_iterator after;
+	if (!this->getScannerPair(_after, after)) return this->luaRet(false);
+	if (!(*after)->target->isAttached()) return this->luaRet(false);
+
+	uint32_t minimumWidth;
+	args[2].getAsInt(minimumWidth);
+
+	MemoryChangeCollection changes;
+	before->scanner->runDiff(before->target, (*after)->target, minimumWidth, changes);
+
+	// changes that look like numbers come out as unsigned numbers, and the rest as arrays of bytes
+	bool isLittleEndian = (*after)->target->isLittleEndian();
+	auto toLuaValue = [this, isLittleEndian](const MemoryChange &change, const std::vector<uint8_t> &bytes) -> LuaVariant
+	{
+		if (change.width == 0)
+		{
+			LuaVariant::LuaVariantITable values;
+			for (auto byte = bytes.cbegin(); byte != bytes.cend(); byte++)
+				values.push_back(LuaVariant((LuaVariant::LuaVariantInt)*byte));
+			return values;
+		}
+
+		uint64_t value = 0;
+		for (size_t i = 0; i < bytes.size(); i++)
+		{
+			auto byte = isLittleEndian ? bytes[bytes.size() - i - 1] : bytes[i];
+			value = (value << 8) | byte;
+		}
+
+		auto type =
+			(change.width == 1) ? ScanVariant::SCAN_VARIANT_UINT8 :
+			(change.width == 2) ? ScanVariant::SCAN_VARIANT_UINT16 :
+			(change.width == 4) ? ScanVariant::SCAN_VARIANT_UINT32 :
+			ScanVariant::SCAN_VARIANT_UINT64;
+		return this->getLuaVariantFromScanVariant(ScanVariant::FromNumberTyped(value, type));
+	};
+
+	LuaVariant::LuaVariantITable results;
+	for (auto change = changes.cbegin(); change != changes.cend(); change++)
+	{
+		LuaVariant::LuaVariantKTable result;
+		result["address"] = LuaVariant(change->address);
+		result["width"] = LuaVariant((LuaVariant::LuaVariantInt)change->width);
+		result["before"] = toLuaValue(*change, change->before);
+		result["after"] = toLuaValue(*change, change->after);
+		results.push_back(result);
+	}
+
+	return this->luaRet(results);
+}
+
 LUAENGINE_EXPORT_FUNCTION(newScan, "newScan");
 int LuaEngine::newScan()
 {
@@ -348,17 +616,21 @@ int LuaEngine::runScan()
 		if (it == valueTable.end()) return this->luaRet(false, "Expected 'value' field!");
 
 		needle = this->getScanVariantFromLuaVariant(it->second, type, false);
+		if (needle.isNull() && type == ScanVariant::SCAN_VARIANT_PATTERN)
+			return this->luaRet(false, "Invalid byte pattern! Expected hex bytes like \"48 8B ?? ?? 89 4?\"");
 		if (needle.isNull())
 			return this->luaRet(false, "Unable to handle member type!");
 	}
 
-	scanner->scanner->runScan
+	auto complete = scanner->scanner->runScan
 	(
 		scanner->target,
 		needle,
 		comparator,
 		typeMode
 	);
+	if (!complete)
+		return this->luaRet(false, "Too many results to keep in memory, and they couldn't be written to disk! Only the first ones were kept.");
 	return this->luaRet(true);
 }
 
@@ -374,18 +646,20 @@ int LuaEngine::getScanResultsSize()
 	return this->luaRet(scanner->scanner->scanState->resultSize());
 }
 
-LUAENGINE_EXPORT_FUNCTION(getScanResults, "getScanResults");
+LUAENGINE_EXPORT_FUNCTION(getScanResults, "getScanResults"); // getScanResults(scanner, start, length, live)
 int LuaEngine::getScanResults()
 {
-	auto args = this->getArguments<LUA_VARIANT_KTABLE, LUA_VARIANT_INT, LUA_VARIANT_INT>();
+	auto args = this->getArguments<LUA_VARIANT_KTABLE, LUA_VARIANT_INT, LUA_VARIANT_INT, LUA_VARIANT_BOOL>();
 	auto scanner = this->getArgAsScannerObject(args);
 	if (!scanner.get()) return this->luaRet(false);
 	if (!scanner->target->isAttached()) return this->luaRet(false);
 	if (!scanner->scanner->scanState.get()) return this->luaRet(false);
 
 	uint32_t start, length;
+	bool live;
 	args[1].getAsInt(start);
 	args[2].getAsInt(length);
+	args[3].getAsBool(live);
 
 	auto resultsLength = scanner->scanner->scanState->resultSize();
 	if (start < 0 || length < 0 || start >= resultsLength || start + length > resultsLength)
@@ -395,18 +669,31 @@ int LuaEngine::getScanResults()
 	auto endIterator = scanner->scanner->scanState->endResult();
 	auto res = startIterator;
 
-	for (size_t i = 0; i < start; i++, res++); // find n-th iterator. ugly cause map
+	for (size_t i = 0; i < start; i++, res++); // find n-th iterator. ugly cause it skips through the hits
 
+	// results come with the values the scan that kept them saw. live results are
+	// read fresh instead, falling back to those values if the read fails
+	bool isLittleEndian = scanner->target->isLittleEndian();
+	std::vector<uint8_t> buffer;
+	ScanResultCollection values;
 	LuaVariant::LuaVariantKTable results;
 	for (; length > 0; length--, res++)
 	{
+		values.clear();
+		res.getResults(values);
+
 		LuaVariant::LuaVariantITable innerResults;
-		for (auto ires = res->second.begin(); ires != res->second.end(); ires++)
+		for (auto ires = values.begin(); ires != values.end(); ires++)
 		{
 			LuaVariant::LuaVariantKTable innerResultType;
 			innerResultType["type"] = LuaVariant(ires->getTypeName());
 
-			auto res = this->getLuaVariantFromScanVariant(*ires);
+			auto current = *ires;
+			buffer.resize(std::max(ires->getSize(), (size_t)1));
+			if (live && res.getLocation()->readCurrentValue(scanner->target, &buffer[0], ires->getSize()))
+				current = ScanVariant::FromRawBuffer(&buffer[0], buffer.size(), isLittleEndian, *ires);
+
+			auto res = this->getLuaVariantFromScanVariant(current);
 			if (res.isTable())
 				innerResultType["values"] = res;
 			else
@@ -415,7 +702,7 @@ int LuaEngine::getScanResults()
 			innerResults.push_back(innerResultType);
 		}
 
-		auto key = this->getLuaVariantFromScanVariant(res->first->toVariant());
+		auto key = this->getLuaVariantFromScanVariant(res.getLocation()->toVariant());
 		key.coerceToPointer();
 		results[key] = innerResults;
 	}
@@ -423,6 +710,250 @@ int LuaEngine::getScanResults()
 	return this->luaRet(results);
 }
 
+LUAENGINE_EXPORT_FUNCTION(undoScan, "undoScan"); // undoScan(scanner)
+int LuaEngine::undoScan()
+{
+	auto args = this->getArguments<LUA_VARIANT_KTABLE>();
+	auto scanner = this->getArgAsScannerObject(args);
+	if (!scanner.get()) return this->luaRet(false);
+	if (!scanner->scanner->scanState.get()) return this->luaRet(false);
+
+	return this->luaRet(scanner->scanner->scanState->undo());
+}
+
+LUAENGINE_EXPORT_FUNCTION(getScanGeneration, "getScanGeneration"); // getScanGeneration(scanner)
+int LuaEngine::getScanGeneration()
+{
+	auto args = this->getArguments<LUA_VARIANT_KTABLE>();
+	auto scanner = this->getArgAsScannerObject(args);
+	if (!scanner.get()) return this->luaRet(false);
+	if (!scanner->scanner->scanState.get()) return this->luaRet(false);
+
+	LuaVariant::LuaVariantKTable generation;
+	generation["current"] = LuaVariant((LuaVariant::LuaVariantInt)scanner->scanner->scanState->getCurrentGeneration());
+	generation["count"] = LuaVariant((LuaVariant::LuaVariantInt)scanner->scanner->scanState->getGenerationCount());
+	return this->luaRet(generation);
+}
+
+LUAENGINE_EXPORT_FUNCTION(setScanGeneration, "setScanGeneration"); // setScanGeneration(scanner, generation)
+int LuaEngine::setScanGeneration()
+{
+	auto args = this->getArguments<LUA_VARIANT_KTABLE, LUA_VARIANT_INT>();
+	auto scanner = this->getArgAsScannerObject(args);
+	if (!scanner.get()) return this->luaRet(false);
+	if (!scanner->scanner->scanState.get()) return this->luaRet(false);
+
+	uint32_t generation;
+	args[1].getAsInt(generation);
+	if (!scanner->scanner->scanState->setCurrentGeneration(generation))
+		return this->luaRet(false, "Invalid scan generation!");
+	return this->luaRet(true);
+}
+
+LUAENGINE_EXPORT_FUNCTION(setScanMetricsEnabled, "setScanMetricsEnabled"); // setScanMetricsEnabled(scanner, enabled)
+int LuaEngine::setScanMetricsEnabled()
+{
+	auto args = this->getArguments<LUA_VARIANT_KTABLE, LUA_VARIANT_BOOL>();
+	auto scanner = this->getArgAsScannerObject(args);
+	if (!scanner.get()) return this->luaRet(false);
+
+	bool enabled;
+	args[1].getAsBool(enabled);
+	scanner->scanner->setMetricsEnabled(enabled);
+	return this->luaRet(true);
+}
+
+LUAENGINE_EXPORT_FUNCTION(getScanMetrics, "getScanMetrics"); // getScanMetrics(scanner)
+int LuaEngine::getScanMetrics()
+{
+	auto args = this->getArguments<LUA_VARIANT_KTABLE>();
+	auto scanner = this->getArgAsScannerObject(args);
+	if (!scanner.get()) return this->luaRet(false);
+	if (!scanner->scanner->getMetricsEnabled()) return this->luaRet(false, "Scan metrics aren't enabled!");
+
+	auto &metrics = scanner->scanner->getLastScanMetrics();
+	LuaVariant::LuaVariantKTable result;
+	result["operation"] = LuaVariant(metrics.operation);
+	result["milliseconds"] = LuaVariant(metrics.milliseconds);
+	result["blocks"] = LuaVariant(metrics.blocks);
+	result["bytesRead"] = LuaVariant(metrics.bytesRead);
+	result["bytesScanned"] = LuaVariant(metrics.bytesScanned);
+	result["readFailures"] = LuaVariant(metrics.readFailures);
+	result["matches"] = LuaVariant(metrics.matches);
+	result["lockWaitMilliseconds"] = LuaVariant(metrics.lockWaitMilliseconds);
+	result["copiedBlocks"] = LuaVariant(metrics.copiedBlocks);
+
+	// phases are keyed by name, and also listed in the order they ran
+	LuaVariant::LuaVariantKTable phases;
+	LuaVariant::LuaVariantITable phaseOrder;
+	for (auto phase = metrics.phases.cbegin(); phase != metrics.phases.cend(); phase++)
+	{
+		phases[phase->name] = LuaVariant(phase->milliseconds);
+		phaseOrder.push_back(LuaVariant(phase->name));
+	}
+	result["phases"] = LuaVariant(phases);
+	result["phaseOrder"] = LuaVariant(phaseOrder);
+
+	LuaVariant::LuaVariantITable threads;
+	for (auto thread = metrics.threads.cbegin(); thread != metrics.threads.cend(); thread++)
+	{
+		LuaVariant::LuaVariantKTable info;
+		info["bytesRead"] = LuaVariant(thread->bytesRead);
+		info["bytesScanned"] = LuaVariant(thread->bytesScanned);
+		info["readFailures"] = LuaVariant(thread->readFailures);
+		info["readMilliseconds"] = LuaVariant(thread->readMilliseconds);
+		info["scanMilliseconds"] = LuaVariant(thread->scanMilliseconds);
+		info["lockWaitMilliseconds"] = LuaVariant(thread->lockWaitMilliseconds);
+		info["megabytesPerSecond"] = LuaVariant(thread->getMegabytesPerSecond());
+		threads.push_back(LuaVariant(info));
+	}
+	result["threads"] = LuaVariant(threads);
+
+	return this->luaRet(result);
+}
+
+LUAENGINE_EXPORT_FUNCTION(getUnreadableRanges, "getUnreadableRanges"); // getUnreadableRanges(scanner)
+int LuaEngine::getUnreadableRanges()
+{
+	auto args = this->getArguments<LUA_VARIANT_KTABLE>();
+	auto scanner = this->getArgAsScannerObject(args);
+	if (!scanner.get()) return this->luaRet(false);
+
+	auto unreadable = scanner->scanner->getLastUnreadableRanges();
+	LuaVariant::LuaVariantITable result;
+	for (auto range = unreadable.begin(); range != unreadable.end(); range++)
+	{
+		LuaVariant::LuaVariantKTable info;
+		info["address"] = LuaVariant(range->first);
+		info["size"] = LuaVariant((uint64_t)((size_t)range->second - (size_t)range->first));
+		result.push_back(LuaVariant(info));
+	}
+	return this->luaRet(result);
+}
+
+LUAENGINE_EXPORT_FUNCTION(setConsistentScan, "setConsistentScan"); // setConsistentScan(scanner, enabled[, budgetMs])
+int LuaEngine::setConsistentScan()
+{
+	auto args = this->getArguments();
+	bool enabled;
+	LuaVariant::LuaVariantInt budget = Scanner::DefaultConsistentScanBudget;
+	if (args.size() < 2 || args.size() > 3 || !args[1].getAsBool(enabled) || (args.size() == 3 && !args[2].getAsInt(budget)))
+		return this->luaRet(false, "Expected a scanner, whether to scan consistently, and optionally a budget in milliseconds!");
+
+	auto scanner = this->getArgAsScannerObject(args);
+	if (!scanner.get()) return this->luaRet(false);
+	if (budget <= 0)
+		return this->luaRet(false, "The consistent scan budget must be at least one millisecond!");
+
+	scanner->scanner->setConsistentScan(enabled, (uint32_t)budget);
+	return this->luaRet(true);
+}
+
+LUAENGINE_EXPORT_FUNCTION(setScanPipeline, "setScanPipeline"); // setScanPipeline(scanner, readers[, scanners[, queueDepth]])
+int LuaEngine::setScanPipeline()
+{
+	auto args = this->getArguments();
+	LuaVariant::LuaVariantInt readers, scanners = 0, queueDepth = Scanner::DefaultPipelineQueueDepth;
+	if (args.size() < 2 || args.size() > 4 || !args[1].getAsInt(readers) ||
+		(args.size() >= 3 && !args[2].getAsInt(scanners)) ||
+		(args.size() == 4 && !args[3].getAsInt(queueDepth)))
+		return this->luaRet(false, "Expected a scanner, the number of reader threads, and optionally the number of scanner threads and the queue depth!");
+	if (readers < 0 || scanners < 0 || queueDepth <= 0)
+		return this->luaRet(false, "Thread counts can't be negative, and the queue needs room for at least one buffer!");
+
+	auto scanner = this->getArgAsScannerObject(args);
+	if (!scanner.get()) return this->luaRet(false);
+
+	scanner->scanner->setScanPipeline((size_t)readers, (size_t)scanners, (size_t)queueDepth);
+	return this->luaRet(true);
+}
+
+LUAENGINE_EXPORT_FUNCTION(setThreadPinning, "setThreadPinning"); // setThreadPinning(scanner, enabled)
+int LuaEngine::setThreadPinning()
+{
+	auto args = this->getArguments<LUA_VARIANT_KTABLE, LUA_VARIANT_BOOL>();
+	auto scanner = this->getArgAsScannerObject(args);
+	if (!scanner.get()) return this->luaRet(false);
+
+	bool enabled;
+	args[1].getAsBool(enabled);
+	scanner->scanner->setThreadPinning(enabled);
+	return this->luaRet(true);
+}
+
+LUAENGINE_EXPORT_FUNCTION(setConsoleProgress, "setConsoleProgress"); // setConsoleProgress(scanner, enabled)
+int LuaEngine::setConsoleProgress()
+{
+	auto args = this->getArguments<LUA_VARIANT_KTABLE, LUA_VARIANT_BOOL>();
+	auto scanner = this->getArgAsScannerObject(args);
+	if (!scanner.get()) return this->luaRet(false);
+
+	bool enabled;
+	args[1].getAsBool(enabled);
+	if (enabled)
+		scanner->scanner->setProgressCallback(ConsoleProgressPrinter());
+	else
+		scanner->scanner->setProgressCallback(nullptr);
+	return this->luaRet(true);
+}
+
+LUAENGINE_EXPORT_FUNCTION(setPatternScanExecutableOnly, "setPatternScanExecutableOnly"); // setPatternScanExecutableOnly(scanner, enabled)
+int LuaEngine::setPatternScanExecutableOnly()
+{
+	auto args = this->getArguments<LUA_VARIANT_KTABLE, LUA_VARIANT_BOOL>();
+	auto scanner = this->getArgAsScannerObject(args);
+	if (!scanner.get()) return this->luaRet(false);
+
+	bool enabled;
+	args[1].getAsBool(enabled);
+	scanner->scanner->setPatternScanExecutableOnly(enabled);
+	return this->luaRet(true);
+}
+
+LUAENGINE_EXPORT_FUNCTION(setResultSpillThreshold, "setResultSpillThreshold"); // setResultSpillThreshold(scanner, threshold)
+int LuaEngine::setResultSpillThreshold()
+{
+	auto args = this->getArguments<LUA_VARIANT_KTABLE, LUA_VARIANT_INT>();
+	auto scanner = this->getArgAsScannerObject(args);
+	if (!scanner.get()) return this->luaRet(false);
+
+	LuaVariant::LuaVariantInt threshold;
+	args[1].getAsInt(threshold);
+	if (threshold < 0)
+		return this->luaRet(false, "The spill threshold can't be negative!");
+
+	scanner->scanner->setResultSpillThreshold((size_t)threshold);
+	return this->luaRet(true);
+}
+
+LUAENGINE_EXPORT_FUNCTION(startTrace, "startTrace"); // startTrace([eventsPerThread])
+int LuaEngine::startTrace()
+{
+	auto args = this->getArguments();
+	LuaVariant::LuaVariantInt eventsPerThread = Trace::DefaultEventsPerThread;
+	if (args.size() > 1 || (args.size() == 1 && !args[0].getAsInt(eventsPerThread)))
+		return this->luaRet(false, "Expected nothing, or how many events to keep per thread!");
+	if (eventsPerThread <= 0)
+		return this->luaRet(false, "Traces must keep at least one event per thread!");
+
+	Trace::start((size_t)eventsPerThread);
+	return this->luaRet(true);
+}
+
+LUAENGINE_EXPORT_FUNCTION(stopTrace, "stopTrace"); // stopTrace(path)
+int LuaEngine::stopTrace()
+{
+	auto args = this->getArguments<LUA_VARIANT_STRING>();
+	std::string path;
+	args[0].getAsString(path);
+
+	// the trace is saved as Chrome trace JSON, for chrome://tracing or Perfetto
+	Trace::stop();
+	if (!Trace::write(path))
+		return this->luaRet(false, "Failed to write trace to " + path);
+	return this->luaRet(true);
+}
+
 LUAENGINE_EXPORT_FUNCTION(getDataStructures, "getDataStructures");
 int LuaEngine::getDataStructures()
 {
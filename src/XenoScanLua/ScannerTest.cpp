@@ -1,19 +1,82 @@
 #include "ScannerTest.h"
 #include <iostream>
+#include <cstring>
 
+#include "XenoScanEngine/ScannerTarget.h"
+
+#ifdef WIN32
 #include <Windows.h>
 
+static inline uint32_t getCurrentProcessId()
+{
+	return (uint32_t)GetCurrentProcessId();
+}
+
+// there's no fork() to get a child with our memory at the same addresses, so
+// the tests that need a second process are skipped
+static inline uint32_t startChildProcess(volatile uint32_t &/*heartbeat*/)
+{
+	return 0;
+}
+static inline void stopChildProcess(const uint32_t &/*pid*/)
+{
+}
+#else
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+
+static inline uint32_t getCurrentProcessId()
+{
+	return (uint32_t)getpid();
+}
+
+// the child is a fork of us, so everything the tests look for is at the same
+// address in it. it only counts the heartbeat up until it's killed (or we die)
+static inline uint32_t startChildProcess(volatile uint32_t &heartbeat)
+{
+	auto pid = fork();
+	if (pid < 0)
+		return 0;
+	if (pid > 0)
+		return (uint32_t)pid;
+
+	// other threads didn't come along, so only async-signal-safe calls from here on
+	prctl(PR_SET_PDEATHSIG, SIGKILL);
+	struct timespec tick = { 0, 1000000 };
+	while (true)
+	{
+		heartbeat = heartbeat + 1;
+		nanosleep(&tick, nullptr);
+	}
+}
+static inline void stopChildProcess(const uint32_t &pid)
+{
+	if (!pid)
+		return;
+	kill((pid_t)pid, SIGKILL);
+	waitpid((pid_t)pid, nullptr, 0);
+}
+#endif
+
 ScannerTest::ScannerTest()
-	: TestBase("Scanner")
+	: TestBase("Scanner"), heartbeat(0)
 {}
 
 bool ScannerTest::runTest(const LuaEngineShPtr &engine)
 {
-	// TODO: this needs to be fixed for non-windows compilation
-	engine->pushGlobal("TEST_PID", (uint32_t)GetCurrentProcessId());
+	// we scan ourselves through the native target when there is one, and
+	// through the self target when there isn't
+	auto targetKeys = ScannerTarget::Factory.getKeys();
+	if (targetKeys.find("proc") != targetKeys.end())
+		engine->pushGlobal("TEST_PID", getCurrentProcessId());
+	else
+		engine->pushGlobal("TEST_PID", std::string("self"));
 
 	// string stuff
-	strcpy_s<32>(this->string1, "I'm a really cool string brotha");
+	strncpy(this->string1, "I'm a really cool string brotha", sizeof(this->string1));
 	this->string2 = "Teeeeeeest. String.";
 	this->string3 = L"Test. Wide. String. Foobar?";
 
@@ -44,12 +107,32 @@ bool ScannerTest::runTest(const LuaEngineShPtr &engine)
 	engine->pushGlobal("TEST_STRUCT_ADDRESS", (void*)&this->testStruct.entries[0]);
 
 	// timestamp dynamic variant tests stuff
-	GetSystemTimeAsFileTime((LPFILETIME)&this->filetime64); // TODO make generic
-	this->ticktime32 = (uint32_t)GetTickCount(); // same
+	// the self target has the same clocks as the native one, on Windows and Linux
+	auto self = ScannerTarget::Factory.createInstance("self");
+	if (!self || !self->attach(0))
+	{
+		std::cerr << "Failed to attach the self target" << std::endl;
+		return false;
+	}
+	this->filetime64 = self->getFileTime64();
+	this->ticktime32 = self->getTickTime32();
 	engine->pushGlobal("TEST_FILETIME64_ADDRESS", (void*)&this->filetime64);
 	engine->pushGlobal("TEST_TICKTIME32_ADDRESS", (void*)&this->ticktime32);
 
-	if (!engine->doFile(L"ScannerTest.lua"))
+	// a second process is the only thing a consistent scan can actually suspend,
+	// and it has to be one the native target can attach to
+	uint32_t childPid = 0;
+	if (targetKeys.find("proc") != targetKeys.end())
+		childPid = startChildProcess(this->heartbeat);
+	if (childPid)
+	{
+		engine->pushGlobal("TEST_CHILD_PID", childPid);
+		engine->pushGlobal("TEST_HEARTBEAT_ADDRESS", (void*)&this->heartbeat);
+	}
+
+	auto ran = engine->doFile(L"ScannerTest.lua");
+	stopChildProcess(childPid);
+	if (!ran)
 	{
 		std::cerr << "Failed to run test: ScannerTest.lua" << std::endl;
 		return false;
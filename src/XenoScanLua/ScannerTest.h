@@ -18,6 +18,9 @@ private:
 	uint64_t filetime64;
 	uint32_t ticktime32;
 
+	// a forked copy of us counts this up, so tests can tell it's running
+	volatile uint32_t heartbeat;
+
 	struct
 	{
 		uint32_t entries[7];
@@ -24,6 +24,250 @@ print("TESTING: std::wstring")
 string3 = findStringResults(widestring, TEST_STRING3, TEST_STRING3_ADDRESS)
 tests.assertNotNil(string3, "Failed to locate std::wstring!")
 
+--------------- TEST BLOCK FILTER ---------------
+function findFilteredStringResults(filter, totype, value, expected)
+	local proc = Process(TEST_PID)
+	proc:setBlockFilter(filter)
+	proc:newScan()
+	proc:scanFor(totype(value))
+	local results = proc:getResults()
+	proc:destroy()
+
+	return results[expected]
+end
+
+-- the test strings are in a global, so they're always in writeable memory inside of a module
+print("TESTING: block filter (include)")
+string1 = findFilteredStringResults({module = true, writeable = true}, ascii, TEST_STRING1, TEST_STRING1_ADDRESS)
+tests.assertNotNil(string1, "Failed to locate char[32] with a block filter!")
+
+print("TESTING: block filter (exclude)")
+string1 = findFilteredStringResults({module = false}, ascii, TEST_STRING1, TEST_STRING1_ADDRESS)
+tests.assert(string1 == nil, "Located char[32] in a region the block filter should exclude!")
+
+--------------- TEST SCAN HISTORY ---------------
+print("TESTING: scan history")
+local proc = Process(TEST_PID)
+proc:newScan()
+proc:scanFor(ascii(TEST_STRING1))
+proc:scanFor(ascii(TEST_STRING2)) -- narrows the first scan down to nothing
+tests.assert(proc:getResults()[TEST_STRING1_ADDRESS] == nil, "Located char[32] after narrowing it away!")
+
+tests.assert(proc:undoScan(), "Failed to undo a scan!")
+tests.assertNotNil(proc:getResults()[TEST_STRING1_ADDRESS], "Failed to locate char[32] after undoing a scan!")
+
+local current, count = proc:getScanGeneration()
+tests.assert(current == 0 and count == 2, "Unexpected scan generation after undoing a scan!")
+proc:setScanGeneration(1)
+tests.assert(proc:getResults()[TEST_STRING1_ADDRESS] == nil, "Located char[32] after redoing a scan!")
+proc:destroy()
+
+--------------- TEST SCAN METRICS ---------------
+print("TESTING: scan metrics")
+local proc = Process(TEST_PID)
+proc:setScanMetricsEnabled(true)
+proc:newScan()
+proc:scanFor(ascii(TEST_STRING1))
+local metrics = proc:getScanMetrics()
+tests.assert(metrics.operation == "scan", "Scan metrics describe the wrong operation!")
+tests.assert(metrics.matches == proc:getResultsSize(), "Scan metrics counted the wrong number of matches!")
+tests.assert(metrics.bytesScanned > 0 and #metrics.threads > 0, "Scan metrics didn't see anything scanned!")
+tests.assertNotNil(metrics.phases.scan, "Scan metrics are missing the scan phase!")
+
+proc:scanFor(ascii(TEST_STRING1))
+tests.assert(proc:getScanMetrics().operation == "rescan", "Re-scan metrics describe the wrong operation!")
+proc:destroy()
+
+--------------- TEST UNREADABLE RANGES ---------------
+print("TESTING: unreadable ranges")
+local proc = Process(TEST_PID)
+proc:newScan()
+proc:scanFor(ascii(TEST_STRING1))
+local unreadable = proc:getUnreadableRanges()
+tests.assert(type(unreadable) == "table", "Failed to get the unreadable ranges!")
+for _, range in ipairs(unreadable) do
+	tests.assert(range.size > 0, "Got an empty unreadable range!")
+end
+proc:destroy()
+
+--------------- TEST CONSISTENT SCAN ---------------
+-- we can't suspend ourselves, so this one has to fall back to a live scan
+print("TESTING: consistent scan (live fallback)")
+local proc = Process(TEST_PID)
+proc:setScanMetricsEnabled(true)
+proc:setConsistentScan(true, 100)
+proc:newScan()
+proc:scanFor(ascii(TEST_STRING1))
+tests.assertNotNil(proc:getResults()[TEST_STRING1_ADDRESS], "Failed to locate char[32] with a consistent scan!")
+tests.assert(proc:getScanMetrics().copiedBlocks == 0, "Copied blocks from a process that can't be suspended!")
+proc:destroy()
+
+-- but a child process can be, so this goes through the suspend, copy and resume
+if (TEST_CHILD_PID) then
+	print("TESTING: consistent scan (suspended)")
+	local proc = Process(TEST_CHILD_PID)
+	proc:setScanMetricsEnabled(true)
+	proc:setConsistentScan(true, 2000)
+	proc:newScan()
+	proc:scanFor(ascii(TEST_STRING1))
+	tests.assertNotNil(proc:getResults()[TEST_STRING1_ADDRESS], "Failed to locate char[32] in a suspended child!")
+	tests.assert(proc:getScanMetrics().copiedBlocks > 0, "Consistent scan of a child didn't copy anything!")
+
+	-- the re-scan only copies the pages its results are on, and has to let it go after that too
+	proc:scanFor(ascii(TEST_STRING1))
+	tests.assertNotNil(proc:getResults()[TEST_STRING1_ADDRESS], "Lost char[32] re-scanning a suspended child!")
+	tests.assert(proc:getScanMetrics().copiedBlocks > 0, "Consistent re-scan of a child didn't copy anything!")
+
+	local beat = proc:readMemory(TEST_HEARTBEAT_ADDRESS, uint32)
+	local deadline = os.clock() + 1
+	while (proc:readMemory(TEST_HEARTBEAT_ADDRESS, uint32) == beat and os.clock() < deadline) do end
+	tests.assert(proc:readMemory(TEST_HEARTBEAT_ADDRESS, uint32) ~= beat, "Child is still suspended after a consistent scan!")
+	proc:destroy()
+end
+
+--------------- TEST SCAN PIPELINE ---------------
+print("TESTING: scan pipeline")
+local proc = Process(TEST_PID)
+proc:setScanPipeline(1, 1, 2)
+proc:newScan()
+proc:scanFor(ascii(TEST_STRING1))
+tests.assertNotNil(proc:getResults()[TEST_STRING1_ADDRESS], "Failed to locate char[32] with a pipelined scan!")
+proc:destroy()
+
+print("TESTING: pinned scan pipeline")
+local proc = Process(TEST_PID)
+proc:setThreadPinning(true)
+proc:setScanPipeline(1, 1, 2)
+proc:newScan()
+proc:scanFor(ascii(TEST_STRING1))
+tests.assertNotNil(proc:getResults()[TEST_STRING1_ADDRESS], "Failed to locate char[32] with a pinned scan!")
+proc:destroy()
+
+--------------- TEST BYTE PATTERN ---------------
+-- the test strings aren't code, so they're only found once the scan isn't limited to executable memory
+local patternBytes = {}
+for i = 1, #TEST_STRING1 do
+	patternBytes[i] = string.format("%02X", TEST_STRING1:byte(i))
+end
+patternBytes[2] = "??"
+patternBytes[3] = patternBytes[3]:sub(1, 1) .. "?"
+local testPattern = pattern(table.concat(patternBytes, " "))
+
+print("TESTING: byte pattern")
+local proc = Process(TEST_PID)
+proc:setPatternScanExecutableOnly(false)
+proc:newScan()
+proc:scanFor(testPattern)
+tests.assertNotNil(proc:getResults()[TEST_STRING1_ADDRESS], "Failed to locate char[32] with a byte pattern!")
+
+print("TESTING: byte pattern (executable only)")
+proc:setPatternScanExecutableOnly(true)
+proc:newScan()
+proc:scanFor(testPattern)
+tests.assert(proc:getResults()[TEST_STRING1_ADDRESS] == nil, "Located char[32] with a byte pattern in non-executable memory!")
+proc:destroy()
+
+--------------- TEST RESULT SPILLING ---------------
+-- the zeros in our own data are plenty of results to spill with a tiny threshold
+function countZeroResults(spillThreshold)
+	local proc = Process(TEST_PID)
+	proc:setBlockFilter({module = true, writeable = true})
+	proc:setResultSpillThreshold(spillThreshold)
+	proc:newScan()
+	proc:scanFor(uint32(0))
+	local scanned = proc:getResultsSize()
+	proc:scanFor(uint32(0))
+	local rescanned = proc:getResultsSize()
+	proc:destroy()
+
+	return scanned, rescanned
+end
+
+print("TESTING: result spilling")
+local keptScanned, keptRescanned = countZeroResults(0)
+local spilledScanned, spilledRescanned = countZeroResults(16)
+tests.assert(keptScanned > 16, "Not enough results to spill!")
+tests.assert(spilledScanned == keptScanned, "Spilled scan found a different number of results!")
+tests.assert(spilledRescanned == keptRescanned, "Spilled rescan found a different number of results!")
+
+--------------- TEST SNAPSHOTS ---------------
+-- only our own data is captured, which keeps the snapshots small
+function findSnapshotResults(compressed)
+	local snapshotPath = os.tmpname()
+	local proc = Process(TEST_PID)
+	proc:setBlockFilter({module = true, writeable = true})
+	tests.assert(proc:captureSnapshot(snapshotPath, compressed), "Failed to capture a snapshot!")
+	proc:destroy()
+
+	local snapshot = Process.openSnapshot(snapshotPath)
+	snapshot:newScan()
+	snapshot:scanFor(ascii(TEST_STRING1))
+	snapshot:scanFor(ascii(TEST_STRING1))
+	local results = snapshot:getResults()
+	snapshot:destroy()
+	os.remove(snapshotPath)
+
+	return results[TEST_STRING1_ADDRESS]
+end
+
+print("TESTING: snapshot")
+tests.assertNotNil(findSnapshotResults(false), "Failed to locate char[32] in a snapshot!")
+
+print("TESTING: snapshot (compressed)")
+tests.assertNotNil(findSnapshotResults(true), "Failed to locate char[32] in a compressed snapshot!")
+
+--------------- TEST DIFF ---------------
+print("TESTING: diff")
+local beforePath, afterPath = os.tmpname(), os.tmpname()
+local proc = Process(TEST_PID)
+proc:setBlockFilter({module = true, writeable = true})
+local original = proc:readMemory(TEST_STRUCT_ADDRESS, uint32)
+tests.assert(proc:captureSnapshot(beforePath, false), "Failed to capture the snapshot before the change!")
+proc:writeMemory(TEST_STRUCT_ADDRESS, uint32(original + 1))
+tests.assert(proc:captureSnapshot(afterPath, true), "Failed to capture the snapshot after the change!")
+proc:writeMemory(TEST_STRUCT_ADDRESS, uint32(original))
+proc:destroy()
+
+local before, after = Process.openSnapshot(beforePath), Process.openSnapshot(afterPath)
+local found = nil
+for _, change in ipairs(before:diff(after, 4)) do
+	if (change.address == TEST_STRUCT_ADDRESS) then found = change end
+end
+before:destroy()
+after:destroy()
+os.remove(beforePath)
+os.remove(afterPath)
+
+tests.assertNotNil(found, "Failed to find the changed array member in the diff!")
+tests.assert(found and found.width == 4 and found.before == original and found.after == original + 1, "The diff got the changed array member wrong!")
+
+--------------- TEST TRACE ---------------
+print("TESTING: trace")
+local proc = Process(TEST_PID)
+local tracePath = os.tmpname()
+tests.assert(startTrace(), "Failed to start a trace!")
+proc:newScan()
+proc:scanFor(ascii(TEST_STRING1))
+tests.assert(stopTrace(tracePath), "Failed to write a trace!")
+
+local trace = io.open(tracePath, "r")
+local contents = trace:read("*a")
+trace:close()
+os.remove(tracePath)
+tests.assert(contents:find("\"name\":\"search\"", 1, true) ~= nil, "Trace has no search events!")
+proc:destroy()
+
+--------------- TEST SELF TARGET ---------------
+print("TESTING: self target")
+local proc = Process("self")
+proc:newScan()
+proc:scanFor(ascii(TEST_STRING1))
+tests.assertNotNil(proc:getResults()[TEST_STRING1_ADDRESS], "Failed to locate char[32] through the self target!")
+
+-- the first page is never mapped, so this has to fault (and be caught)
+tests.assert(not proc:writeMemory(ptrcast(16), uint32(1)), "Wrote to an unmapped address through the self target!")
+proc:destroy()
+
 --------------- TEST STRUCTURE (COMMON) ---------------
 testStruct = struct(
 	uint32("one"),
@@ -115,6 +359,25 @@ writeNewStructureValues(arrayResults)
 print("TESTING: array (write then scan)")
 tests.assertNotNil(findStructureResults(), "Failed to locate test array (write then scan)!")
 
+--------------- TEST RESULT VALUES ---------------
+-- results keep the value their last scan saw, unless they're asked for live
+print("TESTING: result values")
+local scannedValue = testStruct["obj"][1]
+local proc = Process(TEST_PID)
+proc:newScan()
+proc:scanFor(uint32(scannedValue))
+proc:scanFor(uint32(scannedValue))
+proc:writeMemory(TEST_STRUCT_ADDRESS, uint32(scannedValue + 1))
+
+local stored = proc:getResults()[TEST_STRUCT_ADDRESS]
+local live = proc:getResults(nil, nil, true)[TEST_STRUCT_ADDRESS]
+tests.assertNotNil(stored, "Failed to locate the first array member!")
+tests.assert(stored and stored[1].value == scannedValue, "Result value changed after the scan!")
+tests.assert(live and live[1].value == scannedValue + 1, "Live result value wasn't read fresh!")
+
+proc:writeMemory(TEST_STRUCT_ADDRESS, uint32(scannedValue))
+proc:destroy()
+
 --------------- TEST TIMESTAMP DYNAMIC VARIANTS ---------------
 function dynamicValueSearch(val, expected)
 	local proc = Process(TEST_PID)
@@ -139,4 +402,79 @@ testStruct = struct(
 )
 testStruct.tt = range(-50000, 50000)
 print("TESTING: ticktime32")
-tests.assertNotNil(dynamicValueSearch(testStruct, TEST_TICKTIME32_ADDRESS), "Failed to locate ticktime32!")
\ No newline at end of file
+tests.assertNotNil(dynamicValueSearch(testStruct, TEST_TICKTIME32_ADDRESS), "Failed to locate ticktime32!")
+
+--------------- TEST FREEZE ---------------
+print("TESTING: freeze")
+local proc = Process(TEST_PID)
+local original = proc:readMemory(TEST_STRUCT_ADDRESS, uint32)
+local frozen = proc:freezeMemory(TEST_STRUCT_ADDRESS, uint32(original + 1), 10)
+proc:writeMemory(TEST_STRUCT_ADDRESS, uint32(original + 2))
+
+-- give the freeze (up to) a second to write the value back
+local deadline = os.clock() + 1
+while (proc:readMemory(TEST_STRUCT_ADDRESS, uint32) ~= original + 1 and os.clock() < deadline) do end
+tests.assert(proc:readMemory(TEST_STRUCT_ADDRESS, uint32) == original + 1, "Frozen value wasn't written back!")
+
+tests.assert(proc:unfreezeMemory(frozen), "Failed to unfreeze a value!")
+proc:writeMemory(TEST_STRUCT_ADDRESS, uint32(original))
+tests.assert(proc:readMemory(TEST_STRUCT_ADDRESS, uint32) == original, "Value was still frozen after unfreezing it!")
+proc:destroy()
+
+--------------- TEST WATCH ---------------
+print("TESTING: watch")
+local proc = Process(TEST_PID)
+local first = proc:readMemory(TEST_STRUCT_ADDRESS, uint32)
+local second = proc:readMemory(TEST_STRUCT_ADDRESS, 4, uint32)
+local third = proc:readMemory(TEST_STRUCT_ADDRESS, 8, uint32)
+
+-- the first two are next to each other, so they're read together
+local firstChanges, secondChanges, thirdChanges = {}, {}, {}
+local firstWatch = proc:watchMemory(TEST_STRUCT_ADDRESS, uint32, function(address, after, before)
+	table.insert(firstChanges, { address = address, after = after, before = before })
+end, 10)
+proc:watchMemory(TEST_STRUCT_ADDRESS, 4, uint32, function(address, after, before)
+	table.insert(secondChanges, { address = address, after = after, before = before })
+end, 10)
+local thirdWatch
+thirdWatch = proc:watchMemory(TEST_STRUCT_ADDRESS, 8, uint32, function(address, after, before)
+	table.insert(thirdChanges, after)
+	proc:unwatchMemory(thirdWatch)
+end, 10)
+
+-- runs the callbacks for (up to) a second, or until done() says they've all come in
+function waitForWatches(done)
+	local deadline = os.clock() + 1
+	repeat doThink() until ((done and done()) or os.clock() > deadline)
+end
+
+-- nothing has changed yet, but the watches need to have seen the memory once
+waitForWatches()
+tests.assert(#firstChanges == 0 and #secondChanges == 0 and #thirdChanges == 0, "Watch reported a change before anything changed!")
+
+proc:writeMemory(TEST_STRUCT_ADDRESS, uint32(first + 1))
+proc:writeMemory(TEST_STRUCT_ADDRESS, 4, uint32(second + 1))
+proc:writeMemory(TEST_STRUCT_ADDRESS, 8, uint32(third + 1))
+waitForWatches(function() return #firstChanges > 0 and #secondChanges > 0 and #thirdChanges > 0 end)
+
+tests.assert(#firstChanges == 1, "Watch didn't report the change to the first value exactly once!")
+tests.assert(firstChanges[1].address == TEST_STRUCT_ADDRESS, "Watch reported the wrong address!")
+tests.assert(firstChanges[1].after == first + 1 and firstChanges[1].before == first, "Watch reported the wrong values!")
+tests.assert(#secondChanges == 1, "Watch didn't report the change to the second value exactly once!")
+tests.assert(proc:readMemory(secondChanges[1].address, uint32) == second + 1, "Watch reported the wrong address for an offset!")
+tests.assert(secondChanges[1].after == second + 1 and secondChanges[1].before == second, "Watch reported the wrong values for an offset!")
+tests.assert(#thirdChanges == 1 and thirdChanges[1] == third + 1, "Watch that unwatches itself wasn't called!")
+
+-- the one that unwatched itself stays quiet
+proc:writeMemory(TEST_STRUCT_ADDRESS, 8, uint32(third))
+waitForWatches()
+tests.assert(#thirdChanges == 1, "Watch was called after it unwatched itself!")
+
+-- and so does everything else, once it's unwatched
+tests.assert(proc:unwatchMemory(firstWatch), "Failed to unwatch memory!")
+proc:unwatchMemory()
+proc:writeMemory(TEST_STRUCT_ADDRESS, uint32(first))
+proc:writeMemory(TEST_STRUCT_ADDRESS, 4, uint32(second))
+waitForWatches()
+tests.assert(#firstChanges == 1 and #secondChanges == 1, "Watch was called after it was unwatched!")
+proc:destroy()
\ No newline at end of file
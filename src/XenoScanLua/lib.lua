@@ -48,8 +48,6 @@ Process.__index = Process
 
 PROCESS_ATTACH_KEY = "proc"
 
-assert(table.icontains(ATTACH_TARGET_NAMES, PROCESS_ATTACH_KEY), "expected a native proc target type!")
-
 function Process.new(pid)
 	local this = {}
 	if (not ATTACHED_PROCESSES[pid]) then
@@ -60,6 +58,7 @@ function Process.new(pid)
 			assert(table.icontains(ATTACH_TARGET_NAMES, pid), "Target with type '" .. pid .. "' not implemented!")
 			this.__nativeObject = attach(pid, 0)
 		else
+			assert(table.icontains(ATTACH_TARGET_NAMES, PROCESS_ATTACH_KEY), "expected a native proc target type!")
 			this.__nativeObject = attach(PROCESS_ATTACH_KEY, this._pid)
 		end
 
@@ -72,6 +71,25 @@ function Process.new(pid)
 end
 setmetatable(Process, {__call = function(_, ...) return Process.new(...) end})
 
+SNAPSHOT_ATTACH_KEY = "snapshot"
+
+-- opens a snapshot written by Process:captureSnapshot(). it can be scanned and
+-- read like any other process (even after the original is gone), but not written
+function Process.openSnapshot(path)
+	local key = SNAPSHOT_ATTACH_KEY .. ":" .. path
+	local this = ATTACHED_PROCESSES[key]
+	if (not this) then
+		this = {}
+		setmetatable(this, Process)
+		this._pid = key
+		this.__nativeObject = attachFile(SNAPSHOT_ATTACH_KEY, path)
+
+		assert(this.__nativeObject, "Failed to open snapshot '" .. path .. "'!")
+		ATTACHED_PROCESSES[key] = this
+	end
+	return this
+end
+
 function Process:destroy()
 	local this = type(self) == 'table' and self or Process.new(self)
 
@@ -85,26 +103,154 @@ function Process:setBlockChecker(func)
 	return setBlockChecker(this.__nativeObject, func)
 end
 
+-- filter is a table of rules that are checked natively, which is much cheaper than a block checker:
+--     writeable, executable, mapped, mappedImage, module = true (required), false (excluded), or nil
+--     minSize, maxSize = size bounds, in bytes
+--     modules, excludeModules = arrays of module name globs, like "game*.dll"
+--     ranges, excludeRanges = arrays of {start, end} address pairs
+-- passing nil or an empty table clears the filter
+function Process:setBlockFilter(filter)
+	local this = type(self) == 'table' and self or Process.new(self)
+	return setBlockFilter(this.__nativeObject, filter or {})
+end
+
+-- writes every block that would be scanned (so the block filter and checker apply) to path.
+-- compressed snapshots leave out zero pages, store repeated pages once and compress the rest,
+-- which makes them much smaller, but they have to be decompressed as they're scanned
+function Process:captureSnapshot(path, compressed)
+	local this = type(self) == 'table' and self or Process.new(self)
+	return captureSnapshot(this.__nativeObject, path, compressed and true or false)
+end
+
+-- compares this process (the earlier state) to another one, usually two snapshots of
+-- the same process. returns an array of {address, width, before, after}, where width is
+-- 1, 2, 4 or 8 for things that look like numbers, or 0 (with arrays of bytes) for the rest.
+-- minimumWidth (default 4) stops small changes from being reported as single bytes
+function Process:diff(after, minimumWidth)
+	local this = type(self) == 'table' and self or Process.new(self)
+	local result, message = diffSnapshots(this.__nativeObject, after.__nativeObject, minimumWidth or 4)
+	assert(result, message)
+	return result
+end
+
 function Process:newScan()
 	local this = type(self) == 'table' and self or Process.new(self)
 
 	return newScan(this.__nativeObject)
 end
 
+-- steps back to the results before the last scan. scanning again after this
+-- throws away the undone scans, just like typing after an undo in an editor
+function Process:undoScan()
+	local this = type(self) == 'table' and self or Process.new(self)
+	return undoScan(this.__nativeObject)
+end
+
+-- scans are numbered from 0 (the first scan). returns the one the results
+-- currently come from, and how many there are
+function Process:getScanGeneration()
+	local this = type(self) == 'table' and self or Process.new(self)
+	local generation = getScanGeneration(this.__nativeObject)
+	return generation.current, generation.count
+end
+
+function Process:setScanGeneration(generation)
+	local this = type(self) == 'table' and self or Process.new(self)
+	local result, message = setScanGeneration(this.__nativeObject, generation)
+	assert(result, message)
+	return result
+end
+
+-- scans only keep track of where their time goes while metrics are enabled.
+-- getScanMetrics() then describes the last scan: its phases, bytes read and
+-- scanned, matches, read failures, lock waits and per-thread throughput, and
+-- how many blocks a consistent scan copied from the suspended process
+function Process:setScanMetricsEnabled(enabled)
+	local this = type(self) == 'table' and self or Process.new(self)
+	return setScanMetricsEnabled(this.__nativeObject, enabled ~= false)
+end
+
+function Process:getScanMetrics()
+	local this = type(self) == 'table' and self or Process.new(self)
+	local result, message = getScanMetrics(this.__nativeObject)
+	assert(result, message)
+	return result
+end
+
+-- the parts of memory the last scan couldn't read, as { address, size } tables.
+-- targets that can salvage partial reads only list the pages that failed
+function Process:getUnreadableRanges()
+	local this = type(self) == 'table' and self or Process.new(self)
+	return getUnreadableRanges(this.__nativeObject)
+end
+
+-- consistent scans suspend the process for at most budgetMs (500 by default),
+-- copy the memory they're going to scan, let it go, and then scan the copy, so
+-- values that move around while a scan runs aren't missed or seen twice
+function Process:setConsistentScan(enabled, budgetMs)
+	local this = type(self) == 'table' and self or Process.new(self)
+	local result, message
+	if (budgetMs) then
+		result, message = setConsistentScan(this.__nativeObject, enabled ~= false, budgetMs)
+	else
+		result, message = setConsistentScan(this.__nativeObject, enabled ~= false)
+	end
+	assert(result, message)
+	return result
+end
+
+-- pipelined scans have readers threads copying memory out of the process while
+-- the scanner threads (every other thread, unless scanners is given) search it.
+-- queueDepth is how many buffers the readers can get ahead by. 0 readers turns it off
+function Process:setScanPipeline(readers, scanners, queueDepth)
+	local this = type(self) == 'table' and self or Process.new(self)
+	local result, message = setScanPipeline(this.__nativeObject, readers, scanners or 0, queueDepth or 8)
+	assert(result, message)
+	return result
+end
+
+-- pinned scans keep each worker on its own CPU, spread over the NUMA nodes,
+-- so memory gets read and scanned on the node it was allocated on
+function Process:setThreadPinning(enabled)
+	local this = type(self) == 'table' and self or Process.new(self)
+	return setThreadPinning(this.__nativeObject, enabled ~= false)
+end
+
+-- scans are quiet unless this is on, in which case they print
+-- how many blocks they've gotten through as they go
+function Process:setConsoleProgress(enabled)
+	local this = type(self) == 'table' and self or Process.new(self)
+	return setConsoleProgress(this.__nativeObject, enabled ~= false)
+end
+
+function Process:setPatternScanExecutableOnly(enabled)
+	local this = type(self) == 'table' and self or Process.new(self)
+	return setPatternScanExecutableOnly(this.__nativeObject, enabled ~= false)
+end
+
+-- once a first scan finds more than threshold locations, its results are
+-- written to temporary files instead of being kept in memory. 0 never spills
+function Process:setResultSpillThreshold(threshold)
+	local this = type(self) == 'table' and self or Process.new(self)
+	return setResultSpillThreshold(this.__nativeObject, threshold)
+end
+
 function Process:getResultsSize()
 	local this = type(self) == 'table' and self or Process.new(self)
 
 	return getScanResultsSize(this.__nativeObject)
 end
 
-function Process:getResults(offset, count)
+-- results hold the values they had when they were (re)scanned, unless
+-- live is true, in which case their current values are read instead
+function Process:getResults(offset, count, live)
 	local this = type(self) == 'table' and self or Process.new(self)
 
 	count = count or this:getResultsSize()
 	if (count == 0) then return {} end
 	offset = offset or 0
 
-	local result, message = getScanResults(this.__nativeObject, offset, count)
+	local result, message = getScanResults(this.__nativeObject, offset, count, live == true)
 	assert(result, message)
 	return result
 end
@@ -182,6 +328,62 @@ function Process:writeMemory(address, offset, value)
 	return writeMemory(this.__nativeObject, address, offset, tostring(writeValue.__name), writeValue.__type)
 end
 
+-- keeps writing value (a single typed value) every interval milliseconds until it's unfrozen.
+-- returns an id for unfreezeMemory()
+function Process:freezeMemory(address, offset, value, interval)
+	local this = type(self) == 'table' and self or Process.new(self)
+	if (type(offset) ~= 'number') then
+		interval = value
+		value = offset
+		offset = 0
+	end
+	interval = interval or 100
+
+	local freezeValue = this:__validateMemoryValueForReadWrite(value)
+	assert(freezeValue.__name, "No value specified for freeze: " .. table.show(freezeValue, ""))
+	local id, message = freezeMemory(this.__nativeObject, address, offset, tostring(freezeValue.__name), freezeValue.__type, interval)
+	assert(id, message)
+	return id
+end
+
+-- with no id, everything is unfrozen
+function Process:unfreezeMemory(id)
+	local this = type(self) == 'table' and self or Process.new(self)
+	return unfreezeMemory(this.__nativeObject, id or 0)
+end
+
+-- calls callback(address, newValue, oldValue) whenever the memory changes, checking every interval milliseconds.
+-- what is either a numeric type, or a number of bytes to watch (which are reported as arrays of bytes).
+-- returns an id for unwatchMemory()
+function Process:watchMemory(address, offset, what, callback, interval)
+	local this = type(self) == 'table' and self or Process.new(self)
+	if (type(what) == 'function' and type(callback) ~= 'function') then
+		interval = callback
+		callback = what
+		what = offset
+		offset = 0
+	end
+	assert(type(callback) == 'function', "Expected a callback for watched memory!")
+	interval = interval or 100
+
+	local watchType, watchSize = SCAN_VARIANT_STRUCTURE, what
+	if (type(what) ~= 'number') then
+		local watchValue = this:__validateMemoryValueForReadWrite(what)
+		assert(TYPE_DEFINITIONS[watchValue.__type].isNumeric, "Only numeric types can be watched: " .. table.show(watchValue, ""))
+		watchType, watchSize = watchValue.__type, 0
+	end
+
+	local id, message = watchMemory(this.__nativeObject, address, offset, watchType, watchSize, callback, interval)
+	assert(id, message)
+	return id
+end
+
+-- with no id, everything is unwatched
+function Process:unwatchMemory(id)
+	local this = type(self) == 'table' and self or Process.new(self)
+	return unwatchMemory(this.__nativeObject, id or 0)
+end
+
 TYPE_MODE_LOOSE = 1
 TYPE_MODE_TIGHT = 2
 TYPE_MODE_EXACT = 3
@@ -231,7 +433,17 @@ function Process:scanFor(scanValue, scanComparator, typeMode)
 		raw_scanType = 0
 		raw_scanTypeMode = typeModeMap[type(scanValue)][typeMode]
 	elseif type(scanValue) == "table" then
-		if (scanValue.__schema) then
+		if (scanValue.__pattern) then
+			--[[
+				It's a byte pattern, like "48 8B ?? ?? 89".
+				These either match or they don't.
+			]]
+			assert(scanComparator == SCAN_COMPARE_EQUALS, "Byte patterns can only be scanned using SCAN_COMPARE_EQUALS")
+
+			raw_scanValue = {value = scanValue.__pattern}
+			raw_scanType = SCAN_VARIANT_PATTERN
+			raw_scanTypeMode = SCAN_INFER_TYPE_EXACT
+		elseif (scanValue.__schema) then
 			--[[
 				It's a structure of specific primitive types.
 				Only exact scans and comparisons are allowed.
@@ -268,6 +480,13 @@ function Process:scanFor(scanValue, scanComparator, typeMode)
 	return success, message
 end
 
+-- a byte pattern (array of bytes) to scan for, like "48 8B ?? ?? 89 4?". each byte
+-- is two hex digits, and either digit (or the whole byte, as "?") can be a wildcard
+function pattern(bytes)
+	assert(type(bytes) == 'string', "Byte patterns must be strings, like \"48 8B ?? ?? 89\"")
+	return {__pattern = bytes}
+end
+
 function array(input, len)
 	local msg = "Can only make an array out of strongly-typed objects"
 	assert(type(input) == 'table', msg)